@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "Geode/loader/Event.hpp"
+
+#include "platform.hpp"
+
+namespace jukebox {
+
+class Transaction;
+
+namespace event {
+
+/**
+ * Posted once after a Transaction is committed, instead of the per-song
+ * SongStateChanged / NongDeleted events. Also posted after a failed commit
+ * was rolled back, listeners should rebuild from the manager either way.
+ *
+ * Listen to it with an EventListener<EventFilter<BatchCommitted>> to follow
+ * the commits made by any mod.
+ */
+class JUKEBOX_DLL BatchCommitted final : public geode::Event {
+private:
+    std::vector<int> m_songIDs;
+    bool m_rolledBack;
+
+protected:
+    friend class ::jukebox::Transaction;
+
+    BatchCommitted(std::vector<int> songIDs, bool rolledBack = false);
+
+public:
+    const std::vector<int>& songIDs() const;
+    bool contains(int songID) const;
+    // Whether the commit failed and the song IDs were restored
+    bool rolledBack() const;
+};
+
+}  // namespace event
+
+}  // namespace jukebox
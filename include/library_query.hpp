@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "manifest_snapshot.hpp"
+#include "nong.hpp"
+#include "platform.hpp"
+
+namespace jukebox {
+
+/**
+ * Read-only view of one song inside a published snapshot. Keeps the entry
+ * it points into alive, so it stays valid after the manifest changes.
+ */
+class JUKEBOX_DLL SongView final {
+private:
+    std::shared_ptr<const NongsSnapshot> m_nongs;
+    // Position in NongsSnapshot::songs, nullopt for the default song
+    std::optional<size_t> m_index;
+
+public:
+    SongView(std::shared_ptr<const NongsSnapshot> nongs,
+             std::optional<size_t> index)
+        : m_nongs(std::move(nongs)), m_index(index) {}
+
+    const NongsSnapshot& nongs() const { return *m_nongs; }
+    const SongSnapshot& song() const {
+        return m_index.has_value() ? m_nongs->songs[m_index.value()]
+                                   : m_nongs->defaultSong;
+    }
+
+    int gdSongID() const { return m_nongs->songID; }
+    bool isDefault() const { return !m_index.has_value(); }
+    bool isActive() const {
+        return m_nongs->active.metadata.uniqueID == song().metadata.uniqueID;
+    }
+};
+
+/**
+ * One page of query results
+ */
+struct JUKEBOX_DLL LibraryPage final {
+    std::vector<SongView> songs;
+    // Number of matches before paging
+    size_t total = 0;
+    size_t offset = 0;
+    // Manifest version the page was computed from
+    uint64_t version = 0;
+};
+
+/**
+ * Builds a query over every stored song. Filters are ANDed together. Type,
+ * index, artist and download filters are served from secondary indexes, so
+ * only song IDs that can match are looked at.
+ *
+ * Queries run against the latest published snapshot and can be run from
+ * any thread.
+ */
+class JUKEBOX_DLL LibraryQuery final {
+public:
+    enum class SortKey { GDSongID, Name, Artist, FileSize };
+
+    using Predicate = std::function<bool(const SongView&)>;
+
+private:
+    std::optional<NongType> m_type;
+    std::optional<std::string> m_indexID;
+    std::optional<std::string> m_artist;
+    std::optional<bool> m_downloaded;
+    std::optional<int> m_songID;
+    bool m_includeDefaults = false;
+    std::vector<Predicate> m_predicates;
+
+    SortKey m_sortKey = SortKey::GDSongID;
+    bool m_descending = false;
+    size_t m_offset = 0;
+    std::optional<size_t> m_limit;
+
+    std::vector<SongView> collect(uint64_t& version) const;
+
+public:
+    LibraryQuery& type(NongType type);
+    LibraryQuery& index(const std::string& indexID);
+    // Case insensitive, matches the whole artist name
+    LibraryQuery& artist(const std::string& artist);
+    LibraryQuery& downloaded(bool downloaded);
+    LibraryQuery& songID(int gdSongID);
+    // Whether default songs are part of the results, off by default
+    LibraryQuery& includeDefaults(bool include = true);
+    // Arbitrary filter, applied after the indexed ones
+    LibraryQuery& where(Predicate predicate);
+
+    LibraryQuery& sortBy(SortKey key, bool descending = false);
+    LibraryQuery& offset(size_t offset);
+    LibraryQuery& limit(size_t limit);
+
+    LibraryPage run() const;
+    // Number of matches, ignoring sorting and paging
+    size_t count() const;
+};
+
+}  // namespace jukebox
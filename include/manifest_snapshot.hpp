@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nong.hpp"
+#include "platform.hpp"
+
+namespace jukebox {
+
+/**
+ * Immutable copy of a song's state, safe to read from any thread
+ */
+struct JUKEBOX_DLL SongSnapshot final {
+    NongType type;
+    SongMetadata metadata;
+    std::optional<std::string> indexID;
+    std::optional<std::filesystem::path> path;
+    // Size of the audio file when it was published, nullopt if missing
+    std::optional<uintmax_t> fileSize;
+
+    bool downloaded() const { return fileSize.has_value(); }
+
+    // Size of a file, nullopt if it's missing
+    using SizeLookup =
+        std::function<std::optional<uintmax_t>(const std::filesystem::path&)>;
+
+    static SongSnapshot from(const Song& song);
+    /**
+     * Takes file sizes from sizeOf instead of the disk, for callers that
+     * already stat'd every file in one batch
+     */
+    static SongSnapshot from(const Song& song, const SizeLookup& sizeOf);
+};
+
+/**
+ * Immutable copy of a Nongs object at the time it was published
+ */
+struct JUKEBOX_DLL NongsSnapshot final {
+    int songID;
+    // Version of the manifest snapshot that published this entry
+    uint64_t version;
+    SongSnapshot defaultSong;
+    SongSnapshot active;
+    // Every stored song except the default one
+    std::vector<SongSnapshot> songs;
+
+    static std::shared_ptr<const NongsSnapshot> from(const Nongs& nongs,
+                                                     uint64_t version);
+    static std::shared_ptr<const NongsSnapshot> from(
+        const Nongs& nongs, uint64_t version,
+        const SongSnapshot::SizeLookup& sizeOf);
+};
+
+/**
+ * Versioned, read-only view of the whole manifest. A new snapshot is
+ * published after every change, sharing the entries of song IDs that didn't
+ * change with the previous one. Holding on to a snapshot keeps it alive, so
+ * background work can read it for as long as it needs.
+ */
+class JUKEBOX_DLL ManifestSnapshot final {
+public:
+    using Entries =
+        std::unordered_map<int, std::shared_ptr<const NongsSnapshot>>;
+
+private:
+    uint64_t m_version = 0;
+    Entries m_nongs;
+
+public:
+    ManifestSnapshot() = default;
+    ManifestSnapshot(uint64_t version, Entries nongs)
+        : m_version(version), m_nongs(std::move(nongs)) {}
+
+    uint64_t version() const { return m_version; }
+    const Entries& nongs() const { return m_nongs; }
+    size_t size() const { return m_nongs.size(); }
+
+    std::shared_ptr<const NongsSnapshot> find(int songID) const {
+        auto it = m_nongs.find(songID);
+        if (it == m_nongs.end()) {
+            return nullptr;
+        }
+        return it->second;
+    }
+};
+
+}  // namespace jukebox
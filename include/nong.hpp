@@ -15,6 +15,7 @@
 #include "Geode/utils/general.hpp"
 #include "index.hpp"
 #include "platform.hpp"
+#include "song_path.hpp"
 
 namespace jukebox {
 
@@ -55,6 +56,8 @@ public:
     virtual void setIndexID(const std::string& id) = 0;
     // For local songs, this will always have a value, otherwise do check
     virtual std::optional<std::filesystem::path> path() const = 0;
+    // Same location as path(), nullptr when there is none
+    virtual const SongPath* songPath() const = 0;
 };
 
 class JUKEBOX_DLL LocalSong final : public Song {
@@ -65,6 +68,7 @@ private:
 
 public:
     LocalSong(SongMetadata&& metadata, const std::filesystem::path& path);
+    LocalSong(SongMetadata&& metadata, SongPath path);
 
     LocalSong(const LocalSong& other);
     LocalSong& operator=(const LocalSong& other);
@@ -77,6 +81,7 @@ public:
     NongType type() const { return NongType::LOCAL; };
     SongMetadata* metadata() const;
     std::optional<std::filesystem::path> path() const;
+    const SongPath* songPath() const;
     std::optional<std::string> indexID() const { return std::nullopt; }
     void setIndexID(const std::string& id) {}
 
@@ -94,6 +99,8 @@ public:
     YTSong(SongMetadata&& metadata, std::string youtubeID,
            std::optional<std::string> m_indexID,
            std::optional<std::filesystem::path> path = std::nullopt);
+    YTSong(SongMetadata&& metadata, std::string youtubeID,
+           std::optional<std::string> m_indexID, SongPath path);
     YTSong(const YTSong& other);
     YTSong& operator=(const YTSong& other);
 
@@ -108,6 +115,7 @@ public:
     std::optional<std::string> indexID() const;
     void setIndexID(const std::string& id);
     std::optional<std::filesystem::path> path() const;
+    const SongPath* songPath() const;
     geode::Result<geode::Task<geode::Result<geode::ByteVector>, float>>
     startDownload();
 };
@@ -122,6 +130,8 @@ public:
     HostedSong(SongMetadata&& metadata, std::string url,
                std::optional<std::string> m_indexID,
                std::optional<std::filesystem::path> path = std::nullopt);
+    HostedSong(SongMetadata&& metadata, std::string url,
+               std::optional<std::string> m_indexID, SongPath path);
     HostedSong(const HostedSong& other);
     HostedSong& operator=(const HostedSong& other);
 
@@ -136,6 +146,7 @@ public:
     std::optional<std::string> indexID() const;
     void setIndexID(const std::string& id);
     std::optional<std::filesystem::path> path() const;
+    const SongPath* songPath() const;
     geode::Result<geode::Task<geode::Result<geode::ByteVector>, float>>
     startDownload();
 };
@@ -172,6 +183,11 @@ public:
      */
     geode::Result<> setActive(const std::string& uniqueID);
     geode::Result<> merge(Nongs&&);
+    /**
+     * Takes over the state of other NONGs of the same song ID. Songs present
+     * in both keep their objects, so pointers to them stay valid.
+     */
+    geode::Result<> restore(Nongs&&);
     // Remove all custom nongs and set the default song as active
     geode::Result<> deleteAllSongs();
     geode::Result<> deleteSong(const std::string& uniqueID, bool audio = true);
@@ -11,6 +11,47 @@
 #include "Geode/utils/string.hpp"
 
 #include "nong.hpp"
+#include "song_path.hpp"
+
+template <>
+struct matjson::Serialize<jukebox::SongPath> {
+    /**
+     * Reads the "path" and "path_root" keys of a song. Manifests from before
+     * path roots existed only store a full path, which gets split up here.
+     */
+    static geode::Result<jukebox::SongPath> fromJson(
+        const matjson::Value& value) {
+        if (!value["path"].isString()) {
+            return geode::Err("invalid path");
+        }
+        std::string path = value["path"].asString().unwrap();
+
+        if (!value.contains("path_root")) {
+#ifdef GEODE_IS_WINDOWS
+            return geode::Ok(jukebox::SongPath::fromAbsolute(
+                geode::utils::string::utf8ToWide(path)));
+#else
+            return geode::Ok(jukebox::SongPath::fromAbsolute(path));
+#endif
+        }
+
+        std::optional<jukebox::PathRoot> root =
+            jukebox::SongPath::rootFromName(
+                value["path_root"].asString().unwrapOr(""));
+        if (!root.has_value()) {
+            return geode::Err("invalid path root");
+        }
+        return geode::Ok(jukebox::SongPath{root.value(), std::move(path)});
+    }
+
+    static void writeInto(const jukebox::SongPath& path,
+                          matjson::Value& value) {
+        value["path"] = path.relative();
+        if (path.root() != jukebox::PathRoot::External) {
+            value["path_root"] = jukebox::SongPath::rootName(path.root());
+        }
+    }
+};
 
 template <>
 struct matjson::Serialize<jukebox::SongMetadata> {
@@ -51,29 +92,28 @@ struct matjson::Serialize<jukebox::LocalSong> {
                                        err);
                 }));
 
-        if (!value["path"].isString()) {
-            return geode::Err("Local Song {} is invalid. Reason: invalid path",
-                              value.dump(matjson::NO_INDENTATION));
-        }
+        GEODE_UNWRAP_INTO(
+            jukebox::SongPath path,
+            matjson::Serialize<jukebox::SongPath>::fromJson(value).mapErr(
+                [value](std::string err) {
+                    return fmt::format("Local Song {} is invalid. Reason: {}",
+                                       value.dump(matjson::NO_INDENTATION),
+                                       err);
+                }));
 
-        return geode::Ok(jukebox::LocalSong{std::move(metadata),
-                                            value["path"].asString().unwrap()});
+        return geode::Ok(
+            jukebox::LocalSong{std::move(metadata), std::move(path)});
     }
 
     static matjson::Value toJson(const jukebox::LocalSong& value) {
-#ifdef GEODE_IS_WINDOWS
-        std::string path =
-            geode::utils::string::wideToUtf8(value.path().value().wstring());
-#else
-        std::string path = value.path().value().string();
-#endif
         matjson::Value ret = matjson::makeObject({
             {"name", value.metadata()->name},
             {"unique_id", value.metadata()->uniqueID},
             {"artist", value.metadata()->artist},
-            {"path", path},
             {"offset", value.metadata()->startOffset},
         });
+        matjson::Serialize<jukebox::SongPath>::writeInto(*value.songPath(),
+                                                         ret);
         if (value.metadata()->level.has_value()) {
             ret["level"] = value.metadata()->level.value();
         }
@@ -94,11 +134,14 @@ struct matjson::Serialize<jukebox::YTSong> {
                                        err);
                 }));
 
-        if (!value["path"].isString()) {
-            return geode::Err(
-                "YouTube song {} is invalid. Reason: invalid path",
-                value.dump(matjson::NO_INDENTATION));
-        }
+        GEODE_UNWRAP_INTO(
+            jukebox::SongPath path,
+            matjson::Serialize<jukebox::SongPath>::fromJson(value).mapErr(
+                [value](std::string err) {
+                    return fmt::format("YouTube song {} is invalid. Reason: {}",
+                                       value.dump(matjson::NO_INDENTATION),
+                                       err);
+                }));
 
         if (!value["youtube_id"].isString()) {
             return geode::Err(
@@ -112,23 +155,19 @@ struct matjson::Serialize<jukebox::YTSong> {
                 .asString()
                 .map([](auto i) { return std::optional(i); })
                 .unwrapOr(std::nullopt),
-            value["path"].asString().unwrap()});
+            std::move(path)});
     }
 
     static matjson::Value toJson(const jukebox::YTSong& value) {
-#ifdef GEODE_IS_WINDOWS
-        std::string path =
-            geode::utils::string::wideToUtf8(value.path().value().wstring());
-#else
-        std::string path = value.path().value().string();
-#endif
         matjson::Value ret =
             matjson::makeObject({{"name", value.metadata()->name},
                                  {"unique_id", value.metadata()->uniqueID},
                                  {"artist", value.metadata()->artist},
-                                 {"path", path},
                                  {"offset", value.metadata()->startOffset},
                                  {"youtube_id", value.youtubeID()}});
+        if (const jukebox::SongPath* path = value.songPath()) {
+            matjson::Serialize<jukebox::SongPath>::writeInto(*path, ret);
+        }
         if (value.indexID().has_value()) {
             ret["index_id"] = value.indexID().value();
         }
@@ -153,10 +192,14 @@ struct matjson::Serialize<jukebox::HostedSong> {
                                        err);
                 }));
 
-        if (!value["path"].isString()) {
-            return geode::Err("Hosted song {} is invalid. Reason: invalid path",
-                              value.dump(matjson::NO_INDENTATION));
-        }
+        GEODE_UNWRAP_INTO(
+            jukebox::SongPath path,
+            matjson::Serialize<jukebox::SongPath>::fromJson(value).mapErr(
+                [value](std::string err) {
+                    return fmt::format("Hosted song {} is invalid. Reason: {}",
+                                       value.dump(matjson::NO_INDENTATION),
+                                       err);
+                }));
 
         if (!value["url"].isString()) {
             return geode::Err("Hosted song {} is invalid. Reason: invalid url",
@@ -169,23 +212,19 @@ struct matjson::Serialize<jukebox::HostedSong> {
                 .asString()
                 .map([](auto i) { return std::optional(i); })
                 .unwrapOr(std::nullopt),
-            value["path"].asString().unwrap()});
+            std::move(path)});
     }
 
     static matjson::Value toJson(const jukebox::HostedSong& value) {
-#ifdef GEODE_IS_WINDOWS
-        std::string path =
-            geode::utils::string::wideToUtf8(value.path().value().wstring());
-#else
-        std::string path = value.path().value().string();
-#endif
         matjson::Value ret =
             matjson::makeObject({{"name", value.metadata()->name},
                                  {"unique_id", value.metadata()->uniqueID},
                                  {"artist", value.metadata()->artist},
-                                 {"path", path},
                                  {"offset", value.metadata()->startOffset},
                                  {"url", value.url()}});
+        if (const jukebox::SongPath* path = value.songPath()) {
+            matjson::Serialize<jukebox::SongPath>::writeInto(*path, ret);
+        }
         if (value.indexID().has_value()) {
             ret["index_id"] = value.indexID();
         }
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "platform.hpp"
+
+namespace jukebox {
+
+/**
+ * Directories song files are stored relative to
+ */
+enum class PathRoot : uint8_t {
+    // Jukebox's own nongs folder in the save directory
+    Nongs,
+    // Where GD keeps downloaded songs
+    Songs,
+    // GD's Resources folder, for RobTop songs
+    Resources,
+    // Anything else, stored as a full path
+    External,
+};
+
+/**
+ * A song file location stored as a root and a path relative to it, so the
+ * manifest doesn't break when the save directory moves. The full UTF-8 path
+ * is only built once and then reused until a root changes.
+ *
+ * Not thread safe, copy absolute() out if the path is needed elsewhere.
+ */
+class JUKEBOX_DLL SongPath final {
+private:
+    PathRoot m_root = PathRoot::External;
+    // UTF-8, always uses '/' as the separator
+    std::string m_relative;
+
+    mutable std::string m_utf8;
+    mutable uint32_t m_generation = 0;
+
+public:
+    SongPath() = default;
+    SongPath(PathRoot root, std::string relative);
+
+    /**
+     * Splits an absolute path into the managed root it's in and the rest.
+     * Falls back to PathRoot::External.
+     */
+    static SongPath fromAbsolute(const std::filesystem::path& path);
+
+    /**
+     * Sets the directory of a root. Cached paths are rebuilt on next use.
+     */
+    static void setRoot(PathRoot root, const std::filesystem::path& path);
+    static const std::string& rootPath(PathRoot root);
+
+    static const char* rootName(PathRoot root);
+    static std::optional<PathRoot> rootFromName(const std::string& name);
+
+    PathRoot root() const { return m_root; }
+    const std::string& relative() const { return m_relative; }
+
+    // Full path, UTF-8 encoded
+    const std::string& utf8() const;
+    std::filesystem::path absolute() const;
+
+    bool operator==(const SongPath& other) const {
+        return m_root == other.m_root && m_relative == other.m_relative;
+    }
+};
+
+}  // namespace jukebox
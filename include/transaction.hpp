@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "Geode/Result.hpp"
+
+#include "batch_committed.hpp"
+#include "nong.hpp"
+#include "platform.hpp"
+
+namespace jukebox {
+
+/**
+ * Batches mutations across any number of song IDs into a single commit.
+ *
+ * Mutations are only queued until commit() is called. They are then applied
+ * in order, each touched song ID is written once, and a single
+ * event::BatchCommitted is posted. If any mutation fails, every touched song
+ * ID is restored to its previous state, nothing is written and the event is
+ * posted with rolledBack() set. Audio files are only deleted once the whole
+ * batch succeeded.
+ *
+ * A transaction that is destroyed without being committed does nothing.
+ */
+class JUKEBOX_DLL Transaction final {
+private:
+    class Impl;
+
+    std::unique_ptr<Impl> m_impl;
+
+public:
+    Transaction();
+
+    Transaction(const Transaction&) = delete;
+    Transaction& operator=(const Transaction&) = delete;
+
+    Transaction(Transaction&&);
+    Transaction& operator=(Transaction&&);
+
+    ~Transaction();
+
+    Transaction& setActive(int gdSongID, const std::string& uniqueID);
+    Transaction& deleteSong(int gdSongID, const std::string& uniqueID,
+                            bool audio = true);
+    Transaction& deleteSongAudio(int gdSongID, const std::string& uniqueID);
+    // Remove all custom nongs and set the default song as active
+    Transaction& deleteAllSongs(int gdSongID);
+    Transaction& addNongs(Nongs&& nongs);
+
+    // Number of queued mutations
+    size_t size() const;
+
+    /**
+     * Applies all queued mutations. Returns Err (and leaves the manifest
+     * untouched) if any of them failed.
+     */
+    geode::Result<> commit();
+
+    // Drops all queued mutations
+    void rollback();
+};
+
+}  // namespace jukebox
@@ -0,0 +1,23 @@
+#include "batch_committed.hpp"
+
+#include <algorithm>
+
+namespace jukebox {
+
+namespace event {
+
+BatchCommitted::BatchCommitted(std::vector<int> songIDs, bool rolledBack)
+    : m_songIDs(std::move(songIDs)), m_rolledBack(rolledBack) {}
+
+const std::vector<int>& BatchCommitted::songIDs() const { return m_songIDs; }
+
+bool BatchCommitted::rolledBack() const { return m_rolledBack; }
+
+bool BatchCommitted::contains(int songID) const {
+    return std::find(m_songIDs.begin(), m_songIDs.end(), songID) !=
+           m_songIDs.end();
+}
+
+}  // namespace event
+
+}  // namespace jukebox
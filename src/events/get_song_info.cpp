@@ -10,4 +10,18 @@ std::string GetSongInfo::songName() { return m_songName; }
 std::string GetSongInfo::artistName() { return m_artistName; }
 int GetSongInfo::gdSongID() { return m_gdSongID; }
 
+SongKey GetSongInfo::songKey() const {
+    return SongKey{m_gdSongID, ""};
+}
+
+geode::ListenerResult GetSongInfo::post() {
+    // NongManager updates the default song first, and stops the event when
+    // there was nothing to update
+    if (geode::Event::post() == geode::ListenerResult::Stop) {
+        return geode::ListenerResult::Stop;
+    }
+    SongDispatcher<GetSongInfo>::get().post(this);
+    return geode::ListenerResult::Propagate;
+}
+
 }  // namespace jukebox::event
@@ -4,6 +4,7 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
 #include "hooks/music_download_manager.hpp"
 
 namespace jukebox {
@@ -25,6 +26,9 @@ public:
     std::string songName();
     std::string artistName();
     int gdSongID();
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
@@ -0,0 +1,22 @@
+#include "events/link_probed.hpp"
+
+namespace jukebox {
+
+namespace event {
+
+LinkProbed::LinkProbed(int gdSongId, std::string uniqueId, std::string url)
+    : m_gdSongId(gdSongId), m_uniqueId(uniqueId), m_url(url) {}
+int LinkProbed::gdSongId() const { return m_gdSongId; }
+std::string LinkProbed::uniqueId() const { return m_uniqueId; }
+std::string LinkProbed::url() const { return m_url; }
+
+SongKey LinkProbed::songKey() const { return SongKey{m_gdSongId, m_uniqueId}; }
+
+geode::ListenerResult LinkProbed::post() {
+    SongDispatcher<LinkProbed>::get().post(this);
+    return geode::Event::post();
+}
+
+}  // namespace event
+
+}  // namespace jukebox
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+#include "Geode/loader/Event.hpp"
+
+#include "events/song_dispatcher.hpp"
+
+namespace jukebox {
+
+namespace event {
+
+/**
+ * The link of an index song was checked, LinkProber::find() has the result
+ */
+class LinkProbed final : public geode::Event {
+private:
+    int m_gdSongId;
+    std::string m_uniqueId;
+    std::string m_url;
+
+public:
+    LinkProbed(int gdSongId, std::string uniqueId, std::string url);
+    int gdSongId() const;
+    std::string uniqueId() const;
+    std::string url() const;
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
+};
+
+}  // namespace event
+
+}  // namespace jukebox
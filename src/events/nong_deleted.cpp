@@ -10,6 +10,15 @@ NongDeleted::NongDeleted(const std::string& uniqueId, int gdId)
 std::string NongDeleted::uniqueId() const { return m_uniqueId; }
 int NongDeleted::gdId() const { return m_gdId; }
 
+SongKey NongDeleted::songKey() const {
+    return SongKey{m_gdId, m_uniqueId};
+}
+
+geode::ListenerResult NongDeleted::post() {
+    SongDispatcher<NongDeleted>::get().post(this);
+    return geode::Event::post();
+}
+
 }  // namespace event
 
 }  // namespace jukebox
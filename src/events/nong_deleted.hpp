@@ -2,6 +2,7 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
 #include "nong.hpp"
 
 namespace jukebox {
@@ -20,6 +21,9 @@ protected:
 public:
     std::string uniqueId() const;
     int gdId() const;
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
@@ -0,0 +1,35 @@
+#include "events/song_dispatcher.hpp"
+
+#include <functional>
+#include <utility>
+
+namespace jukebox {
+
+namespace event {
+
+SongSubscription::SongSubscription(std::function<void()> unsubscribe)
+    : m_unsubscribe(std::move(unsubscribe)) {}
+
+SongSubscription::SongSubscription(SongSubscription&& other) noexcept
+    : m_unsubscribe(std::exchange(other.m_unsubscribe, nullptr)) {}
+
+SongSubscription& SongSubscription::operator=(
+    SongSubscription&& other) noexcept {
+    if (this != &other) {
+        this->reset();
+        m_unsubscribe = std::exchange(other.m_unsubscribe, nullptr);
+    }
+    return *this;
+}
+
+SongSubscription::~SongSubscription() { this->reset(); }
+
+void SongSubscription::reset() {
+    if (m_unsubscribe) {
+        std::exchange(m_unsubscribe, nullptr)();
+    }
+}
+
+}  // namespace event
+
+}  // namespace jukebox
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jukebox {
+
+namespace event {
+
+/**
+ * What a song event is about. An empty unique ID means the event concerns
+ * the song ID as a whole, e.g. its active song changed.
+ */
+struct SongKey {
+    int songID;
+    std::string uniqueID;
+};
+
+/**
+ * Keeps a keyed subscription alive, unsubscribes when destroyed
+ */
+class SongSubscription final {
+private:
+    std::function<void()> m_unsubscribe;
+
+public:
+    SongSubscription() = default;
+    explicit SongSubscription(std::function<void()> unsubscribe);
+    SongSubscription(SongSubscription&& other) noexcept;
+    SongSubscription& operator=(SongSubscription&& other) noexcept;
+    SongSubscription(const SongSubscription&) = delete;
+    SongSubscription& operator=(const SongSubscription&) = delete;
+    ~SongSubscription();
+
+    void reset();
+    bool active() const { return static_cast<bool>(m_unsubscribe); }
+};
+
+/**
+ * Delivers song events straight to the listeners of that song, instead of
+ * every live listener filtering for its own ID. Subscribers with a unique
+ * ID only get events for that song, the others get every event of the
+ * song ID.
+ *
+ * Events post here from their own post(), so regular geode listeners keep
+ * working. Main thread only.
+ */
+template <class E>
+class SongDispatcher final {
+public:
+    using Callback = std::function<void(E*)>;
+
+private:
+    struct Entry {
+        uint64_t id;
+        Callback callback;
+        // Cleared on unsubscribe, so an event being dispatched skips
+        // listeners removed by an earlier callback
+        bool alive = true;
+    };
+    using Entries = std::vector<std::shared_ptr<Entry>>;
+
+    struct Bucket {
+        Entries any;
+        std::unordered_map<std::string, Entries> byUniqueID;
+
+        bool empty() const { return any.empty() && byUniqueID.empty(); }
+    };
+
+    std::unordered_map<int, Bucket> m_buckets;
+    uint64_t m_nextID = 0;
+
+    SongDispatcher() = default;
+
+    void unsubscribe(int songID, const std::string& uniqueID, uint64_t id) {
+        auto bucket = m_buckets.find(songID);
+        if (bucket == m_buckets.end()) {
+            return;
+        }
+
+        auto remove = [id](Entries& entries) {
+            std::erase_if(entries, [id](const std::shared_ptr<Entry>& entry) {
+                if (entry->id != id) {
+                    return false;
+                }
+                entry->alive = false;
+                return true;
+            });
+        };
+
+        if (uniqueID.empty()) {
+            remove(bucket->second.any);
+        } else if (auto entries = bucket->second.byUniqueID.find(uniqueID);
+                   entries != bucket->second.byUniqueID.end()) {
+            remove(entries->second);
+            if (entries->second.empty()) {
+                bucket->second.byUniqueID.erase(entries);
+            }
+        }
+
+        if (bucket->second.empty()) {
+            m_buckets.erase(bucket);
+        }
+    }
+
+public:
+    static SongDispatcher& get() {
+        static SongDispatcher instance;
+        return instance;
+    }
+
+    SongDispatcher(const SongDispatcher&) = delete;
+    SongDispatcher& operator=(const SongDispatcher&) = delete;
+
+    [[nodiscard]] SongSubscription subscribe(SongKey key, Callback callback) {
+        const uint64_t id = m_nextID++;
+        auto entry = std::make_shared<Entry>(Entry{id, std::move(callback)});
+
+        Bucket& bucket = m_buckets[key.songID];
+        if (key.uniqueID.empty()) {
+            bucket.any.push_back(std::move(entry));
+        } else {
+            bucket.byUniqueID[key.uniqueID].push_back(std::move(entry));
+        }
+
+        return SongSubscription([key = std::move(key), id]() {
+            SongDispatcher::get().unsubscribe(key.songID, key.uniqueID, id);
+        });
+    }
+
+    [[nodiscard]] SongSubscription subscribe(int songID, Callback callback) {
+        return this->subscribe(SongKey{songID, ""}, std::move(callback));
+    }
+
+    void post(E* event) {
+        const SongKey key = event->songKey();
+        auto bucket = m_buckets.find(key.songID);
+        if (bucket == m_buckets.end()) {
+            return;
+        }
+
+        // Copied, callbacks may subscribe or unsubscribe
+        Entries targets = bucket->second.any;
+        if (key.uniqueID.empty()) {
+            for (auto& [uniqueID, entries] : bucket->second.byUniqueID) {
+                targets.insert(targets.end(), entries.begin(), entries.end());
+            }
+        } else if (auto entries = bucket->second.byUniqueID.find(key.uniqueID);
+                   entries != bucket->second.byUniqueID.end()) {
+            targets.insert(targets.end(), entries->second.begin(),
+                           entries->second.end());
+        }
+
+        for (const std::shared_ptr<Entry>& entry : targets) {
+            if (entry->alive) {
+                entry->callback(event);
+            }
+        }
+    }
+};
+
+}  // namespace event
+
+}  // namespace jukebox
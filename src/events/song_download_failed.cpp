@@ -11,6 +11,15 @@ int SongDownloadFailed::gdSongId() const { return m_gdSongId; }
 std::string SongDownloadFailed::uniqueId() const { return m_uniqueId; }
 std::string SongDownloadFailed::error() const { return m_error; }
 
+SongKey SongDownloadFailed::songKey() const {
+    return SongKey{m_gdSongId, m_uniqueId};
+}
+
+geode::ListenerResult SongDownloadFailed::post() {
+    SongDispatcher<SongDownloadFailed>::get().post(this);
+    return geode::Event::post();
+}
+
 }  // namespace event
 
 }  // namespace jukebox
@@ -4,6 +4,8 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
+
 namespace jukebox {
 
 namespace event {
@@ -19,6 +21,9 @@ public:
     int gdSongId() const;
     std::string uniqueId() const;
     std::string error() const;
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
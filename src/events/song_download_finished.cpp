@@ -19,6 +19,16 @@ std::optional<IndexSongMetadata*> SongDownloadFinished::indexSource() {
 }
 Song* SongDownloadFinished::destination() { return m_destination; }
 
+SongKey SongDownloadFinished::songKey() const {
+    return SongKey{m_destination->metadata()->gdID,
+                   m_destination->metadata()->uniqueID};
+}
+
+geode::ListenerResult SongDownloadFinished::post() {
+    SongDispatcher<SongDownloadFinished>::get().post(this);
+    return geode::Event::post();
+}
+
 }  // namespace event
 
 }  // namespace jukebox
@@ -4,6 +4,7 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
 #include "index.hpp"
 #include "managers/index_manager.hpp"
 #include "nong.hpp"
@@ -25,6 +26,9 @@ protected:
 public:
     std::optional<index::IndexSongMetadata*> indexSource();
     Song* destination();
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
@@ -12,6 +12,15 @@ int SongDownloadProgress::gdSongID() { return m_gdSongID; }
 std::string SongDownloadProgress::uniqueID() { return m_uniqueID; }
 float SongDownloadProgress::progress() { return m_progress; }
 
+SongKey SongDownloadProgress::songKey() const {
+    return SongKey{m_gdSongID, m_uniqueID};
+}
+
+geode::ListenerResult SongDownloadProgress::post() {
+    SongDispatcher<SongDownloadProgress>::get().post(this);
+    return geode::Event::post();
+}
+
 }  // namespace event
 
 }  // namespace jukebox
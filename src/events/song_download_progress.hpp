@@ -4,6 +4,7 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
 #include "managers/index_manager.hpp"
 #include "managers/nong_manager.hpp"
 
@@ -27,6 +28,9 @@ public:
     int gdSongID();
     std::string uniqueID();
     float progress();
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
@@ -8,6 +8,15 @@ SongStateChanged::SongStateChanged(Nongs* nongs) : m_nongs(nongs) {};
 
 Nongs* SongStateChanged::nongs() const { return m_nongs; };
 
+SongKey SongStateChanged::songKey() const {
+    return SongKey{m_nongs->songID(), ""};
+}
+
+geode::ListenerResult SongStateChanged::post() {
+    SongDispatcher<SongStateChanged>::get().post(this);
+    return geode::Event::post();
+}
+
 }  // namespace event
 
 }  // namespace jukebox
@@ -2,6 +2,7 @@
 
 #include "Geode/loader/Event.hpp"
 
+#include "events/song_dispatcher.hpp"
 #include "nong.hpp"
 
 namespace jukebox {
@@ -15,6 +16,9 @@ private:
 public:
     SongStateChanged(Nongs* nongs);
     Nongs* nongs() const;
+
+    SongKey songKey() const;
+    geode::ListenerResult post();
 };
 
 }  // namespace event
@@ -0,0 +1,22 @@
+#include "Geode/binding/AppDelegate.hpp"
+#include "Geode/modify/AppDelegate.hpp"  // IWYU pragma: keep
+#include "Geode/modify/Modify.hpp"
+
+#include "managers/executor.hpp"
+
+using namespace geode::prelude;
+using namespace jukebox;
+
+class $modify(AppDelegate) {
+    // GD saves when it closes and when it goes to the background, the
+    // workers are stopped while the game can still wait for them
+    void trySaveGame(bool p0) {
+        AppDelegate::trySaveGame(p0);
+        Executor::get().shutdown();
+    }
+
+    void applicationWillEnterForeground() {
+        AppDelegate::applicationWillEnterForeground();
+        Executor::get().start();
+    }
+};
@@ -1,10 +1,12 @@
 #include <memory>
 #include <optional>
 #include <sstream>
+#include <vector>
 
 #include "Geode/binding/CCMenuItemSpriteExtra.hpp"
 #include "Geode/binding/CustomSongWidget.hpp"
 #include "Geode/binding/GameManager.hpp"
+#include "Geode/binding/GJGameLevel.hpp"
 #include "Geode/binding/SongInfoObject.hpp"
 #include "Geode/cocos/cocoa/CCGeometry.h"
 #include "Geode/cocos/cocoa/CCObject.h"
@@ -20,7 +22,12 @@
 #include "Geode/ui/Layout.hpp"
 #include "Geode/utils/cocos.hpp"
 
+#include "batch_committed.hpp"
+#include "events/song_dispatcher.hpp"
+#include "events/song_state_changed.hpp"
+#include "managers/audio_preloader.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
 #include "ui/nong_dropdown_layer.hpp"
 
 using namespace geode::prelude;
@@ -38,8 +45,20 @@ class $modify(JBSongWidget, CustomSongWidget) {
         bool searching = false;
         std::unordered_map<int, Nongs*> assetNongData;
         EventListener<NongManager::MultiAssetSizeTask> m_multiAssetListener;
-        std::unique_ptr<EventListener<EventFilter<event::SongStateChanged>>>
-            m_songStateListener;
+        // The size calculation in flight for this widget and what it's for
+        std::optional<NongManager::MultiAssetSizeTask> m_multiAssetTask;
+        std::string m_multiAssetKey;
+        event::SongSubscription m_songStateListener;
+        std::optional<int> m_songStateID;
+        std::unique_ptr<EventListener<EventFilter<event::BatchCommitted>>>
+            m_batchListener;
+
+        ~Fields() {
+            // Nobody is left to show the result
+            if (m_multiAssetTask.has_value()) {
+                m_multiAssetTask->cancel();
+            }
+        }
     };
 
     bool init(SongInfoObject* songInfo, CustomSongDelegate* songDelegate,
@@ -64,17 +83,21 @@ class $modify(JBSongWidget, CustomSongWidget) {
         this->setupJBSW();
         m_fields->firstRun = false;
 
-        m_fields->m_songStateListener = std::make_unique<
-            EventListener<EventFilter<event::SongStateChanged>>>(
-            ([this](event::SongStateChanged* event) {
-                if (!m_songInfoObject) {
+        m_fields->m_batchListener = std::make_unique<
+            EventListener<EventFilter<event::BatchCommitted>>>(
+            ([this](event::BatchCommitted* event) {
+                if (!m_songInfoObject ||
+                    !event->contains(m_songInfoObject->m_songID)) {
                     return ListenerResult::Propagate;
                 }
-                if (event->nongs()->songID() != m_songInfoObject->m_songID) {
+
+                std::optional<Nongs*> nongs =
+                    NongManager::get().getNongs(m_songInfoObject->m_songID);
+                if (!nongs.has_value()) {
                     return ListenerResult::Propagate;
                 }
 
-                Song* active = event->nongs()->active();
+                Song* active = nongs.value()->active();
 
                 m_songInfoObject->m_songName = active->metadata()->name;
                 m_songInfoObject->m_artistName = active->metadata()->artist;
@@ -136,6 +159,20 @@ class $modify(JBSongWidget, CustomSongWidget) {
             return;
         }
 
+        // A change to the manifest since supersedes the running job too
+        const std::string key =
+            fmt::format("{}|{}|{}", m_fields->songIds, m_fields->sfxIds,
+                        NongManager::get().snapshot()->version());
+        if (m_fields->m_multiAssetTask.has_value()) {
+            // Same assets still being calculated, keep waiting on that
+            if (m_fields->m_multiAssetKey == key &&
+                m_fields->m_multiAssetTask->isPending()) {
+                return;
+            }
+            // Superseded, stop it between files
+            m_fields->m_multiAssetTask->cancel();
+        }
+
         m_fields->m_multiAssetListener.bind(
             [this](NongManager::MultiAssetSizeTask::Event* e) {
                 if (!m_songIDLabel) {
@@ -148,9 +185,12 @@ class $modify(JBSongWidget, CustomSongWidget) {
                             .c_str());
                 }
             });
+
+        m_fields->m_multiAssetKey = key;
+        m_fields->m_multiAssetTask = NongManager::get().getMultiAssetSizes(
+            m_fields->songIds, m_fields->sfxIds);
         m_fields->m_multiAssetListener.setFilter(
-            NongManager::get().getMultiAssetSizes(m_fields->songIds,
-                                                  m_fields->sfxIds));
+            m_fields->m_multiAssetTask.value());
     }
 
     void restoreUI() {
@@ -170,11 +210,34 @@ class $modify(JBSongWidget, CustomSongWidget) {
         }
     }
 
+    void listenForSongState(int songID) {
+        if (m_fields->m_songStateID == songID) {
+            return;
+        }
+
+        m_fields->m_songStateID = songID;
+        m_fields->m_songStateListener =
+            event::SongDispatcher<event::SongStateChanged>::get().subscribe(
+                songID, [this](event::SongStateChanged* event) {
+                    if (!m_songInfoObject) {
+                        return;
+                    }
+
+                    Song* active = event->nongs()->active();
+
+                    m_songInfoObject->m_songName = active->metadata()->name;
+                    m_songInfoObject->m_artistName =
+                        active->metadata()->artist;
+                    this->updateSongInfo();
+                });
+    }
+
     void setupJBSW() {
         SongInfoObject* obj = m_songInfoObject;
         if (obj == nullptr) {
             return;
         }
+        this->listenForSongState(obj->m_songID);
         if (m_songs.size() != 0) {
             this->getMultiAssetSongInfo();
         }
@@ -313,7 +376,7 @@ class $modify(JBSongWidget, CustomSongWidget) {
             auto data = NongManager::get().getNongs(songID).value();
 
             // TODO this might be fuckery
-            if (!std::filesystem::exists(active->path().value()) &&
+            if (!SongPack::get().exists(active->path().value()) &&
                 nongs->isDefaultActive()) {
                 m_songIDLabel->setVisible(true);
                 geode::cocos::handleTouchPriority(this);
@@ -323,7 +386,7 @@ class $modify(JBSongWidget, CustomSongWidget) {
             }
 
             std::string sizeText;
-            if (std::filesystem::exists(active->path().value())) {
+            if (SongPack::get().exists(active->path().value())) {
                 sizeText =
                     NongManager::get().getFormattedSize(active->path().value());
             } else {
@@ -410,6 +473,24 @@ class $modify(JBLevelInfoLayer, LevelInfoLayer) {
             popup->m_scene = this;
             popup->show();
         }
+        this->preloadSongs(level);
         return true;
     }
+
+    void preloadSongs(GJGameLevel* level) {
+        std::vector<int> ids;
+        if (level->m_songID != 0) {
+            ids.push_back(level->m_songID);
+        } else {
+            ids.push_back((-level->m_audioTrack) - 1);
+        }
+        if (m_songWidget) {
+            for (const auto& kv : m_songWidget->m_songs) {
+                if (kv.first != level->m_songID) {
+                    ids.push_back(kv.first);
+                }
+            }
+        }
+        AudioPreloader::get().preload(ids);
+    }
 };
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+#include "Geode/modify/Addresser.hpp"
+#include "fmod.hpp"
+#include "fmod_common.h"
+
+#include "io/pack_archive.hpp"
+#include "managers/audio_preloader.hpp"
+#include "managers/song_pack.hpp"
+
+using namespace geode::prelude;
+using namespace jukebox;
+
+namespace {
+
+// Only plain file opens, GD's own memory and user callback opens are left
+// alone
+constexpr FMOD_MODE s_customOpen =
+    FMOD_OPENMEMORY | FMOD_OPENMEMORY_POINT | FMOD_OPENUSER | FMOD_OPENRAW;
+
+FMOD::Sound* openPreloaded(FMOD::System* self, const char* name,
+                           FMOD_MODE mode, FMOD_CREATESOUNDEXINFO* exinfo,
+                           bool stream) {
+    if (!name || exinfo || (mode & s_customOpen)) {
+        return nullptr;
+    }
+
+    PreloadCache::Buffer buffer = AudioPreloader::get().find(name);
+    if (!buffer) {
+        return nullptr;
+    }
+
+    FMOD_CREATESOUNDEXINFO info = {};
+    info.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
+    info.length = static_cast<unsigned int>(buffer->size());
+
+    // Calls from inside a hook go to the original function
+    FMOD::Sound* sound = nullptr;
+    const char* data = reinterpret_cast<const char*>(buffer->data());
+    FMOD_RESULT res =
+        stream ? self->createStream(data, mode | FMOD_OPENMEMORY_POINT, &info,
+                                    &sound)
+               : self->createSound(data, mode | FMOD_OPENMEMORY_POINT, &info,
+                                   &sound);
+    if (res != FMOD_OK || !sound) {
+        log::warn("Couldn't open preloaded {}, reading it from disk", name);
+        return nullptr;
+    }
+
+    AudioPreloader::get().retain(sound, std::move(buffer));
+    return sound;
+}
+
+// A packed song being read by FMOD
+struct PackedFile {
+    io::PackView view;
+    size_t position = 0;
+};
+
+FMOD_RESULT F_CALLBACK openPackedFile(const char* name, unsigned int* filesize,
+                                      void** handle, void*) {
+    std::optional<io::PackView> view = SongPack::get().find(name);
+    if (!view.has_value()) {
+        return FMOD_ERR_FILE_NOTFOUND;
+    }
+    *filesize = static_cast<unsigned int>(view->data.size());
+    *handle = new PackedFile{std::move(view.value())};
+    return FMOD_OK;
+}
+
+FMOD_RESULT F_CALLBACK closePackedFile(void* handle, void*) {
+    delete static_cast<PackedFile*>(handle);
+    return FMOD_OK;
+}
+
+FMOD_RESULT F_CALLBACK readPackedFile(void* handle, void* buffer,
+                                      unsigned int sizebytes,
+                                      unsigned int* bytesread, void*) {
+    PackedFile* file = static_cast<PackedFile*>(handle);
+    const size_t count = std::min<size_t>(
+        sizebytes, file->view.data.size() - file->position);
+    std::memcpy(buffer, file->view.data.data() + file->position, count);
+    file->position += count;
+    *bytesread = static_cast<unsigned int>(count);
+    return count < sizebytes ? FMOD_ERR_FILE_EOF : FMOD_OK;
+}
+
+FMOD_RESULT F_CALLBACK seekPackedFile(void* handle, unsigned int pos, void*) {
+    PackedFile* file = static_cast<PackedFile*>(handle);
+    if (pos > file->view.data.size()) {
+        return FMOD_ERR_FILE_COULDNOTSEEK;
+    }
+    file->position = pos;
+    return FMOD_OK;
+}
+
+FMOD::Sound* openPacked(FMOD::System* self, const char* name, FMOD_MODE mode,
+                        FMOD_CREATESOUNDEXINFO* exinfo, bool stream) {
+    if (!name || exinfo || (mode & s_customOpen) ||
+        !SongPack::get().enabled() || !SongPack::get().find(name)) {
+        return nullptr;
+    }
+
+    // FMOD reads through the callbacks, which look the name up again and
+    // keep the pack's mapping alive until the sound is released
+    FMOD_CREATESOUNDEXINFO info = {};
+    info.cbsize = sizeof(FMOD_CREATESOUNDEXINFO);
+    info.fileuseropen = &openPackedFile;
+    info.fileuserclose = &closePackedFile;
+    info.fileuserread = &readPackedFile;
+    info.fileuserseek = &seekPackedFile;
+
+    FMOD::Sound* sound = nullptr;
+    FMOD_RESULT res = stream ? self->createStream(name, mode, &info, &sound)
+                             : self->createSound(name, mode, &info, &sound);
+    if (res != FMOD_OK || !sound) {
+        log::warn("Couldn't open packed {}, reading it from disk", name);
+        return nullptr;
+    }
+    return sound;
+}
+
+FMOD_RESULT createStream(FMOD::System* self, const char* name, FMOD_MODE mode,
+                         FMOD_CREATESOUNDEXINFO* exinfo, FMOD::Sound** sound) {
+    if (FMOD::Sound* preloaded =
+            openPreloaded(self, name, mode, exinfo, true)) {
+        *sound = preloaded;
+        return FMOD_OK;
+    }
+    if (FMOD::Sound* packed = openPacked(self, name, mode, exinfo, true)) {
+        *sound = packed;
+        return FMOD_OK;
+    }
+    return self->createStream(name, mode, exinfo, sound);
+}
+
+FMOD_RESULT createSound(FMOD::System* self, const char* name, FMOD_MODE mode,
+                        FMOD_CREATESOUNDEXINFO* exinfo, FMOD::Sound** sound) {
+    if (FMOD::Sound* preloaded =
+            openPreloaded(self, name, mode, exinfo, false)) {
+        *sound = preloaded;
+        return FMOD_OK;
+    }
+    if (FMOD::Sound* packed = openPacked(self, name, mode, exinfo, false)) {
+        *sound = packed;
+        return FMOD_OK;
+    }
+    return self->createSound(name, mode, exinfo, sound);
+}
+
+FMOD_RESULT releaseSound(FMOD::Sound* self) {
+    FMOD_RESULT res = self->release();
+    // The buffer has to outlive the sound reading from it
+    AudioPreloader::get().release(self);
+    return res;
+}
+
+}  // namespace
+
+$execute {
+    auto hook = [](void* address, auto detour, const char* name) {
+        if (Result<Hook*> res = Mod::get()->hook(
+                address, detour, name, tulip::hook::TulipConvention::Default);
+            res.isErr()) {
+            log::error("Couldn't hook {}: {}", name, res.unwrapErr());
+        }
+    };
+
+    hook(reinterpret_cast<void*>(
+             addresser::getNonVirtual(&FMOD::System::createStream)),
+         &createStream, "FMOD::System::createStream");
+    hook(reinterpret_cast<void*>(
+             addresser::getNonVirtual(&FMOD::System::createSound)),
+         &createSound, "FMOD::System::createSound");
+    hook(reinterpret_cast<void*>(
+             addresser::getNonVirtual(&FMOD::Sound::release)),
+         &releaseSound, "FMOD::Sound::release");
+}
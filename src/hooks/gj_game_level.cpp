@@ -6,7 +6,9 @@
 #include "Geode/modify/Modify.hpp"
 #include "Geode/utils/string.hpp"
 
+#include "managers/hook_trace.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
 
 using namespace geode::prelude;
 using namespace jukebox;
@@ -19,19 +21,16 @@ class $modify(GJGameLevel) {
             return GJGameLevel::getAudioFileName();
         }
         int id = (-m_audioTrack) - 1;
+        HookTrace::Scope trace(TraceOp::GetAudioFileName, id);
         std::optional<Nongs*> res = NongManager::get().getNongs(id);
         if (!res.has_value()) {
             return GJGameLevel::getAudioFileName();
         }
         Song* active = res.value()->active();
-        if (!std::filesystem::exists(active->path().value())) {
+        if (!SongPack::get().exists(active->path().value())) {
             return GJGameLevel::getAudioFileName();
         }
         jukebox::NongManager::get().m_currentlyPreparingNong = res.value();
-#ifdef GEODE_IS_WINDOWS
-        return geode::utils::string::wideToUtf8(active->path().value().c_str());
-#else
-        return active->path().value().string();
-#endif
+        return active->songPath()->utf8();
     }
 };
@@ -6,6 +6,7 @@
 #include "Geode/cocos/label_nodes/CCLabelBMFont.h"
 #include "Geode/loader/Loader.hpp"
 
+#include "managers/hook_trace.hpp"
 #include "managers/nong_manager.hpp"
 #include "nong.hpp"
 
@@ -42,6 +43,7 @@ class $modify(JBLevelCell, LevelCell) {
         if (m_level->m_songID == 0) {
             id = (-m_level->m_audioTrack) - 1;
         }
+        HookTrace::Scope trace(TraceOp::LevelCellName, id);
 
         std::optional<Nongs*> opt = NongManager::get().getNongs(id);
         if (!opt.has_value()) {
@@ -4,6 +4,7 @@
 #include "Geode/modify/LevelSelectLayer.hpp"  // IWYU pragma: keep
 #include "Geode/modify/LevelTools.hpp"        // IWYU pragma: keep
 
+#include "managers/hook_trace.hpp"
 #include "managers/nong_manager.hpp"
 
 using namespace geode::prelude;
@@ -33,6 +34,7 @@ class $modify(LevelTools) {
             return LevelTools::getAudioTitle(id);
         }
         int searchID = -id - 1;
+        HookTrace::Scope trace(TraceOp::GetAudioTitle, searchID);
         std::optional<Nongs*> res = NongManager::get().getNongs(searchID);
         if (res.has_value()) {
             return res.value()->active()->metadata()->name;
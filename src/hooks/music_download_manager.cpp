@@ -1,6 +1,7 @@
 #include "hooks/music_download_manager.hpp"
 
 #include <cstddef>
+#include <filesystem>
 #include <optional>
 
 #include "Geode/binding/GameLevelManager.hpp"
@@ -13,12 +14,16 @@
 #include "Geode/utils/string.hpp"
 
 #include "events/get_song_info.hpp"
+#include "managers/hook_trace.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_info_queue.hpp"
+#include "managers/song_pack.hpp"
 #include "nong.hpp"
 
 using namespace jukebox;
 
 gd::string JBMusicDownloadManager::pathForSong(int id) {
+    HookTrace::Scope trace(TraceOp::PathForSong, id);
     NongManager::get().m_currentlyPreparingNong = std::nullopt;
     std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
     if (!nongs.has_value()) {
@@ -26,15 +31,24 @@ gd::string JBMusicDownloadManager::pathForSong(int id) {
     }
     Nongs* value = nongs.value();
     Song* active = value->active();
-    if (!std::filesystem::exists(active->path().value())) {
+    if (!SongPack::get().exists(active->path().value())) {
         return MusicDownloadManager::pathForSong(id);
     }
     NongManager::get().m_currentlyPreparingNong = value;
-#ifdef GEODE_IS_WINDOWS
-    return geode::utils::string::wideToUtf8(active->path().value().c_str());
-#else
-    return active->path().value().string();
-#endif
+    return active->songPath()->utf8();
+}
+
+bool JBMusicDownloadManager::isSongDownloaded(int id) {
+    // GD looks for the file pathForSong returns, a packed song has none
+    std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+    if (nongs.has_value()) {
+        std::optional<std::filesystem::path> path =
+            nongs.value()->active()->path();
+        if (path.has_value() && SongPack::get().exists(path.value())) {
+            return true;
+        }
+    }
+    return MusicDownloadManager::isSongDownloaded(id);
 }
 
 void JBMusicDownloadManager::onGetSongInfoCompleted(gd::string p1,
@@ -52,6 +66,7 @@ void JBMusicDownloadManager::onGetSongInfoCompleted(gd::string p1,
 
     // Size 0 -> got an invalid response from the servers
     if (keys.size() == 0 || keys.size() < ARTIST_NAME_INDEX) {
+        SongInfoQueue::get().reject(songID);
         return;
     }
 
@@ -59,11 +74,13 @@ void JBMusicDownloadManager::onGetSongInfoCompleted(gd::string p1,
     CCString* artistName = keys[ARTIST_NAME_INDEX];
 
     if (!songName || !artistName) {
+        SongInfoQueue::get().reject(songID);
         return;
     }
 
     event::GetSongInfo(songName->getCString(), artistName->getCString(), songID)
         .post();
+    NongManager::get().resolveSongInfoCallback(songID);
 }
 
 SongInfoObject* JBMusicDownloadManager::getSongInfoObject(int id) {
@@ -71,6 +88,7 @@ SongInfoObject* JBMusicDownloadManager::getSongInfoObject(int id) {
     if (og == nullptr) {
         return og;
     }
+    HookTrace::Scope trace(TraceOp::GetSongInfoObject, id);
     std::optional<Nongs*> opt = NongManager::get().getNongs(id);
     if (opt.has_value()) {
         Nongs* res = opt.value();
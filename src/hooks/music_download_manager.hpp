@@ -8,6 +8,7 @@
 struct JBMusicDownloadManager
     : geode::Modify<JBMusicDownloadManager, MusicDownloadManager> {
     gd::string pathForSong(int id);
+    bool isSongDownloaded(int id);
     void onGetSongInfoCompleted(gd::string p1, gd::string p2);
     SongInfoObject* getSongInfoObject(int id);
 };
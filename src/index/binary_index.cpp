@@ -0,0 +1,243 @@
+#include "index/binary_index.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+
+#include "index.hpp"
+#include "index_serialize.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace index {
+
+namespace binary {
+
+namespace {
+
+constexpr uint8_t s_magic[4] = {'J', 'B', 'I', 'X'};
+
+/**
+ * Bounds checked cursor over the index. Strings are views into the data,
+ * they're only copied once a song is built.
+ */
+class Reader {
+private:
+    std::span<const uint8_t> m_data;
+    size_t m_pos = 0;
+
+public:
+    explicit Reader(std::span<const uint8_t> data) : m_data(data) {}
+
+    size_t remaining() const { return m_data.size() - m_pos; }
+
+    Result<uint8_t> byte() {
+        if (this->remaining() == 0) {
+            return Err("Binary index is truncated");
+        }
+        return Ok(m_data[m_pos++]);
+    }
+
+    Result<uint64_t> varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            GEODE_UNWRAP_INTO(uint8_t next, this->byte());
+            value |= static_cast<uint64_t>(next & 0x7f) << shift;
+            if (!(next & 0x80)) {
+                return Ok(value);
+            }
+        }
+        return Err("Binary index has an invalid varint");
+    }
+
+    Result<int64_t> signedVarint() {
+        GEODE_UNWRAP_INTO(uint64_t value, this->varint());
+        return Ok(static_cast<int64_t>(value >> 1) ^
+                  -static_cast<int64_t>(value & 1));
+    }
+
+    // Every element takes at least minSize of the bytes left, this keeps a
+    // corrupted count from reserving gigabytes
+    Result<size_t> count(size_t minSize = 1) {
+        GEODE_UNWRAP_INTO(uint64_t value, this->varint());
+        if (value > this->remaining() / minSize) {
+            return Err("Binary index has an invalid count");
+        }
+        return Ok(static_cast<size_t>(value));
+    }
+
+    Result<std::string_view> bytes(uint64_t size) {
+        if (size > this->remaining()) {
+            return Err("Binary index is truncated");
+        }
+        std::string_view ret(reinterpret_cast<const char*>(&m_data[m_pos]),
+                             static_cast<size_t>(size));
+        m_pos += static_cast<size_t>(size);
+        return Ok(ret);
+    }
+};
+
+Result<int> toInt(int64_t value) {
+    if (value < std::numeric_limits<int>::min() ||
+        value > std::numeric_limits<int>::max()) {
+        return Err("Binary index has an out of range number");
+    }
+    return Ok(static_cast<int>(value));
+}
+
+Result<IndexMetadata> readMetadata(Reader& reader, const std::string& url) {
+    for (uint8_t expected : s_magic) {
+        GEODE_UNWRAP_INTO(uint8_t byte, reader.byte());
+        if (byte != expected) {
+            return Err("Not a binary index");
+        }
+    }
+    GEODE_UNWRAP_INTO(uint8_t manifest, reader.byte());
+    if (manifest != s_manifest) {
+        return Err("Using unsupported manifest version: {}",
+                   static_cast<int>(manifest));
+    }
+
+    GEODE_UNWRAP_INTO(uint64_t length, reader.varint());
+    GEODE_UNWRAP_INTO(std::string_view text, reader.bytes(length));
+    GEODE_UNWRAP_INTO(matjson::Value json, matjson::parse(text));
+    if (!json.isObject()) {
+        return Err("Binary index metadata isn't an object");
+    }
+
+    // The metadata keeps the v1 shape
+    json.set("manifest", 1);
+    json.set("url", url);
+    GEODE_UNWRAP_INTO(IndexMetadata metadata,
+                      matjson::Serialize<IndexMetadata>::fromJson(json));
+    metadata.m_manifest = s_manifest;
+    return Ok(std::move(metadata));
+}
+
+}  // namespace
+
+bool isBinary(std::span<const uint8_t> data) {
+    return data.size() >= sizeof(s_magic) &&
+           std::equal(std::begin(s_magic), std::end(s_magic), data.begin());
+}
+
+Result<IndexMetadata> decodeMetadata(std::span<const uint8_t> data,
+                                     const std::string& url) {
+    Reader reader(data);
+    return readMetadata(reader, url);
+}
+
+Result<DecodedIndex> decode(std::span<const uint8_t> data,
+                            const std::string& url) {
+    Reader reader(data);
+    GEODE_UNWRAP_INTO(IndexMetadata metadata, readMetadata(reader, url));
+
+    GEODE_UNWRAP_INTO(size_t stringCount, reader.count());
+    std::vector<std::string_view> strings;
+    strings.reserve(stringCount);
+    for (size_t i = 0; i < stringCount; i++) {
+        GEODE_UNWRAP_INTO(uint64_t length, reader.varint());
+        GEODE_UNWRAP_INTO(std::string_view string, reader.bytes(length));
+        strings.push_back(string);
+    }
+
+    auto string = [&reader, &strings]() -> Result<std::string> {
+        GEODE_UNWRAP_INTO(uint64_t i, reader.varint());
+        if (i >= strings.size()) {
+            return Err("Binary index has an invalid string index");
+        }
+        return Ok(std::string(strings[i]));
+    };
+
+    // A song is at least six varints: unique ID, name, artist, url, offset
+    // and its ID count
+    GEODE_UNWRAP_INTO(size_t songCount, reader.count(6));
+    std::vector<std::unique_ptr<IndexSongMetadata>> songs;
+    songs.reserve(songCount);
+    for (size_t i = 0; i < songCount; i++) {
+        songs.push_back(std::make_unique<IndexSongMetadata>(
+            IndexSongMetadata{.parentID = nullptr}));
+    }
+
+    for (std::unique_ptr<IndexSongMetadata>& song : songs) {
+        GEODE_UNWRAP_INTO(song->uniqueID, string());
+    }
+    for (std::unique_ptr<IndexSongMetadata>& song : songs) {
+        GEODE_UNWRAP_INTO(song->name, string());
+    }
+    for (std::unique_ptr<IndexSongMetadata>& song : songs) {
+        GEODE_UNWRAP_INTO(song->artist, string());
+    }
+    for (std::unique_ptr<IndexSongMetadata>& song : songs) {
+        GEODE_UNWRAP_INTO(uint64_t i, reader.varint());
+        if (i == 0) {
+            continue;
+        }
+        if (i > strings.size()) {
+            return Err("Binary index has an invalid string index");
+        }
+        song->url = std::string(strings[i - 1]);
+    }
+    for (std::unique_ptr<IndexSongMetadata>& song : songs) {
+        GEODE_UNWRAP_INTO(int64_t offset, reader.signedVarint());
+        GEODE_UNWRAP_INTO(song->startOffset, toInt(offset));
+    }
+
+    std::vector<size_t> idCounts;
+    idCounts.reserve(songCount);
+    size_t totalIDs = 0;
+    for (size_t i = 0; i < songCount; i++) {
+        GEODE_UNWRAP_INTO(size_t count, reader.count());
+        // Each count fits on its own, together they have to fit too
+        totalIDs += count;
+        if (totalIDs > reader.remaining()) {
+            return Err("Binary index has an invalid count");
+        }
+        idCounts.push_back(count);
+    }
+    for (size_t i = 0; i < songCount; i++) {
+        std::vector<int>& ids = songs[i]->songIDs;
+        ids.reserve(idCounts[i]);
+        int64_t previous = 0;
+        for (size_t j = 0; j < idCounts[i]; j++) {
+            int64_t id = 0;
+            if (j == 0) {
+                GEODE_UNWRAP_INTO(id, reader.signedVarint());
+            } else {
+                GEODE_UNWRAP_INTO(uint64_t delta, reader.varint());
+                if (delta > static_cast<uint64_t>(
+                                std::numeric_limits<int>::max())) {
+                    return Err("Binary index has an out of range number");
+                }
+                id = previous + static_cast<int64_t>(delta);
+            }
+            GEODE_UNWRAP_INTO(int value, toInt(id));
+            ids.push_back(value);
+            previous = id;
+        }
+    }
+
+    if (reader.remaining() != 0) {
+        return Err("Binary index has trailing data");
+    }
+
+    return Ok(DecodedIndex{.metadata = std::move(metadata),
+                           .songs = std::move(songs)});
+}
+
+}  // namespace binary
+
+}  // namespace index
+
+}  // namespace jukebox
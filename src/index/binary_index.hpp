@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Geode/Result.hpp"
+
+#include "index.hpp"
+
+namespace jukebox {
+
+namespace index {
+
+/**
+ * Index manifest v2, a columnar binary layout for large indexes.
+ *
+ * Integers are LEB128 varints unless noted, signed ones are zigzagged.
+ *
+ * - "JBIX", manifest version (u8, 2)
+ * - metadata length, metadata: the v1 index object without its songs, as
+ *   JSON. It's small and parsed by the v1 rules.
+ * - string count, then every string as length + UTF-8 bytes
+ * - song count, then one column per field, each holding a value for every
+ *   song in order: unique ID, name and artist (string indexes), url
+ *   (string index + 1, 0 if missing), start offset (signed), song ID count
+ * - song IDs of every song, sorted: the first one (signed), then the
+ *   difference to the previous one
+ *
+ * Only hosted songs are stored, like v1 indexes only those are loaded.
+ */
+namespace binary {
+
+constexpr uint8_t s_manifest = 2;
+// Hosts serving this content type, or urls ending in s_extension, get the
+// binary decoder
+constexpr std::string_view s_contentType = "application/vnd.jukebox.index";
+constexpr std::string_view s_extension = ".jbix";
+
+struct DecodedIndex {
+    IndexMetadata metadata;
+    // parentID is left unset
+    std::vector<std::unique_ptr<IndexSongMetadata>> songs;
+};
+
+/**
+ * Whether the data starts like a binary index, any version
+ */
+bool isBinary(std::span<const uint8_t> data);
+
+/**
+ * Decodes only the header and metadata, enough to validate a download
+ */
+geode::Result<IndexMetadata> decodeMetadata(std::span<const uint8_t> data,
+                                            const std::string& url);
+
+geode::Result<DecodedIndex> decode(std::span<const uint8_t> data,
+                                   const std::string& url);
+
+}  // namespace binary
+
+}  // namespace index
+
+}  // namespace jukebox
@@ -0,0 +1,222 @@
+#include "io/io_backend.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+#include "Geode/Result.hpp"
+
+#include "io/platform_file.hpp"
+#include "managers/executor.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace io {
+
+namespace {
+
+// Small files are cheap to stat, large batches per worker keep the
+// overhead of handing out chunks low
+constexpr size_t s_statChunk = 64;
+constexpr size_t s_writeChunk = 4;
+
+std::atomic_uint64_t s_tempCounter = 0;
+
+std::optional<uintmax_t> sizeOf(const std::filesystem::path& path) {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return size;
+}
+
+Result<> writeFile(const FileWrite& write) {
+    std::filesystem::path temp = write.path;
+    // Unique so two writes of the same file can't share a temporary
+    temp += fmt::format(".{}.tmp", s_tempCounter.fetch_add(1));
+
+    FILE* file = openFile(temp, "wb");
+    if (!file) {
+        return Err("Couldn't open {}", temp.string());
+    }
+
+    const bool ok =
+        std::fwrite(write.data.data(), 1, write.data.size(), file) ==
+            write.data.size() &&
+        (!write.sync || syncFile(file));
+    // Flushes the buffer when the sync was skipped
+    const bool closed = std::fclose(file) == 0;
+
+    std::error_code ec;
+    if (!ok || !closed) {
+        std::filesystem::remove(temp, ec);
+        return Err("Couldn't write {}", write.path.string());
+    }
+
+    std::filesystem::rename(temp, write.path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return Err("Couldn't replace {}: {}", write.path.string(),
+                   ec.message());
+    }
+    return Ok();
+}
+
+class BlockingBackend final : public IoBackend {
+public:
+    std::string name() const override { return "blocking"; }
+
+    std::vector<std::optional<uintmax_t>> sizes(
+        const std::vector<std::filesystem::path>& paths) override {
+        std::vector<std::optional<uintmax_t>> ret;
+        ret.reserve(paths.size());
+        for (const std::filesystem::path& path : paths) {
+            ret.push_back(sizeOf(path));
+        }
+        return ret;
+    }
+
+    Result<> write(const std::vector<FileWrite>& batch) override {
+        for (const FileWrite& write : batch) {
+            GEODE_UNWRAP(writeFile(write));
+        }
+        return Ok();
+    }
+};
+
+class PooledBackend final : public IoBackend {
+public:
+    std::string name() const override { return "pooled"; }
+
+    std::vector<std::optional<uintmax_t>> sizes(
+        const std::vector<std::filesystem::path>& paths) override {
+        std::vector<std::optional<uintmax_t>> ret(paths.size());
+        parallelFor(paths.size(), s_statChunk,
+                    [&paths, &ret](size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; i++) {
+                            ret[i] = sizeOf(paths[i]);
+                        }
+                    });
+        return ret;
+    }
+
+    Result<> write(const std::vector<FileWrite>& batch) override {
+        std::mutex mutex;
+        std::optional<std::string> error;
+        std::atomic_bool failed = false;
+
+        parallelFor(batch.size(), s_writeChunk, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end && !failed.load(); i++) {
+                Result<> res = writeFile(batch[i]);
+                if (res.isErr()) {
+                    std::lock_guard lock(mutex);
+                    if (!error.has_value()) {
+                        error = res.unwrapErr();
+                    }
+                    failed.store(true);
+                }
+            }
+        });
+
+        if (error.has_value()) {
+            return Err(error.value());
+        }
+        return Ok();
+    }
+};
+
+struct ParallelState {
+    std::function<void(size_t, size_t)> work;
+    size_t count;
+    size_t chunk;
+    size_t chunks;
+    std::atomic_size_t next = 0;
+    std::atomic_size_t done = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // False once every chunk has been handed out
+    bool runChunk() {
+        const size_t i = next.fetch_add(1);
+        if (i >= chunks) {
+            return false;
+        }
+        work(i * chunk, std::min(count, (i + 1) * chunk));
+        if (done.fetch_add(1) + 1 == chunks) {
+            std::lock_guard lock(mutex);
+            finished.notify_all();
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+std::unique_ptr<IoBackend> createBlockingBackend() {
+    return std::make_unique<BlockingBackend>();
+}
+
+std::unique_ptr<IoBackend> createPooledBackend() {
+    return std::make_unique<PooledBackend>();
+}
+
+IoBackend& backend() {
+    static std::unique_ptr<IoBackend> instance = createPooledBackend();
+    return *instance;
+}
+
+void parallelFor(size_t count, size_t chunk,
+                 const std::function<void(size_t begin, size_t end)>& work) {
+    if (count == 0) {
+        return;
+    }
+    chunk = std::max<size_t>(chunk, 1);
+    const size_t chunks = (count + chunk - 1) / chunk;
+    const size_t workers = Executor::get().workerCount();
+    if (chunks == 1 || workers == 0) {
+        work(0, count);
+        return;
+    }
+
+    // Helpers can start after the batch is done, they keep the state alive
+    // and find nothing left to do
+    auto state = std::make_shared<ParallelState>();
+    state->work = work;
+    state->count = count;
+    state->chunk = chunk;
+    state->chunks = chunks;
+
+    for (size_t i = 0; i < std::min(chunks - 1, workers); i++) {
+        Executor::get().run(Lane::Background, [state]() {
+            while (state->runChunk()) {
+            }
+        });
+    }
+
+    // Never waits on a chunk nobody picked up, so this can't deadlock when
+    // every worker is busy, or when called from one
+    while (state->runChunk()) {
+    }
+    std::unique_lock lock(state->mutex);
+    state->finished.wait(lock,
+                         [&state]() {
+                             return state->done.load() == state->chunks;
+                         });
+}
+
+}  // namespace io
+
+}  // namespace jukebox
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Geode/Result.hpp"
+
+namespace jukebox {
+
+namespace io {
+
+/**
+ * A file to replace. The data isn't owned and has to outlive the write.
+ */
+struct FileWrite {
+    std::filesystem::path path;
+    std::span<const uint8_t> data;
+    // Without the flush to disk a crash of the game still can't leave half
+    // a file, only a power loss can lose the write
+    bool sync = true;
+};
+
+/**
+ * Blocking file operations done in batches. Every call returns once the
+ * whole batch is done, so they belong on a worker or in code that already
+ * blocks on disk.
+ */
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    // Used in logs
+    virtual std::string name() const = 0;
+
+    /**
+     * Size of every file, nullopt for files that are missing or unreadable.
+     * Results are in the order of the paths.
+     */
+    virtual std::vector<std::optional<uintmax_t>> sizes(
+        const std::vector<std::filesystem::path>& paths) = 0;
+
+    /**
+     * Replaces every file atomically: the data goes to a temporary file
+     * next to it, is flushed to disk unless the write opts out, then
+     * renamed over the old one. A crash leaves either the old or the new
+     * file, never half of one.
+     *
+     * Stops at the first error, files written before it stay written.
+     */
+    virtual geode::Result<> write(const std::vector<FileWrite>& batch) = 0;
+};
+
+/**
+ * One syscall after the other on the calling thread
+ */
+std::unique_ptr<IoBackend> createBlockingBackend();
+
+/**
+ * Splits batches over the Executor's workers. The calling thread works on
+ * the batch too, so it's safe to call from a worker.
+ */
+std::unique_ptr<IoBackend> createPooledBackend();
+
+/**
+ * Shared pooled backend
+ */
+IoBackend& backend();
+
+/**
+ * Runs work(begin, end) over [0, count) in chunks, on the calling thread
+ * and any idle worker
+ */
+void parallelFor(size_t count, size_t chunk,
+                 const std::function<void(size_t begin, size_t end)>& work);
+
+}  // namespace io
+
+}  // namespace jukebox
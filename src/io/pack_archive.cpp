@@ -0,0 +1,387 @@
+#include "io/pack_archive.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Geode/Result.hpp"
+
+#include "io/platform_file.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace io {
+
+namespace {
+
+constexpr uint32_t s_removedFlag = 1;
+
+// Records are stored little endian on every platform
+void putInt(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out.push_back(static_cast<uint8_t>((value >> (i * 8)) & 0xff));
+    }
+}
+
+uint64_t getInt(const uint8_t* data, size_t bytes) {
+    uint64_t ret = 0;
+    for (size_t i = 0; i < bytes; i++) {
+        ret |= static_cast<uint64_t>(data[i]) << (i * 8);
+    }
+    return ret;
+}
+
+std::vector<uint8_t> fileHeader() {
+    std::vector<uint8_t> ret(PackArchive::s_magic.begin(),
+                             PackArchive::s_magic.end());
+    ret.push_back(PackArchive::s_version);
+    ret.resize(PackArchive::s_headerSize, 0);
+    return ret;
+}
+
+std::vector<uint8_t> recordHeader(std::string_view key, uint32_t flags,
+                                  uint64_t size) {
+    std::vector<uint8_t> ret;
+    ret.reserve(PackArchive::s_recordHeaderSize + key.size());
+    putInt(ret, key.size(), 4);
+    putInt(ret, flags, 4);
+    putInt(ret, size, 8);
+    ret.insert(ret.end(), key.begin(), key.end());
+    return ret;
+}
+
+bool writeAll(FILE* file, std::span<const uint8_t> data) {
+    // Tombstones have no data, and fwrite doesn't take a null buffer
+    if (data.empty()) {
+        return true;
+    }
+    return std::fwrite(data.data(), 1, data.size(), file) == data.size();
+}
+
+uint64_t recordSize(size_t keySize, uint64_t dataSize) {
+    return PackArchive::s_recordHeaderSize + keySize + dataSize;
+}
+
+}  // namespace
+
+Result<std::unique_ptr<PackArchive>> PackArchive::open(
+    std::filesystem::path path) {
+    std::unique_ptr<PackArchive> ret(new PackArchive(std::move(path)));
+    GEODE_UNWRAP(ret->load());
+    return Ok(std::move(ret));
+}
+
+Result<> PackArchive::load() {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(m_path, ec);
+
+    // New, or a crash before the header was written
+    if (ec || size < s_headerSize) {
+        FILE* file = openFile(m_path, "wb");
+        if (!file) {
+            return Err("Couldn't create {}", m_path.string());
+        }
+        const bool ok = writeAll(file, fileHeader()) && syncFile(file);
+        std::fclose(file);
+        if (!ok) {
+            return Err("Couldn't write {}", m_path.string());
+        }
+    }
+
+    GEODE_UNWRAP_INTO(std::shared_ptr<const MappedFile> map,
+                      MappedFile::map(m_path));
+    std::span<const uint8_t> data = map->data();
+    if (!std::equal(s_magic.begin(), s_magic.end(), data.begin())) {
+        return Err("{} isn't a song pack", m_path.string());
+    }
+    if (data[s_magic.size()] > s_version) {
+        return Err("{} is from a newer version of Jukebox",
+                   m_path.string());
+    }
+
+    std::unordered_map<std::string, Location> index;
+    uint64_t offset = s_headerSize;
+    while (data.size() - offset >= s_recordHeaderSize) {
+        const uint8_t* header = data.data() + offset;
+        const uint64_t keySize = getInt(header, 4);
+        const uint32_t flags = static_cast<uint32_t>(getInt(header + 4, 4));
+        const uint64_t dataSize = getInt(header + 8, 8);
+
+        // Anything that doesn't fit is a record cut short by a crash
+        const uint64_t left = data.size() - offset - s_recordHeaderSize;
+        if (keySize == 0 || keySize > s_maxKeySize || keySize > left ||
+            dataSize > left - keySize) {
+            break;
+        }
+
+        std::string key(
+            reinterpret_cast<const char*>(header + s_recordHeaderSize),
+            keySize);
+        const uint64_t dataOffset = offset + s_recordHeaderSize + keySize;
+        if (flags & s_removedFlag) {
+            index.erase(key);
+        } else {
+            index[std::move(key)] = Location{dataOffset, dataSize};
+        }
+        offset = dataOffset + dataSize;
+    }
+
+    if (offset < data.size()) {
+        m_recovered = data.size() - offset;
+        // Can't shrink a file that is still mapped on Windows
+        map.reset();
+        std::filesystem::resize_file(m_path, offset, ec);
+        if (ec) {
+            return Err("Couldn't repair {}: {}", m_path.string(),
+                       ec.message());
+        }
+        GEODE_UNWRAP_INTO(map, MappedFile::map(m_path));
+    }
+
+    std::lock_guard lock(m_mutex);
+    m_map = std::move(map);
+    m_index = std::move(index);
+    m_end = offset;
+    return Ok();
+}
+
+std::optional<PackView> PackArchive::find(const std::string& key) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end() || !m_map) {
+        return std::nullopt;
+    }
+    return PackView{m_map,
+                    m_map->data().subspan(it->second.offset, it->second.size)};
+}
+
+std::optional<uint64_t> PackArchive::size(const std::string& key) const {
+    std::lock_guard lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        return std::nullopt;
+    }
+    return it->second.size;
+}
+
+bool PackArchive::contains(const std::string& key) const {
+    std::lock_guard lock(m_mutex);
+    return m_index.contains(key);
+}
+
+std::vector<std::string> PackArchive::keys() const {
+    std::lock_guard lock(m_mutex);
+    std::vector<std::string> ret;
+    ret.reserve(m_index.size());
+    for (const auto& [key, location] : m_index) {
+        ret.push_back(key);
+    }
+    return ret;
+}
+
+Result<> PackArchive::append(const std::vector<Record>& records) {
+    if (records.empty()) {
+        return Ok();
+    }
+
+    // Only this writer moves the end, so it's safe to read unlocked
+    const uint64_t start = m_end;
+    FILE* file = openFile(m_path, "r+b");
+    if (!file) {
+        return Err("Couldn't open {}", m_path.string());
+    }
+
+    // Written after the end, so a failure leaves at most a torn record
+    // that the next append overwrites
+    std::vector<Location> locations;
+    locations.reserve(records.size());
+    uint64_t offset = start;
+    bool ok = seekFile(file, start);
+    for (const Record& record : records) {
+        if (!ok) {
+            break;
+        }
+        const std::span<const uint8_t> data =
+            record.removed ? std::span<const uint8_t>() : record.data;
+        const uint32_t flags = record.removed ? s_removedFlag : 0;
+        ok = writeAll(file, recordHeader(record.key, flags, data.size())) &&
+             writeAll(file, data);
+
+        offset += s_recordHeaderSize + record.key.size();
+        locations.push_back(Location{offset, data.size()});
+        offset += data.size();
+    }
+    ok = ok && syncFile(file);
+    std::fclose(file);
+    if (!ok) {
+        return Err("Couldn't write {}", m_path.string());
+    }
+
+    GEODE_UNWRAP_INTO(std::shared_ptr<const MappedFile> map,
+                      MappedFile::map(m_path));
+
+    std::lock_guard lock(m_mutex);
+    for (size_t i = 0; i < records.size(); i++) {
+        const std::string key(records[i].key);
+        if (records[i].removed) {
+            m_index.erase(key);
+        } else {
+            m_index[key] = locations[i];
+        }
+    }
+    m_map = std::move(map);
+    m_end = offset;
+    return Ok();
+}
+
+Result<> PackArchive::add(const std::vector<PackEntry>& entries) {
+    std::vector<Record> records;
+    records.reserve(entries.size());
+    for (const PackEntry& entry : entries) {
+        if (entry.key.empty() || entry.key.size() > s_maxKeySize) {
+            return Err("Invalid pack key {}", entry.key);
+        }
+        records.push_back(Record{entry.key, entry.data});
+    }
+
+    std::lock_guard writeLock(m_writeMutex);
+    return this->append(records);
+}
+
+Result<uint64_t> PackArchive::remove(const std::vector<std::string>& keys) {
+    std::lock_guard writeLock(m_writeMutex);
+
+    std::vector<Record> records;
+    uint64_t freed = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const std::string& key : keys) {
+            auto it = m_index.find(key);
+            if (it == m_index.end()) {
+                continue;
+            }
+            freed += it->second.size;
+            records.push_back(Record{key, {}, true});
+        }
+    }
+
+    GEODE_UNWRAP(this->append(records));
+    return Ok(freed);
+}
+
+Result<> PackArchive::compact() {
+    std::lock_guard writeLock(m_writeMutex);
+
+    std::shared_ptr<const MappedFile> map;
+    std::vector<std::pair<std::string, Location>> entries;
+    {
+        std::lock_guard lock(m_mutex);
+        map = m_map;
+        entries.assign(m_index.begin(), m_index.end());
+    }
+    if (!map) {
+        return Err("{} isn't open", m_path.string());
+    }
+    // Keeps the order entries were added in
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.second.offset < b.second.offset;
+    });
+
+    std::filesystem::path temp = m_path;
+    temp += ".tmp";
+    FILE* file = openFile(temp, "wb");
+    if (!file) {
+        return Err("Couldn't open {}", temp.string());
+    }
+
+    std::unordered_map<std::string, Location> index;
+    index.reserve(entries.size());
+    uint64_t offset = s_headerSize;
+    bool ok = writeAll(file, fileHeader());
+    for (const auto& [key, location] : entries) {
+        if (!ok) {
+            break;
+        }
+        ok = writeAll(file, recordHeader(key, 0, location.size)) &&
+             writeAll(file,
+                      map->data().subspan(location.offset, location.size));
+        offset += s_recordHeaderSize + key.size();
+        index.emplace(key, Location{offset, location.size});
+        offset += location.size;
+    }
+    ok = ok && syncFile(file);
+    std::fclose(file);
+
+    std::error_code ec;
+    if (!ok) {
+        std::filesystem::remove(temp, ec);
+        return Err("Couldn't write {}", temp.string());
+    }
+
+    // The old file has to be unmapped before Windows lets it be replaced
+    map.reset();
+    std::lock_guard lock(m_mutex);
+    m_map.reset();
+    std::filesystem::rename(temp, m_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        Result<std::shared_ptr<const MappedFile>> old = MappedFile::map(m_path);
+        if (old.isOk()) {
+            m_map = std::move(old).unwrap();
+        } else {
+            m_index.clear();
+        }
+        return Err("Couldn't replace {}, it's still in use",
+                   m_path.string());
+    }
+
+    Result<std::shared_ptr<const MappedFile>> next = MappedFile::map(m_path);
+    if (next.isErr()) {
+        // Reads fail until the pack is opened again, the data is safe
+        m_index.clear();
+        return Err(next.unwrapErr());
+    }
+    m_map = std::move(next).unwrap();
+    m_index = std::move(index);
+    m_end = offset;
+    return Ok();
+}
+
+PackArchive::Stats PackArchive::stats() const {
+    std::lock_guard lock(m_mutex);
+    Stats stats;
+    stats.entries = m_index.size();
+    stats.fileBytes = m_end;
+    stats.recoveredBytes = m_recovered;
+
+    uint64_t used = s_headerSize;
+    for (const auto& [key, location] : m_index) {
+        stats.liveBytes += location.size;
+        used += recordSize(key.size(), location.size);
+    }
+    stats.deadBytes = m_end - std::min(used, m_end);
+    return stats;
+}
+
+bool PackArchive::shouldCompact() const {
+    const Stats stats = this->stats();
+    return stats.deadBytes >= s_compactMinimum &&
+           stats.deadBytes * 4 >= stats.fileBytes;
+}
+
+}  // namespace io
+
+}  // namespace jukebox
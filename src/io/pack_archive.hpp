@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Geode/Result.hpp"
+
+#include "io/platform_file.hpp"
+
+namespace jukebox {
+
+namespace io {
+
+/**
+ * One entry of a pack. Keeps the mapping it points into alive, so it stays
+ * valid through later appends and compaction.
+ */
+struct PackView {
+    std::shared_ptr<const MappedFile> owner;
+    std::span<const uint8_t> data;
+};
+
+/**
+ * A file to add to a pack. The data isn't owned and has to outlive the add.
+ */
+struct PackEntry {
+    std::string key;
+    std::span<const uint8_t> data;
+};
+
+/**
+ * Many small files stored in one, read through a memory mapping.
+ *
+ * The file is append-only: adding a key again or removing it writes a new
+ * record and leaves the old one as dead space until compact() rewrites the
+ * file. A record cut short by a crash is dropped when the pack is opened.
+ *
+ * Doesn't depend on the game, FMOD or the mod's settings. Safe to use from
+ * any thread, reads never wait on disk writes.
+ */
+class PackArchive {
+public:
+    static constexpr std::string_view s_magic = "JBPK";
+    static constexpr uint8_t s_version = 1;
+    static constexpr size_t s_headerSize = 8;
+    // key length, flags and data length
+    static constexpr size_t s_recordHeaderSize = 16;
+    static constexpr size_t s_maxKeySize = 1024;
+    // Dead space worth rewriting the pack for
+    static constexpr uint64_t s_compactMinimum = 1024 * 1024;
+
+    struct Stats {
+        size_t entries = 0;
+        // Bytes of every live entry
+        uint64_t liveBytes = 0;
+        // Size of the pack on disk
+        uint64_t fileBytes = 0;
+        // Replaced and removed records
+        uint64_t deadBytes = 0;
+        // Bytes of a torn record dropped when the pack was opened
+        uint64_t recoveredBytes = 0;
+    };
+
+protected:
+    struct Location {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct Record {
+        std::string_view key;
+        std::span<const uint8_t> data;
+        // Tombstone, the key's entry is gone from here on
+        bool removed = false;
+    };
+
+    std::filesystem::path m_path;
+
+    // Guards the mapping and index, only held for lookups and swaps
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const MappedFile> m_map;
+    std::unordered_map<std::string, Location> m_index;
+    uint64_t m_end = 0;
+    uint64_t m_recovered = 0;
+
+    // Held by whoever is writing to the file
+    std::mutex m_writeMutex;
+
+    PackArchive(std::filesystem::path path) : m_path(std::move(path)) {}
+
+    geode::Result<> load();
+    geode::Result<> append(const std::vector<Record>& records);
+
+public:
+    PackArchive(const PackArchive&) = delete;
+    PackArchive(PackArchive&&) = delete;
+
+    PackArchive& operator=(const PackArchive&) = delete;
+    PackArchive& operator=(PackArchive&&) = delete;
+
+    /**
+     * Opens a pack, creating it if it doesn't exist
+     */
+    static geode::Result<std::unique_ptr<PackArchive>> open(
+        std::filesystem::path path);
+
+    const std::filesystem::path& path() const { return m_path; }
+
+    std::optional<PackView> find(const std::string& key) const;
+    std::optional<uint64_t> size(const std::string& key) const;
+    bool contains(const std::string& key) const;
+    std::vector<std::string> keys() const;
+
+    /**
+     * Adds or replaces entries. Everything is flushed to disk before it
+     * becomes visible to find().
+     */
+    geode::Result<> add(const std::vector<PackEntry>& entries);
+    /**
+     * Removes entries, returns the bytes they took. Keys that aren't in the
+     * pack are skipped.
+     */
+    geode::Result<uint64_t> remove(const std::vector<std::string>& keys);
+
+    /**
+     * Rewrites the pack with only its live entries. Views handed out before
+     * keep reading the old file.
+     *
+     * Windows can't replace a file that is still mapped, so this fails there
+     * while any view is alive. The pack is left as it was in that case.
+     */
+    geode::Result<> compact();
+
+    Stats stats() const;
+    /**
+     * Whether enough of the file is dead space to be worth compacting
+     */
+    bool shouldCompact() const;
+};
+
+}  // namespace io
+
+}  // namespace jukebox
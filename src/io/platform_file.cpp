@@ -0,0 +1,125 @@
+#include "io/platform_file.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "Geode/Result.hpp"
+#include "Geode/platform/cplatform.h"
+
+#ifdef GEODE_IS_WINDOWS
+#include <Windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace io {
+
+FILE* openFile(const std::filesystem::path& path, const char* mode) {
+#ifdef GEODE_IS_WINDOWS
+    const std::wstring wide(mode, mode + std::char_traits<char>::length(mode));
+    return _wfopen(path.c_str(), wide.c_str());
+#else
+    return std::fopen(path.c_str(), mode);
+#endif
+}
+
+bool seekFile(FILE* file, uint64_t offset) {
+#ifdef GEODE_IS_WINDOWS
+    return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+bool syncFile(FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef GEODE_IS_WINDOWS
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+MappedFile::~MappedFile() {
+    if (!m_data) {
+        return;
+    }
+#ifdef GEODE_IS_WINDOWS
+    UnmapViewOfFile(m_data);
+#else
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+}
+
+Result<std::shared_ptr<const MappedFile>> MappedFile::map(
+    const std::filesystem::path& path) {
+    // No public constructor for make_shared to use
+    std::shared_ptr<MappedFile> ret(new MappedFile());
+
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return Err("Couldn't read {}: {}", path.string(), ec.message());
+    }
+    // Nothing to map, and zero length mappings aren't allowed
+    if (size == 0) {
+        return Ok(std::shared_ptr<const MappedFile>(std::move(ret)));
+    }
+
+#ifdef GEODE_IS_WINDOWS
+    // Shared for writing and deleting, so appends and compaction can go on
+    // while the mapping is alive
+    HANDLE file = CreateFileW(
+        path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return Err("Couldn't open {}", path.string());
+    }
+    HANDLE mapping =
+        CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        return Err("Couldn't map {}", path.string());
+    }
+    // The view keeps the mapping object alive
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    CloseHandle(mapping);
+    if (!data) {
+        return Err("Couldn't map {}", path.string());
+    }
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Err("Couldn't open {}", path.string());
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return Err("Couldn't map {}", path.string());
+    }
+#endif
+
+    ret->m_data = static_cast<const uint8_t*>(data);
+    ret->m_size = static_cast<size_t>(size);
+    return Ok(std::shared_ptr<const MappedFile>(std::move(ret)));
+}
+
+}  // namespace io
+
+}  // namespace jukebox
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+#include "Geode/Result.hpp"
+
+namespace jukebox {
+
+namespace io {
+
+/**
+ * fopen that takes the path as is on every platform. Windows paths aren't
+ * UTF-8, so narrowing them would break non-ASCII names.
+ */
+FILE* openFile(const std::filesystem::path& path, const char* mode);
+
+/**
+ * fseek from the start that works past 2GB on every platform
+ */
+bool seekFile(FILE* file, uint64_t offset);
+
+/**
+ * Flushes a file's buffers and waits for the OS to put them on disk
+ */
+bool syncFile(FILE* file);
+
+/**
+ * Read-only memory mapping of a whole file. The mapping stays valid after
+ * the file is renamed over or deleted, and doesn't see data appended after
+ * it was made.
+ */
+class MappedFile {
+protected:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+    MappedFile() = default;
+
+public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    static geode::Result<std::shared_ptr<const MappedFile>> map(
+        const std::filesystem::path& path);
+
+    std::span<const uint8_t> data() const { return {m_data, m_size}; }
+};
+
+}  // namespace io
+
+}  // namespace jukebox
@@ -0,0 +1,197 @@
+#include "library_query.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "managers/library_index.hpp"
+#include "managers/nong_manager.hpp"
+
+namespace jukebox {
+
+LibraryQuery& LibraryQuery::type(NongType type) {
+    m_type = type;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::index(const std::string& indexID) {
+    m_indexID = indexID;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::artist(const std::string& artist) {
+    m_artist = LibraryIndex::normalizeArtist(artist);
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::downloaded(bool downloaded) {
+    m_downloaded = downloaded;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::songID(int gdSongID) {
+    m_songID = gdSongID;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::includeDefaults(bool include) {
+    m_includeDefaults = include;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::where(Predicate predicate) {
+    m_predicates.push_back(std::move(predicate));
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::sortBy(SortKey key, bool descending) {
+    m_sortKey = key;
+    m_descending = descending;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::offset(size_t offset) {
+    m_offset = offset;
+    return *this;
+}
+
+LibraryQuery& LibraryQuery::limit(size_t limit) {
+    m_limit = limit;
+    return *this;
+}
+
+std::vector<SongView> LibraryQuery::collect(uint64_t& version) const {
+    LibraryIndex::Candidates candidates =
+        NongManager::get().library().candidates(LibraryIndex::Filter{
+            m_type, m_indexID, m_artist, m_downloaded, m_includeDefaults});
+    const ManifestSnapshot& snapshot = *candidates.snapshot;
+    version = snapshot.version();
+
+    auto matches = [this](const SongView& view) {
+        const SongSnapshot& song = view.song();
+        if (m_type.has_value() && song.type != m_type.value()) {
+            return false;
+        }
+        if (m_indexID.has_value() && song.indexID != m_indexID) {
+            return false;
+        }
+        if (m_artist.has_value() &&
+            LibraryIndex::normalizeArtist(song.metadata.artist) !=
+                m_artist.value()) {
+            return false;
+        }
+        if (m_downloaded.has_value() &&
+            song.downloaded() != m_downloaded.value()) {
+            return false;
+        }
+        for (const Predicate& predicate : m_predicates) {
+            if (!predicate(view)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    std::vector<SongView> ret;
+    auto scan = [&](const std::shared_ptr<const NongsSnapshot>& nongs) {
+        if (!nongs) {
+            return;
+        }
+        if (m_includeDefaults) {
+            SongView view(nongs, std::nullopt);
+            if (matches(view)) {
+                ret.push_back(std::move(view));
+            }
+        }
+        for (size_t i = 0; i < nongs->songs.size(); i++) {
+            SongView view(nongs, i);
+            if (matches(view)) {
+                ret.push_back(std::move(view));
+            }
+        }
+    };
+
+    if (m_songID.has_value()) {
+        if (!candidates.songIDs.has_value() ||
+            std::find(candidates.songIDs->begin(), candidates.songIDs->end(),
+                      m_songID.value()) != candidates.songIDs->end()) {
+            scan(snapshot.find(m_songID.value()));
+        }
+    } else if (candidates.songIDs.has_value()) {
+        for (int id : candidates.songIDs.value()) {
+            scan(snapshot.find(id));
+        }
+    } else {
+        for (const auto& [id, nongs] : snapshot.nongs()) {
+            scan(nongs);
+        }
+    }
+
+    return ret;
+}
+
+LibraryPage LibraryQuery::run() const {
+    LibraryPage page;
+    std::vector<SongView> views = this->collect(page.version);
+    page.total = views.size();
+    page.offset = m_offset;
+
+    if (m_offset >= views.size()) {
+        return page;
+    }
+
+    // Ties are broken by song ID and unique ID so paging is stable
+    auto less = [this](const SongView& a, const SongView& b) {
+        const SongSnapshot& sa = a.song();
+        const SongSnapshot& sb = b.song();
+        int cmp = 0;
+        switch (m_sortKey) {
+            case SortKey::GDSongID:
+                break;
+            case SortKey::Name:
+                cmp = sa.metadata.name.compare(sb.metadata.name);
+                break;
+            case SortKey::Artist:
+                cmp = sa.metadata.artist.compare(sb.metadata.artist);
+                break;
+            case SortKey::FileSize: {
+                uintmax_t la = sa.fileSize.value_or(0);
+                uintmax_t lb = sb.fileSize.value_or(0);
+                cmp = la < lb ? -1 : (la > lb ? 1 : 0);
+                break;
+            }
+        }
+        if (cmp == 0 && a.gdSongID() != b.gdSongID()) {
+            cmp = a.gdSongID() < b.gdSongID() ? -1 : 1;
+        }
+        if (cmp == 0) {
+            cmp = sa.metadata.uniqueID.compare(sb.metadata.uniqueID);
+        }
+        return m_descending ? cmp > 0 : cmp < 0;
+    };
+
+    size_t end = views.size();
+    if (m_limit.has_value()) {
+        end = std::min(end, m_offset + m_limit.value());
+    }
+
+    if (end < views.size()) {
+        std::partial_sort(views.begin(), views.begin() + end, views.end(),
+                          less);
+    } else {
+        std::sort(views.begin(), views.end(), less);
+    }
+
+    page.songs.assign(std::make_move_iterator(views.begin() + m_offset),
+                      std::make_move_iterator(views.begin() + end));
+    return page;
+}
+
+size_t LibraryQuery::count() const {
+    uint64_t version;
+    return this->collect(version).size();
+}
+
+}  // namespace jukebox
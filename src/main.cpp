@@ -1,11 +1,23 @@
+#include <filesystem>
+#include <optional>
+
 #include <Geode/Result.hpp>
 #include "Geode/DefaultInclude.hpp"
 #include "Geode/loader/Mod.hpp"
 #include "Geode/loader/ModEvent.hpp"
 
+#include "managers/deletion_queue.hpp"
+#include "managers/executor.hpp"
+#include "managers/hook_trace.hpp"
 #include "managers/index_manager.hpp"
+#include "managers/memory_stats.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
 #include "ui/indexes_setting.hpp"
+#include "utils/io_benchmark.hpp"
+#include "utils/rollback_check.hpp"
+#include "utils/trace_replay.hpp"
+#include "utils/ui_benchmark.hpp"
 
 $execute {
     (void)Mod::get()->registerCustomSettingType("indexes",
@@ -13,6 +25,40 @@ $execute {
 }
 
 $on_mod(Loaded) {
+    jukebox::Executor::get().start();
+    // Before the manifest, so packed songs count as downloaded
+    jukebox::SongPack::get().start();
     jukebox::NongManager::get().init();
+    jukebox::DeletionQueue::get().start();
     jukebox::IndexManager::get().init();
+    jukebox::MemoryStats::get().start();
+    jukebox::HookTrace::get().start();
+
+    if (Mod::get()->getLaunchFlag("benchmark")) {
+        jukebox::runUiBenchmark();
+    }
+
+    if (Mod::get()->getLaunchFlag("benchmark-io")) {
+        // Writes and fsyncs over a hundred megabytes, keep the game going
+        jukebox::Executor::get().run(jukebox::Lane::Background,
+                                     []() { jukebox::runIoBenchmark(); });
+    }
+
+    if (Mod::get()->getLaunchFlag("check-rollback")) {
+        if (Result<> res = jukebox::runRollbackCheck(); res.isErr()) {
+            log::error("Rollback check failed: {}", res.unwrapErr());
+        }
+    }
+
+    if (Mod::get()->getLaunchFlag("replay-trace")) {
+        if (std::optional<std::filesystem::path> trace =
+                jukebox::latestTrace()) {
+            if (Result<> res = jukebox::replayTrace(trace.value());
+                res.isErr()) {
+                log::error("Couldn't replay trace: {}", res.unwrapErr());
+            }
+        } else {
+            log::warn("No hook trace to replay");
+        }
+    }
 };
@@ -0,0 +1,181 @@
+#include "managers/audio_preloader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "managers/executor.hpp"
+#include "managers/memory_stats.hpp"
+#include "managers/nong_manager.hpp"
+#include "managers/preload_cache.hpp"
+#include "managers/song_pack.hpp"
+#include "nong.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace {
+
+constexpr size_t s_megabyte = 1024 * 1024;
+
+std::optional<PreloadCache::Buffer> readFile(const std::filesystem::path& path,
+                                             size_t size) {
+    // Songs can be packed, see SongPack
+    std::unique_ptr<std::istream> input = SongPack::get().open(path);
+    if (!input) {
+        return std::nullopt;
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>(size);
+    input->read(reinterpret_cast<char*>(data->data()), size);
+    if (static_cast<size_t>(input->gcount()) != size) {
+        return std::nullopt;
+    }
+    return data;
+}
+
+// GD may hand FMOD the same file with other separators, and Windows paths
+// aren't case sensitive
+std::string cacheKey(std::string_view path) {
+    std::string key;
+    key.reserve(path.size());
+    for (char c : path) {
+        if (c == '\\') {
+            c = '/';
+        }
+        if (c == '/' && !key.empty() && key.back() == '/') {
+            continue;
+        }
+#ifdef GEODE_IS_WINDOWS
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+#endif
+        key.push_back(c);
+    }
+    return key;
+}
+
+}  // namespace
+
+void AudioPreloader::applySettings() {
+    const int64_t budget =
+        Mod::get()->getSettingValue<int64_t>("preload-budget");
+    const int64_t maxSize =
+        Mod::get()->getSettingValue<int64_t>("preload-max-size");
+
+    std::lock_guard lock(m_mutex);
+    m_cache.setLimits(std::max<int64_t>(budget, 0) * s_megabyte,
+                      std::max<int64_t>(maxSize, 0) * s_megabyte);
+}
+
+void AudioPreloader::preload(const std::vector<int>& songIDs) {
+    // Reads for the previous page are dropped, their completions never run
+    m_token.cancel();
+    m_token = CancellationToken();
+    {
+        std::lock_guard lock(m_mutex);
+        m_loading.clear();
+    }
+
+    if (!Mod::get()->getSettingValue<bool>("preload-songs")) {
+        std::lock_guard lock(m_mutex);
+        m_cache.clear();
+        return;
+    }
+    this->applySettings();
+
+    for (int id : songIDs) {
+        std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+        if (!nongs.has_value()) {
+            continue;
+        }
+        // GD can open its own RobTop songs by file name out of its
+        // resources instead of the path the getAudioFileName hook returns,
+        // so a preloaded copy might never be found
+        if (id < 0 && nongs.value()->isDefaultActive()) {
+            continue;
+        }
+        const SongPath* songPath = nongs.value()->active()->songPath();
+        if (!songPath) {
+            continue;
+        }
+
+        // Same path the pathForSong and getAudioFileName hooks hand to GD,
+        // and so to FMOD
+        const std::string key = cacheKey(songPath->utf8());
+        const std::filesystem::path path = songPath->absolute();
+
+        std::optional<uintmax_t> found = SongPack::get().size(path);
+        const uintmax_t size = found.value_or(0);
+        {
+            std::lock_guard lock(m_mutex);
+            if (!found.has_value() || !m_cache.accepts(size) ||
+                m_cache.contains(key) || !m_loading.insert(key).second) {
+                continue;
+            }
+        }
+
+        Executor::get().submit(
+            Lane::Background,
+            [path, size](const CancellationToken& token)
+                -> std::optional<PreloadCache::Buffer> {
+                if (token.cancelled()) {
+                    return std::nullopt;
+                }
+                return readFile(path, size);
+            },
+            [this, key](std::optional<PreloadCache::Buffer> data) {
+                std::lock_guard lock(m_mutex);
+                m_loading.erase(key);
+                if (data.has_value()) {
+                    m_cache.insert(key, std::move(data.value()));
+                }
+            },
+            m_token);
+    }
+}
+
+PreloadCache::Buffer AudioPreloader::find(const std::string& path) {
+    const std::string key = cacheKey(path);
+    std::lock_guard lock(m_mutex);
+    return m_cache.find(key);
+}
+
+void AudioPreloader::retain(FMOD::Sound* sound, PreloadCache::Buffer buffer) {
+    std::lock_guard lock(m_mutex);
+    m_playing[sound] = std::move(buffer);
+}
+
+void AudioPreloader::release(FMOD::Sound* sound) {
+    std::lock_guard lock(m_mutex);
+    m_playing.erase(sound);
+}
+
+MemoryEstimate AudioPreloader::estimateMemory() const {
+    std::lock_guard lock(m_mutex);
+
+    MemoryEstimate estimate{m_cache.used(), m_cache.size()};
+    // Evicted buffers that are still playing
+    for (const auto& [sound, buffer] : m_playing) {
+        if (buffer.use_count() == 1) {
+            estimate.bytes += buffer->size();
+            estimate.count++;
+        }
+    }
+    return estimate;
+}
+
+}  // namespace jukebox
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "fmod.hpp"
+
+#include "managers/executor.hpp"
+#include "managers/memory_stats.hpp"
+#include "managers/preload_cache.hpp"
+
+namespace jukebox {
+
+/**
+ * Reads the active songs of a level into memory when its page opens, so
+ * FMOD can open them from there once the level starts instead of going to
+ * disk. Limited by the preload-budget and preload-max-size settings.
+ *
+ * The FMOD hooks call into this from whatever thread FMOD runs them on,
+ * so everything here is guarded by m_mutex.
+ */
+class AudioPreloader {
+protected:
+    mutable std::mutex m_mutex;
+    PreloadCache m_cache{0, 0};
+    // Files being read right now
+    std::unordered_set<std::string> m_loading;
+    // Sounds FMOD reads straight out of a preloaded buffer, kept alive
+    // until FMOD releases them
+    std::unordered_map<FMOD::Sound*, PreloadCache::Buffer> m_playing;
+    // Cancelled when another level page opens
+    CancellationToken m_token;
+
+    AudioPreloader() = default;
+
+    AudioPreloader(const AudioPreloader&) = delete;
+    AudioPreloader(AudioPreloader&&) = delete;
+
+    AudioPreloader& operator=(const AudioPreloader&) = delete;
+    AudioPreloader& operator=(AudioPreloader&&) = delete;
+
+    void applySettings();
+
+public:
+    static AudioPreloader& get() {
+        static AudioPreloader instance;
+        return instance;
+    }
+
+    /**
+     * Starts reading the active song of each ID that isn't preloaded yet.
+     * Main thread only.
+     */
+    void preload(const std::vector<int>& songIDs);
+
+    /**
+     * The preloaded contents of a file, or null
+     */
+    PreloadCache::Buffer find(const std::string& path);
+
+    /**
+     * Keeps a buffer alive while FMOD plays from it
+     */
+    void retain(FMOD::Sound* sound, PreloadCache::Buffer buffer);
+    void release(FMOD::Sound* sound);
+
+    MemoryEstimate estimateMemory() const;
+};
+
+}  // namespace jukebox
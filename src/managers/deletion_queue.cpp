@@ -0,0 +1,218 @@
+#include "managers/deletion_queue.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_set>
+#include <vector>
+
+#include "Geode/loader/Loader.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "managers/executor.hpp"
+#include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
+#include "manifest_snapshot.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+std::filesystem::path DeletionQueue::logPath() {
+    static std::filesystem::path path =
+        Mod::get()->getSaveDir() / "pending-deletes.log";
+    return path;
+}
+
+void DeletionQueue::start() {
+    std::ifstream input(this->logPath(), std::ios_base::binary);
+    if (!input.is_open()) {
+        return;
+    }
+
+    std::unordered_set<std::filesystem::path, PathHash> used;
+    std::shared_ptr<const ManifestSnapshot> snapshot =
+        NongManager::get().snapshot();
+    for (const auto& [id, nongs] : snapshot->nongs()) {
+        for (const SongSnapshot& song : nongs->songs) {
+            if (song.path.has_value()) {
+                used.insert(song.path.value());
+            }
+        }
+    }
+
+    size_t count = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        const std::filesystem::path path(std::u8string(
+            reinterpret_cast<const char8_t*>(line.data()), line.size()));
+        if (used.contains(path)) {
+            continue;
+        }
+        this->enqueue(path);
+        count++;
+    }
+
+    if (count > 0) {
+        log::info("Resuming {} deletions from the last session", count);
+    }
+}
+
+void DeletionQueue::enqueue(const std::filesystem::path& path) {
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_queued.insert(path).second) {
+            return;
+        }
+    }
+    m_batch.push_back(path);
+    this->queueFlush();
+}
+
+bool DeletionQueue::cancel(const std::filesystem::path& path) {
+    {
+        std::unique_lock lock(m_mutex);
+        // Too late to keep it, but the caller mustn't write a new file
+        // before the old one is gone
+        m_deleted.wait(lock, [&]() { return !m_deleting.contains(path); });
+        if (m_queued.erase(path) == 0) {
+            return false;
+        }
+    }
+    // Otherwise the next start would still delete it
+    Executor::get().run(Lane::Background, [this]() { this->writeLog(); });
+    return true;
+}
+
+bool DeletionQueue::pending(const std::filesystem::path& path) {
+    std::lock_guard lock(m_mutex);
+    return m_queued.contains(path) || m_deleting.contains(path);
+}
+
+void DeletionQueue::queueFlush() {
+    if (m_flushQueued) {
+        return;
+    }
+    m_flushQueued = true;
+
+    // Everything deleted in a frame goes out together
+    geode::queueInMainThread([this]() {
+        m_flushQueued = false;
+        std::vector<std::filesystem::path> queued = std::move(m_batch);
+        m_batch.clear();
+
+        for (size_t i = 0; i < queued.size(); i += s_batchSize) {
+            const size_t end = std::min(queued.size(), i + s_batchSize);
+            std::vector<std::filesystem::path> batch(queued.begin() + i,
+                                                     queued.begin() + end);
+            Executor::get().submit(
+                Lane::Background,
+                [this, batch = std::move(batch)](const CancellationToken&) {
+                    return this->deleteBatch(batch);
+                },
+                [this](DeletionStats stats) {
+                    m_freed.files += stats.files;
+                    m_freed.bytes += stats.bytes;
+                    if (stats.files > 0) {
+                        log::info("Deleted {} songs, freed {:.2f}MB",
+                                  stats.files, stats.bytes / 1024.0 / 1024.0);
+                    }
+                });
+        }
+    });
+}
+
+DeletionStats DeletionQueue::deleteBatch(
+    const std::vector<std::filesystem::path>& batch) {
+    // Logged before anything is deleted, so a crash halfway through still
+    // gets finished on the next start
+    this->writeLog();
+
+    DeletionStats stats;
+    for (const std::filesystem::path& path : batch) {
+        // Not held while deleting, a cancel of this path waits for
+        // m_deleted instead
+        {
+            std::lock_guard lock(m_mutex);
+            if (m_queued.erase(path) == 0) {
+                continue;
+            }
+            m_deleting.insert(path);
+        }
+
+        // A song can be packed and loose at once, both copies go
+        uint64_t freed = 0;
+        bool deleted = false;
+        if (std::optional<uintmax_t> packed = SongPack::get().remove(path)) {
+            freed += packed.value();
+            deleted = true;
+        }
+
+        std::error_code ec;
+        const uintmax_t size = std::filesystem::file_size(path, ec);
+        if (!ec) {
+            std::filesystem::remove(path, ec);
+            if (ec) {
+                log::error("Couldn't delete nong {}: {}", path, ec.message());
+            } else {
+                freed += size;
+                deleted = true;
+            }
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_deleting.erase(path);
+        }
+        m_deleted.notify_all();
+
+        if (deleted) {
+            stats.files++;
+            stats.bytes += freed;
+        }
+    }
+
+    this->writeLog();
+    return stats;
+}
+
+void DeletionQueue::writeLog() {
+    std::lock_guard logLock(m_logMutex);
+
+    std::string contents;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const std::filesystem::path& path : m_queued) {
+            const std::u8string utf8 = path.u8string();
+            contents.append(reinterpret_cast<const char*>(utf8.data()),
+                            utf8.size());
+            contents.push_back('\n');
+        }
+    }
+
+    std::error_code ec;
+    if (contents.empty()) {
+        std::filesystem::remove(this->logPath(), ec);
+        return;
+    }
+
+    std::ofstream output(this->logPath(),
+                         std::ios_base::binary | std::ios_base::trunc);
+    if (!output.is_open()) {
+        log::error("Couldn't write {}", this->logPath().string());
+        return;
+    }
+    output.write(contents.data(), contents.size());
+}
+
+}  // namespace jukebox
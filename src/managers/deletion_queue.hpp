@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace jukebox {
+
+struct DeletionStats {
+    size_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * Deletes audio files in batches on a worker, so removing many songs at once
+ * doesn't stall a frame. Queued files count as deleted right away, see
+ * pending().
+ *
+ * Queued paths are kept in a log in the save directory until they're gone,
+ * anything left over from a previous session is deleted on start.
+ */
+class DeletionQueue {
+public:
+    /**
+     * For sets of paths. Never goes through string(), which throws on
+     * Windows for names the ANSI code page can't hold.
+     */
+    struct PathHash {
+        size_t operator()(const std::filesystem::path& path) const {
+            return std::filesystem::hash_value(path);
+        }
+    };
+
+protected:
+    // Shared with the workers
+    std::mutex m_mutex;
+    std::unordered_set<std::filesystem::path, PathHash> m_queued;
+    // Taken off m_queued and being deleted right now, without the lock held
+    std::unordered_set<std::filesystem::path, PathHash> m_deleting;
+    std::condition_variable m_deleted;
+    // Serializes log rewrites, each one writes everything queued at the time
+    std::mutex m_logMutex;
+
+    // Queued this frame, not handed to a worker yet
+    std::vector<std::filesystem::path> m_batch;
+    bool m_flushQueued = false;
+    DeletionStats m_freed;
+
+    DeletionQueue() = default;
+
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue(DeletionQueue&&) = delete;
+
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(DeletionQueue&&) = delete;
+
+    void queueFlush();
+    DeletionStats deleteBatch(const std::vector<std::filesystem::path>& batch);
+    void writeLog();
+
+public:
+    static constexpr size_t s_batchSize = 32;
+
+    std::filesystem::path logPath();
+
+    /**
+     * Queues whatever the log of the last session still lists. Files a song
+     * uses again are left alone.
+     */
+    void start();
+
+    void enqueue(const std::filesystem::path& path);
+    /**
+     * Keeps a queued file. Call before writing a file to a path that might
+     * have been queued, e.g. when downloading a song again. A file that's
+     * being deleted right now can't be kept, this waits until it's gone.
+     *
+     * Returns whether the file was still queued.
+     */
+    bool cancel(const std::filesystem::path& path);
+    bool pending(const std::filesystem::path& path);
+
+    /**
+     * Everything deleted this session
+     */
+    DeletionStats freed() const { return m_freed; }
+
+    static DeletionQueue& get() {
+        static DeletionQueue instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
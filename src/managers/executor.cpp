@@ -0,0 +1,170 @@
+#include "managers/executor.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Geode/loader/Log.hpp"
+#include "Geode/utils/general.hpp"
+
+namespace jukebox {
+
+namespace {
+
+// Index of the worker running on this thread, used to queue work locally
+thread_local std::optional<size_t> s_workerIndex;
+
+size_t workerCountForDevice() {
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+#ifdef GEODE_IS_MOBILE
+    constexpr size_t maxWorkers = 2;
+#else
+    constexpr size_t maxWorkers = 4;
+#endif
+    return std::clamp<size_t>(cores - 1, 1, maxWorkers);
+}
+
+}  // namespace
+
+void Executor::start() {
+    if (!m_threads.empty()) {
+        return;
+    }
+
+    m_stopping = false;
+    const size_t count = workerCountForDevice();
+    for (size_t i = 0; i < count; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; i++) {
+        m_threads.emplace_back([this, i]() { this->workerLoop(i); });
+    }
+
+    geode::log::info("Started {} Jukebox workers", count);
+}
+
+void Executor::shutdown() {
+    if (m_threads.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::thread& thread : m_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    m_threads.clear();
+    m_workers.clear();
+    m_pending = 0;
+}
+
+void Executor::run(Lane lane, Job job, CancellationToken token) {
+    if (m_workers.empty()) {
+        // Not started, or already shut down
+        if (!token.cancelled()) {
+            job();
+        }
+        return;
+    }
+
+    const size_t index =
+        s_workerIndex.value_or(m_nextWorker++ % m_workers.size());
+    {
+        std::lock_guard lock(m_workers[index]->mutex);
+        m_workers[index]->lanes[static_cast<size_t>(lane)].push_back(
+            Work{std::move(job), std::move(token)});
+    }
+
+    {
+        std::lock_guard lock(m_sleepMutex);
+        m_pending++;
+    }
+    m_wake.notify_one();
+}
+
+bool Executor::take(size_t index, Work& out) {
+    const size_t count = m_workers.size();
+
+    for (size_t lane = 0; lane < 3; lane++) {
+        // Own queue from the front, others from the back
+        for (size_t offset = 0; offset < count; offset++) {
+            Worker& worker = *m_workers[(index + offset) % count];
+            std::lock_guard lock(worker.mutex);
+            std::deque<Work>& queue = worker.lanes[lane];
+            if (queue.empty()) {
+                continue;
+            }
+
+            if (offset == 0) {
+                out = std::move(queue.front());
+                queue.pop_front();
+            } else {
+                out = std::move(queue.back());
+                queue.pop_back();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Executor::workerLoop(size_t index) {
+    s_workerIndex = index;
+
+    while (true) {
+        Work work;
+        if (!this->take(index, work)) {
+            std::unique_lock lock(m_sleepMutex);
+            m_wake.wait(lock, [this]() {
+                return m_stopping.load() || m_pending.load() > 0;
+            });
+            if (m_stopping) {
+                return;
+            }
+            continue;
+        }
+
+        m_pending--;
+        if (work.token.cancelled()) {
+            continue;
+        }
+
+        work.job();
+    }
+}
+
+void Executor::runOnMainThread(Job job) {
+    std::lock_guard lock(m_completedMutex);
+    m_completed.push_back(std::move(job));
+    if (m_drainQueued) {
+        return;
+    }
+
+    m_drainQueued = true;
+    geode::queueInMainThread([this]() { this->drainCompleted(); });
+}
+
+void Executor::drainCompleted() {
+    std::vector<Job> completed;
+    {
+        std::lock_guard lock(m_completedMutex);
+        completed.swap(m_completed);
+        m_drainQueued = false;
+    }
+
+    for (Job& job : completed) {
+        job();
+    }
+}
+
+}  // namespace jukebox
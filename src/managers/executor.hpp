@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jukebox {
+
+/**
+ * Priority of background work. A lane only runs when every lane above it
+ * is empty.
+ */
+enum class Lane : uint8_t {
+    // Something the user is waiting on, e.g. a popup loading
+    Interactive,
+    // Ingestion, saving and other work nobody is looking at
+    Background,
+    // Caches and cleanup that can wait until nothing else is queued
+    Idle,
+};
+
+/**
+ * Shared between whoever queued work and the work itself. Cancelled work
+ * is skipped if it hasn't started, running work has to check cancelled()
+ * on its own. Completions of cancelled work never run.
+ */
+class CancellationToken final {
+private:
+    std::shared_ptr<std::atomic_bool> m_cancelled =
+        std::make_shared<std::atomic_bool>(false);
+
+public:
+    void cancel() const { m_cancelled->store(true); }
+    bool cancelled() const { return m_cancelled->load(); }
+};
+
+/**
+ * The worker pool all of Jukebox's background work runs on. Each worker
+ * has its own queues and steals from the others when it runs dry, so a
+ * burst of work queued from one place still spreads over every core.
+ *
+ * Completions are collected and run together on the main thread.
+ */
+class Executor final {
+public:
+    using Job = std::function<void()>;
+
+private:
+    struct Work {
+        Job job;
+        CancellationToken token;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::array<std::deque<Work>, 3> lanes;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic_size_t m_pending = 0;
+    std::atomic_bool m_stopping = false;
+    std::atomic_size_t m_nextWorker = 0;
+
+    std::mutex m_completedMutex;
+    std::vector<Job> m_completed;
+    bool m_drainQueued = false;
+
+    Executor() = default;
+    ~Executor() = default;
+
+    Executor(const Executor&) = delete;
+    Executor(Executor&&) = delete;
+
+    Executor& operator=(const Executor&) = delete;
+    Executor& operator=(Executor&&) = delete;
+
+    void workerLoop(size_t index);
+    bool take(size_t index, Work& out);
+    void drainCompleted();
+
+public:
+    /**
+     * Never destroyed, joining the workers from a static destructor can
+     * hang under the loader lock on Windows. The game exit hook shuts it
+     * down instead, see hooks/app_delegate.cpp.
+     */
+    static Executor& get() {
+        static Executor* instance = new Executor();
+        return *instance;
+    }
+
+    /**
+     * Starts the workers, one less than the core count, capped lower on
+     * mobile so the game keeps a core to itself
+     */
+    void start();
+    /**
+     * Runs whatever is still queued, then stops the workers. Work queued
+     * afterwards runs inline until start() is called again. Main thread
+     * only.
+     */
+    void shutdown();
+
+    size_t workerCount() const { return m_workers.size(); }
+    size_t pending() const { return m_pending.load(); }
+
+    void run(Lane lane, Job job, CancellationToken token = {});
+
+    /**
+     * Runs work on a worker and hands its result to done on the main
+     * thread, unless the token got cancelled in between
+     */
+    template <class W, class D>
+    void submit(Lane lane, W&& work, D&& done, CancellationToken token = {}) {
+        using T = std::invoke_result_t<W&, const CancellationToken&>;
+        this->run(
+            lane,
+            [work = std::forward<W>(work), done = std::forward<D>(done),
+             token]() mutable {
+                // Shared so results that can't be copied still fit a Job
+                auto result = std::make_shared<T>(work(token));
+                if (token.cancelled()) {
+                    return;
+                }
+                Executor::get().runOnMainThread(
+                    [done = std::move(done), result, token]() mutable {
+                        if (!token.cancelled()) {
+                            done(std::move(*result));
+                        }
+                    });
+            },
+            token);
+    }
+
+    /**
+     * Queues a completion. Everything queued before the next frame runs in
+     * one go.
+     */
+    void runOnMainThread(Job job);
+};
+
+}  // namespace jukebox
@@ -0,0 +1,274 @@
+#include "managers/hook_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+#include "Geode/cocos/CCScheduler.h"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "managers/executor.hpp"
+#include "managers/nong_manager.hpp"
+#include "nong.hpp"
+
+namespace jukebox {
+
+namespace {
+
+constexpr char s_magic[4] = {'J', 'B', 'T', 'R'};
+
+void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+class Reader {
+private:
+    const std::vector<uint8_t>& m_data;
+    size_t m_pos = 0;
+
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : m_data(data) {}
+
+    bool done() const { return m_pos >= m_data.size(); }
+
+    std::optional<uint8_t> byte() {
+        if (this->done()) {
+            return std::nullopt;
+        }
+        return m_data[m_pos++];
+    }
+
+    std::optional<uint64_t> varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            std::optional<uint8_t> next = this->byte();
+            if (!next.has_value()) {
+                return std::nullopt;
+            }
+            value |= static_cast<uint64_t>(next.value() & 0x7f) << shift;
+            if (!(next.value() & 0x80)) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+}  // namespace
+
+HookTrace::Scope::Scope(TraceOp op, int songID)
+    : m_op(op), m_songID(songID) {
+    if (HookTrace::get().recording()) {
+        m_start = Clock::now();
+    }
+}
+
+HookTrace::Scope::~Scope() {
+    if (m_start.has_value()) {
+        HookTrace::get().record(m_op, m_songID, m_start.value(), Clock::now());
+    }
+}
+
+std::filesystem::path HookTrace::tracesPath() {
+    return Mod::get()->getSaveDir() / "traces";
+}
+
+void HookTrace::start() {
+    if (m_recording || !Mod::get()->getSettingValue<bool>("record-trace")) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(tracesPath(), ec);
+    if (ec) {
+        log::error("Couldn't create traces folder: {}", ec.message());
+        return;
+    }
+
+    const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::system_clock::now().time_since_epoch())
+                            .count();
+    m_path = tracesPath() / fmt::format("trace-{}.bin", now);
+
+    m_buffer.insert(m_buffer.end(), std::begin(s_magic), std::end(s_magic));
+    m_buffer.push_back(s_version);
+    m_recording = true;
+
+    CCScheduler::get()->scheduleSelector(
+        schedule_selector(HookTrace::tick), this,
+        static_cast<float>(s_flushInterval.count()), false);
+    log::info("Recording hook trace to {}", m_path.string());
+}
+
+uint32_t HookTrace::slot(int songID) {
+    if (auto it = m_slots.find(songID); it != m_slots.end()) {
+        return it->second;
+    }
+
+    TraceShape shape;
+    if (std::optional<Nongs*> nongs = NongManager::get().getNongs(songID)) {
+        shape.present = true;
+        shape.locals = nongs.value()->locals().size();
+        shape.youtube = nongs.value()->youtube().size();
+        shape.hosted = nongs.value()->hosted().size();
+        shape.indexSongs = nongs.value()->indexSongs().size();
+    }
+
+    m_buffer.push_back(s_shapeTag);
+    m_buffer.push_back(shape.present ? 1 : 0);
+    writeVarint(m_buffer, shape.locals);
+    writeVarint(m_buffer, shape.youtube);
+    writeVarint(m_buffer, shape.hosted);
+    writeVarint(m_buffer, shape.indexSongs);
+
+    const uint32_t slot = m_nextSlot++;
+    m_slots.emplace(songID, slot);
+    return slot;
+}
+
+void HookTrace::record(TraceOp op, int songID, Clock::time_point start,
+                       Clock::time_point end) {
+    using std::chrono::duration_cast;
+
+    const uint32_t slot = this->slot(songID);
+
+    std::chrono::microseconds delay{0};
+    if (m_lastEvent.has_value()) {
+        delay = duration_cast<std::chrono::microseconds>(start -
+                                                         m_lastEvent.value());
+    }
+    m_lastEvent = start;
+
+    m_buffer.push_back(static_cast<uint8_t>(op));
+    writeVarint(m_buffer, slot);
+    writeVarint(m_buffer, std::max<int64_t>(delay.count(), 0));
+    writeVarint(m_buffer,
+                duration_cast<std::chrono::nanoseconds>(end - start).count());
+
+    if (m_buffer.size() >= s_flushSize) {
+        this->flush();
+    }
+}
+
+void HookTrace::tick(float) { this->flush(); }
+
+void HookTrace::flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_pendingMutex);
+        m_pending.insert(m_pending.end(), m_buffer.begin(), m_buffer.end());
+    }
+    m_buffer.clear();
+
+    Executor::get().run(Lane::Idle, [this]() { this->writePending(); });
+}
+
+void HookTrace::writePending() {
+    // Taking the pending bytes under the write lock keeps chunks in order
+    std::lock_guard lock(m_writeMutex);
+    std::vector<uint8_t> chunk;
+    {
+        std::lock_guard pendingLock(m_pendingMutex);
+        chunk.swap(m_pending);
+    }
+    if (chunk.empty()) {
+        return;
+    }
+
+    std::ofstream out(m_path, std::ios_base::binary | std::ios_base::app);
+    if (!out.is_open()) {
+        log::error("Couldn't open {} to append the hook trace",
+                   m_path.string());
+        return;
+    }
+    out.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+Result<Trace> HookTrace::read(const std::filesystem::path& path) {
+    std::ifstream input(path, std::ios_base::binary);
+    if (!input.is_open()) {
+        return Err("Couldn't open {}", path.string());
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)),
+                              std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(s_magic) + 1 ||
+        !std::equal(std::begin(s_magic), std::end(s_magic), data.begin())) {
+        return Err("{} isn't a hook trace", path.string());
+    }
+    if (data[sizeof(s_magic)] != s_version) {
+        return Err("Unsupported hook trace version {}",
+                   static_cast<int>(data[sizeof(s_magic)]));
+    }
+
+    Trace trace;
+    Reader reader(data);
+    for (size_t i = 0; i <= sizeof(s_magic); i++) {
+        (void)reader.byte();
+    }
+
+    // A trace cut short by the game closing just loses its last record
+    while (!reader.done()) {
+        const uint8_t tag = reader.byte().value();
+
+        if (tag == s_shapeTag) {
+            std::optional<uint8_t> present = reader.byte();
+            std::optional<uint64_t> locals = reader.varint();
+            std::optional<uint64_t> youtube = reader.varint();
+            std::optional<uint64_t> hosted = reader.varint();
+            std::optional<uint64_t> indexSongs = reader.varint();
+            if (!indexSongs.has_value()) {
+                break;
+            }
+            trace.shapes.push_back(TraceShape{
+                .present = present.value() != 0,
+                .locals = static_cast<uint32_t>(locals.value()),
+                .youtube = static_cast<uint32_t>(youtube.value()),
+                .hosted = static_cast<uint32_t>(hosted.value()),
+                .indexSongs = static_cast<uint32_t>(indexSongs.value())});
+            continue;
+        }
+
+        if (tag > static_cast<uint8_t>(TraceOp::Publish)) {
+            return Err("Unknown record {} in hook trace",
+                       static_cast<int>(tag));
+        }
+
+        std::optional<uint64_t> slot = reader.varint();
+        std::optional<uint64_t> delay = reader.varint();
+        std::optional<uint64_t> duration = reader.varint();
+        if (!duration.has_value()) {
+            break;
+        }
+        if (slot.value() >= trace.shapes.size()) {
+            return Err("Hook trace uses slot {} before defining it",
+                       slot.value());
+        }
+        trace.events.push_back(TraceEvent{
+            .op = static_cast<TraceOp>(tag),
+            .slot = static_cast<uint32_t>(slot.value()),
+            .delay = std::chrono::microseconds(delay.value()),
+            .duration = std::chrono::nanoseconds(duration.value())});
+    }
+
+    return Ok(std::move(trace));
+}
+
+}  // namespace jukebox
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Geode/cocos/cocoa/CCObject.h"
+#include "Geode/Result.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+/**
+ * Calls that end up in a trace. Values are part of the file format, only
+ * append.
+ */
+enum class TraceOp : uint8_t {
+    PathForSong = 0,
+    GetAudioFileName = 1,
+    GetSongInfoObject = 2,
+    GetAudioTitle = 3,
+    LevelCellName = 4,
+    // NongManager::publishSnapshot for one song ID, done after every change
+    Publish = 5,
+};
+
+/**
+ * Manifest entry with everything identifying stripped, only the counts
+ * that decide how much work a lookup does are kept
+ */
+struct TraceShape {
+    // Whether the song ID had a manifest entry when it was first seen
+    bool present = false;
+    uint32_t locals = 0;
+    uint32_t youtube = 0;
+    uint32_t hosted = 0;
+    uint32_t indexSongs = 0;
+};
+
+struct TraceEvent {
+    TraceOp op;
+    // Song IDs are replaced by the order they were first seen in
+    uint32_t slot;
+    // Since the previous event
+    std::chrono::microseconds delay;
+    std::chrono::nanoseconds duration;
+};
+
+struct Trace {
+    // Indexed by slot
+    std::vector<TraceShape> shapes;
+    std::vector<TraceEvent> events;
+};
+
+/**
+ * Records the hooks GD calls while browsing and playing levels into a
+ * compact binary trace in the traces folder of the save directory, so
+ * replayTrace can run the same sequence later. Only records while the
+ * record-trace setting was on at startup.
+ *
+ * File layout, integers are LEB128 unless noted: "JBTR", version (u8),
+ * then records until the end of the file. A record starts with a tag (u8).
+ * s_shapeTag introduces the next slot (present (u8), locals, youtube,
+ * hosted, index songs) right before its first event. Any other tag is a
+ * TraceOp followed by slot, delay in us and duration in ns.
+ */
+class HookTrace : public CCObject {
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    bool m_recording = false;
+    std::filesystem::path m_path;
+    std::unordered_map<int, uint32_t> m_slots;
+    uint32_t m_nextSlot = 0;
+    std::optional<Clock::time_point> m_lastEvent;
+    // Encoded events not handed to the writer yet
+    std::vector<uint8_t> m_buffer;
+
+    // Chunks are appended in the order they were flushed
+    std::mutex m_pendingMutex;
+    std::vector<uint8_t> m_pending;
+    std::mutex m_writeMutex;
+
+    HookTrace() = default;
+
+    HookTrace(const HookTrace&) = delete;
+    HookTrace(HookTrace&&) = delete;
+
+    HookTrace& operator=(const HookTrace&) = delete;
+    HookTrace& operator=(HookTrace&&) = delete;
+
+    uint32_t slot(int songID);
+    void record(TraceOp op, int songID, Clock::time_point start,
+                Clock::time_point end);
+    void tick(float);
+    void flush();
+    void writePending();
+
+public:
+    static constexpr uint8_t s_version = 1;
+    static constexpr uint8_t s_shapeTag = 0xff;
+    static constexpr std::chrono::seconds s_flushInterval{10};
+    // Flush early so a long session doesn't hold on to a big buffer
+    static constexpr size_t s_flushSize = 64 * 1024;
+
+    /**
+     * Times its own lifetime and records it as one call
+     */
+    class Scope {
+    private:
+        TraceOp m_op;
+        int m_songID;
+        std::optional<Clock::time_point> m_start;
+
+    public:
+        Scope(TraceOp op, int songID);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static HookTrace& get() {
+        static HookTrace instance;
+        return instance;
+    }
+
+    static std::filesystem::path tracesPath();
+    static Result<Trace> read(const std::filesystem::path& path);
+
+    /**
+     * Starts a new trace file if the setting is on
+     */
+    void start();
+    bool recording() const { return m_recording; }
+};
+
+}  // namespace jukebox
@@ -1,11 +1,16 @@
 #include "managers/index_manager.hpp"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <ios>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
 #include <variant>
 #include <vector>
 
@@ -18,6 +23,7 @@
 #include "Geode/loader/Event.hpp"
 #include "Geode/loader/Log.hpp"
 #include "Geode/loader/Mod.hpp"
+#include "Geode/utils/file.hpp"
 #include "Geode/utils/general.hpp"
 #include "Geode/utils/web.hpp"
 
@@ -29,7 +35,14 @@
 #include "events/song_error.hpp"
 #include "events/start_download.hpp"
 #include "index.hpp"
+#include "index/binary_index.hpp"
 #include "index_serialize.hpp"
+#include "io/io_backend.hpp"
+#include "managers/deletion_queue.hpp"
+#include "managers/executor.hpp"
+#include "managers/index_registry.hpp"
+#include "managers/link_prober.hpp"
+#include "managers/memory_stats.hpp"
 #include "managers/nong_manager.hpp"
 #include "nong.hpp"
 #include "ui/indexes_setting.hpp"
@@ -38,15 +51,36 @@ namespace jukebox {
 
 using namespace jukebox::index;
 
+namespace {
+
+bool isBinaryResponse(web::WebResponse* response, const std::string& url) {
+    std::optional<std::string> type = response->header("Content-Type");
+    if (type.has_value() && type->starts_with(binary::s_contentType)) {
+        return true;
+    }
+
+    std::string_view path = url;
+    path = path.substr(0, path.find_first_of("?#"));
+    return path.ends_with(binary::s_extension);
+}
+
+}  // namespace
+
 bool IndexManager::init() {
     if (m_initialized) {
         return true;
     }
 
+    if (Result<> res = IndexRegistry::get().load(); res.isErr()) {
+        log::error("{}", res.unwrapErr());
+    }
+    if (Result<> res = LinkProber::get().load(); res.isErr()) {
+        log::error("{}", res.unwrapErr());
+    }
+
     std::filesystem::path path = this->baseIndexesPath();
     if (!std::filesystem::exists(path)) {
         std::filesystem::create_directory(path);
-        return true;
     }
 
     if (Result<> res = this->fetchIndexes(); res.isErr()) {
@@ -71,12 +105,13 @@ std::filesystem::path IndexManager::baseIndexesPath() {
     return path;
 }
 
-Result<> IndexManager::loadIndex(std::filesystem::path path) {
+Result<IndexManager::ParsedIndex> IndexManager::parseIndex(
+    const std::filesystem::path& path, const std::string& url) {
     if (!std::filesystem::exists(path)) {
         return Err("Index file does not exist");
     }
 
-    std::ifstream input(path);
+    std::ifstream input(path, std::ios::binary);
     if (!input.is_open()) {
         return Err(
             fmt::format("Couldn't open file: {}", path.filename().string()));
@@ -89,14 +124,19 @@ Result<> IndexManager::loadIndex(std::filesystem::path path) {
     input.read(&contents[0], contents.size());
     input.close();
 
+    const std::span<const uint8_t> bytes(
+        reinterpret_cast<const uint8_t*>(contents.data()), contents.size());
+    if (binary::isBinary(bytes)) {
+        return parseBinary(bytes, url);
+    }
+
+    ParsedIndex parsed;
+
     GEODE_UNWRAP_INTO(matjson::Value jsonObj, matjson::parse(contents));
     GEODE_UNWRAP_INTO(IndexMetadata indexMeta,
                       matjson::Serialize<IndexMetadata>::fromJson(jsonObj));
 
-    std::unique_ptr<IndexMetadata> index =
-        std::make_unique<IndexMetadata>(std::move(indexMeta));
-
-    this->cacheIndexName(index->m_id, index->m_name);
+    parsed.index = std::make_unique<IndexMetadata>(std::move(indexMeta));
 
     // TODO: re-enable youtube downloads at a later date
     /*for (const auto& [key, ytNong] : jsonObj["nongs"]["youtube"].as_object())
@@ -145,10 +185,8 @@ Result<> IndexManager::loadIndex(std::filesystem::path path) {
         Result<IndexSongMetadata> r =
             matjson::Serialize<IndexSongMetadata>::fromJson(hostedNong);
         if (r.isErr()) {
-            event::SongError(
-                false,
-                fmt::format("Failed to parse index song: {}", r.unwrapErr()))
-                .post();
+            parsed.errors.push_back(
+                fmt::format("Failed to parse index song: {}", r.unwrapErr()));
             continue;
         }
 
@@ -156,8 +194,160 @@ Result<> IndexManager::loadIndex(std::filesystem::path path) {
             std::make_unique<IndexSongMetadata>(r.unwrap());
 
         song->uniqueID = key;
-        song->parentID = index.get();
+        song->parentID = parsed.index.get();
+        parsed.songs.push_back(std::move(song));
+    }
+
+    return Ok(std::move(parsed));
+}
+
+Result<IndexManager::ParsedIndex> IndexManager::parseBinary(
+    std::span<const uint8_t> data, const std::string& url) {
+    GEODE_UNWRAP_INTO(binary::DecodedIndex decoded, binary::decode(data, url));
+
+    ParsedIndex parsed;
+    parsed.index = std::make_unique<IndexMetadata>(std::move(decoded.metadata));
+    parsed.songs = std::move(decoded.songs);
+    for (std::unique_ptr<IndexSongMetadata>& song : parsed.songs) {
+        song->parentID = parsed.index.get();
+    }
+    return Ok(std::move(parsed));
+}
+
+std::filesystem::path IndexManager::snapshotPath() {
+    return Mod::get()->getResourcesDir() / "index-snapshot.zip";
+}
+
+Result<std::vector<IndexManager::ParsedIndex>> IndexManager::readSnapshot(
+    const std::vector<std::string>& urls) {
+    GEODE_UNWRAP_INTO(file::Unzip unzip, file::Unzip::create(snapshotPath()));
+    GEODE_UNWRAP_INTO(ByteVector manifestData, unzip.extract("snapshot.json"));
+    GEODE_UNWRAP_INTO(
+        matjson::Value manifest,
+        matjson::parse(std::string_view(
+            reinterpret_cast<const char*>(manifestData.data()),
+            manifestData.size())));
+    if (!manifest["indexes"].isArray()) {
+        return Err("Index snapshot has no indexes");
+    }
+
+    std::vector<ParsedIndex> ret;
+    for (const matjson::Value& entry : manifest["indexes"].asArray().unwrap()) {
+        const std::string url = entry["url"].asString().unwrapOr("");
+        const std::string file = entry["file"].asString().unwrapOr("");
+        if (file.empty() ||
+            std::find(urls.begin(), urls.end(), url) == urls.end()) {
+            continue;
+        }
+
+        GEODE_UNWRAP_INTO(ByteVector data, unzip.extract(file));
+        GEODE_UNWRAP_INTO(ParsedIndex parsed, parseBinary(data, url));
+        ret.push_back(std::move(parsed));
+    }
+    return Ok(std::move(ret));
+}
+
+void IndexManager::loadSnapshotAsync(std::vector<std::string> urls) {
+    std::error_code ec;
+    if (urls.empty() || !std::filesystem::exists(snapshotPath(), ec)) {
+        return;
+    }
+
+    Executor::get().submit(
+        Lane::Background,
+        [urls = std::move(urls)](const CancellationToken&) {
+            return readSnapshot(urls);
+        },
+        [this](Result<std::vector<ParsedIndex>> res) {
+            if (res.isErr()) {
+                log::error("Couldn't read the index snapshot: {}",
+                           res.unwrapErr());
+                return;
+            }
+            std::vector<ParsedIndex> indexes = std::move(res).unwrap();
+            for (ParsedIndex& parsed : indexes) {
+                log::info("Using the bundled snapshot of {}",
+                          parsed.index->m_url);
+                this->registerIndex(std::move(parsed),
+                                    "Using the bundled snapshot", true);
+            }
+        });
+}
+
+bool IndexManager::isNewerThanSnapshot(const IndexMetadata& index) const {
+    if (!index.m_lastUpdate.has_value()) {
+        return false;
+    }
+    // Holds the snapshot's date until the new data is registered
+    const IndexEntry* entry = IndexRegistry::get().find(index.m_id);
+    return !entry || !entry->lastUpdate.has_value() ||
+           index.m_lastUpdate.value() > entry->lastUpdate.value();
+}
+
+void IndexManager::retireIndex(const std::string& url) {
+    auto it = std::find_if(
+        m_loadedIndexes.begin(), m_loadedIndexes.end(),
+        [&url](const auto& entry) { return entry.second->m_url == url; });
+    if (it == m_loadedIndexes.end()) {
+        return;
+    }
+
+    std::unique_ptr<IndexMetadata> index = std::move(it->second);
+    m_loadedIndexes.erase(it);
+
+    for (const auto* songs :
+         {&index->m_songs.m_youtube, &index->m_songs.m_hosted}) {
+        for (const std::unique_ptr<IndexSongMetadata>& song : *songs) {
+            for (int id : song->songIDs) {
+                std::vector<IndexSongMetadata*>& forId = m_nongsForId[id];
+                std::erase(forId, song.get());
+
+                if (std::optional<Nongs*> nongs =
+                        NongManager::get().getNongs(id)) {
+                    std::erase(nongs.value()->indexSongs(), song.get());
+                }
+            }
+        }
+    }
+
+    m_retiredIndexes.push_back(std::move(index));
+}
+
+void IndexManager::registerIndex(ParsedIndex&& parsed,
+                                 std::optional<std::string> fetchError,
+                                 bool fromSnapshot) {
+    // Index songs are handed out as raw pointers, so a loaded index is kept
+    // for the session. Only one from the snapshot gives way, to a fetch
+    // with newer data. Anything else is cached and used from the next
+    // launch.
+    const std::string url = parsed.index->m_url;
+    if (m_loadedUrls.contains(url)) {
+        if (fromSnapshot || !m_snapshotUrls.contains(url) ||
+            !this->isNewerThanSnapshot(*parsed.index)) {
+            return;
+        }
+        log::info("Replacing the bundled snapshot of {}", url);
+        this->retireIndex(url);
+    }
+    m_loadedUrls.insert(url);
+    if (fromSnapshot) {
+        m_snapshotUrls.insert(url);
+    } else {
+        m_snapshotUrls.erase(url);
+    }
+
+    for (const std::string& error : parsed.errors) {
+        event::SongError(false, error).post();
+    }
 
+    std::unique_ptr<IndexMetadata> index = std::move(parsed.index);
+    IndexRegistry::get().update(*index, std::move(fetchError));
+
+    // Only the songs for IDs in the manifest, the rest may never be seen
+    std::vector<IndexSongMetadata*> relevant;
+
+    for (std::unique_ptr<IndexSongMetadata>& song : parsed.songs) {
+        bool inManifest = false;
         for (int id : song->songIDs) {
             if (!m_nongsForId.contains(id)) {
                 m_nongsForId[id] = {song.get()};
@@ -170,6 +360,7 @@ Result<> IndexManager::loadIndex(std::filesystem::path path) {
             }
 
             Nongs* nongs = opt.value();
+            inManifest = true;
 
             if (geode::Result<> r = nongs->registerIndexSong(song.get());
                 r.isErr()) {
@@ -180,15 +371,46 @@ Result<> IndexManager::loadIndex(std::filesystem::path path) {
             }
         }
 
+        if (inManifest) {
+            relevant.push_back(song.get());
+        }
         index->m_songs.m_youtube.push_back(std::move(song));
     }
 
     IndexMetadata* ref = index.get();
     m_loadedIndexes.emplace(ref->m_id, std::move(index));
+    LinkProber::get().probe(relevant, false);
+}
 
+Result<> IndexManager::loadIndex(std::filesystem::path path,
+                                 const std::string& url) {
+    GEODE_UNWRAP_INTO(ParsedIndex parsed, parseIndex(path, url));
+    this->registerIndex(std::move(parsed), std::nullopt);
     return Ok();
 }
 
+void IndexManager::loadIndexAsync(const std::filesystem::path& path,
+                                  const std::string& url,
+                                  std::optional<std::string> fetchError) {
+    // Reading and parsing is most of the work, only registering the songs
+    // has to happen on the main thread
+    Executor::get().submit(
+        Lane::Background,
+        [path, url](const CancellationToken&) {
+            return parseIndex(path, url);
+        },
+        [this, url, fetchError](Result<ParsedIndex> res) {
+            if (res.isErr()) {
+                IndexRegistry::get().markFailed(url, res.unwrapErr());
+                event::SongError(false, fmt::format("Failed to load index: {}",
+                                                    res.unwrapErr()))
+                    .post();
+                return;
+            }
+            this->registerIndex(std::move(res).unwrap(), fetchError);
+        });
+}
+
 Result<> IndexManager::fetchIndexes() {
     m_indexListeners.clear();
     m_downloadSongListeners.clear();
@@ -196,6 +418,10 @@ Result<> IndexManager::fetchIndexes() {
     GEODE_UNWRAP_INTO(const std::vector<IndexSource> indexes,
                       this->getIndexes());
 
+    // Indexes that were never fetched start out from the snapshot bundled
+    // with the mod, if it has them
+    std::vector<std::string> uncached;
+
     for (const IndexSource& index : indexes) {
         if (!index.m_enabled || index.m_url.size() < 3) {
             continue;
@@ -209,14 +435,45 @@ Result<> IndexManager::fetchIndexes() {
 
         std::filesystem::path filepath =
             this->baseIndexesPath() / fmt::format("{}.json", hashStream.str());
+        std::filesystem::path binaryPath =
+            this->baseIndexesPath() /
+            fmt::format("{}{}", hashStream.str(), binary::s_extension);
+        if (!std::filesystem::exists(filepath) &&
+            !std::filesystem::exists(binaryPath)) {
+            uncached.push_back(index.m_url);
+        }
 
         FetchIndexTask task =
             web::WebRequest()
                 .timeout(std::chrono::seconds(30))
+                .header("Accept",
+                        fmt::format("{}, application/json;q=0.9",
+                                    binary::s_contentType))
                 .get(index.m_url)
                 .map(
-                    [this, filepath, index](
+                    [this, filepath, binaryPath, index](
                         web::WebResponse* response) -> FetchIndexTask::Value {
+                        if (response->ok() &&
+                            isBinaryResponse(response, index.m_url)) {
+                            const ByteVector& data = response->data();
+                            GEODE_UNWRAP(
+                                binary::decodeMetadata(data, index.m_url));
+
+                            std::ofstream output(binaryPath, std::ios::binary);
+                            if (!output.is_open()) {
+                                return Err(fmt::format("Couldn't open file: {}",
+                                                       binaryPath));
+                            }
+                            output.write(
+                                reinterpret_cast<const char*>(data.data()),
+                                data.size());
+                            output.close();
+
+                            std::error_code ec;
+                            std::filesystem::remove(filepath, ec);
+                            return Ok();
+                        }
+
                         if (response->ok() && response->string().isOk()) {
                             GEODE_UNWRAP_INTO(
                                 matjson::Value jsonObj,
@@ -236,6 +493,8 @@ Result<> IndexManager::fetchIndexes() {
                             output << jsonObj.dump(matjson::NO_INDENTATION);
                             output.close();
 
+                            std::error_code ec;
+                            std::filesystem::remove(binaryPath, ec);
                             return Ok();
                         }
                         return Err("Web request failed");
@@ -245,15 +504,16 @@ Result<> IndexManager::fetchIndexes() {
                     });
 
         auto listener = EventListener<FetchIndexTask>();
-        listener.bind([this, index, filepath](FetchIndexTask::Event* event) {
+        listener.bind([this, index, filepath,
+                       binaryPath](FetchIndexTask::Event* event) {
             if (float* progress = event->getProgress()) {
                 return;
             }
 
-            m_indexListeners.erase(index.m_url);
-
+            std::optional<std::string> fetchError;
             if (FetchIndexTask::Value* result = event->getValue()) {
                 if (result->isErr()) {
+                    fetchError = result->unwrapErr();
                     event::SongError(false,
                                      fmt::format("Failed to fetch index: {}",
                                                  result->unwrapErr()))
@@ -262,21 +522,62 @@ Result<> IndexManager::fetchIndexes() {
                     log::info("Index fetched and cached: {}", index.m_url);
                 }
             } else if (event->isCancelled()) {
+                fetchError = "Fetch was cancelled";
             }
 
-            if (Result<> res = this->loadIndex(filepath); res.isErr()) {
-                event::SongError(false, fmt::format("Failed to load index: {}",
-                                                    res.unwrapErr()))
-                    .post();
-            }
+            // Whichever format was cached last, even if this fetch failed
+            this->loadIndexAsync(
+                std::filesystem::exists(binaryPath) ? binaryPath : filepath,
+                index.m_url, std::move(fetchError));
+
+            // Destroys this callback, nothing it captured is used after
+            m_indexListeners.erase(index.m_url);
         });
         listener.setFilter(task);
         m_indexListeners.emplace(index.m_url, std::move(listener));
     }
 
+    this->loadSnapshotAsync(std::move(uncached));
     return Ok();
 }
 
+MemoryEstimate IndexManager::estimateMemory() const {
+    using LoadedEntry = decltype(m_loadedIndexes)::value_type;
+    using SongsEntry = decltype(m_nongsForId)::value_type;
+
+    MemoryEstimate estimate;
+    estimate.bytes = m_loadedIndexes.bucket_count() * sizeof(void*) +
+                     m_nongsForId.bucket_count() * sizeof(void*);
+
+    for (const auto& [id, index] : m_loadedIndexes) {
+        estimate.bytes += memory::node<LoadedEntry>() + memory::heap(id) +
+                          sizeof(IndexMetadata) + memory::heap(index->m_url) +
+                          memory::heap(index->m_id) +
+                          memory::heap(index->m_name) +
+                          memory::heap(index->m_description) +
+                          memory::heap(index->m_songs.m_youtube) +
+                          memory::heap(index->m_songs.m_hosted);
+
+        for (const auto* songs :
+             {&index->m_songs.m_youtube, &index->m_songs.m_hosted}) {
+            for (const std::unique_ptr<IndexSongMetadata>& song : *songs) {
+                estimate.bytes +=
+                    sizeof(IndexSongMetadata) + memory::heap(song->uniqueID) +
+                    memory::heap(song->name) + memory::heap(song->artist) +
+                    memory::heap(song->url) + memory::heap(song->ytId) +
+                    memory::heap(song->songIDs);
+                estimate.count++;
+            }
+        }
+    }
+
+    for (const auto& [id, songs] : m_nongsForId) {
+        estimate.bytes += memory::node<SongsEntry>() + memory::heap(songs);
+    }
+
+    return estimate;
+}
+
 std::optional<float> IndexManager::getSongDownloadProgress(
     const std::string& uniqueID) {
     if (m_downloadSongListeners.contains(uniqueID)) {
@@ -287,21 +588,7 @@ std::optional<float> IndexManager::getSongDownloadProgress(
 
 std::optional<std::string> IndexManager::getIndexName(
     const std::string& indexID) {
-    auto jsonObj =
-        Mod::get()->getSavedValue<matjson::Value>("cached-index-names");
-    if (!jsonObj.contains(indexID)) {
-        return std::nullopt;
-    }
-    return jsonObj[indexID].asString().mapOr<std::optional<std::string>>(
-        std::nullopt, [](auto i) { return std::optional(i); });
-}
-
-void IndexManager::cacheIndexName(const std::string& indexId,
-                                  const std::string& indexName) {
-    auto jsonObj =
-        Mod::get()->getSavedValue<matjson::Value>("cached-index-names", {});
-    jsonObj.set(indexId, indexName);
-    Mod::get()->setSavedValue("cached-index-names", jsonObj);
+    return IndexRegistry::get().name(indexID);
 }
 
 Result<> IndexManager::downloadSong(int gdSongID, const std::string& uniqueID) {
@@ -405,12 +692,21 @@ Result<> IndexManager::downloadSong(int gdSongID, const std::string& uniqueID) {
         [this, indexMeta, local, nongs, gdSongID,
          uniqueID](Result<ByteVector>* vector) {
             if (vector->isErr()) {
+                // Finds out whether the host is gone for good
+                if (indexMeta.has_value()) {
+                    LinkProber::get().recheck(indexMeta.value());
+                }
                 event::SongDownloadFailed(gdSongID, uniqueID,
                                           vector->unwrapErr())
                     .post();
                 return;
             }
 
+            if (indexMeta.has_value()) {
+                LinkProber::get().recordDownload(indexMeta.value(),
+                                                 vector->unwrap().size());
+            }
+
             std::variant<index::IndexSongMetadata*, Song*> source;
 
             if (indexMeta.has_value()) {
@@ -472,19 +768,62 @@ void IndexManager::onDownloadFinish(
         path = NongManager::get().baseNongsPath() / name;
     }
 
-    std::ofstream out(path, std::ios_base::out | std::ios_base::binary);
+    // The song may have been deleted just before, keep the old file around
+    // until it gets overwritten
+    DeletionQueue::get().cancel(path);
+
+    // Songs can be several megabytes, don't write them on the main thread
+    const int songID = destination->songID();
+    const size_t bytes = data.size();
+    MemoryStats::get().charge(MemoryArena::Downloads, bytes);
+    Executor::get().submit(
+        Lane::Interactive,
+        [path, data = std::move(data)](const CancellationToken&) -> Result<> {
+            // Replaced atomically, a crash mid-write keeps the old song
+            return io::backend()
+                .write({io::FileWrite{path, std::span(data)}})
+                .mapErr([](std::string err) {
+                    return fmt::format("Failed to store downloaded file: {}",
+                                       err);
+                });
+        },
+        [this, source, songID, uniqueId, path, bytes](Result<> res) mutable {
+            MemoryStats::get().release(MemoryArena::Downloads, bytes);
 
-    if (!out.is_open()) {
-        const std::string err =
-            "Failed to store downloaded file. Couldn't open file for write";
-        log::error("{}", err);
-        event::SongDownloadFailed(destination->songID(), uniqueId, err).post();
-        return;
-    }
+            if (res.isErr()) {
+                log::error("{}", res.unwrapErr());
+                event::SongDownloadFailed(songID, uniqueId, res.unwrapErr())
+                    .post();
+                return;
+            }
+
+            // Either may have been deleted while the file was written
+            std::optional<Nongs*> nongs = NongManager::get().getNongs(songID);
+            if (nongs.has_value() && std::holds_alternative<Song*>(source)) {
+                std::optional<Song*> song = nongs.value()->findSong(uniqueId);
+                if (song.has_value()) {
+                    source = song.value();
+                } else {
+                    nongs = std::nullopt;
+                }
+            }
+            if (!nongs.has_value()) {
+                const std::string err = "Song was removed during download";
+                log::error("{}", err);
+                event::SongDownloadFailed(songID, uniqueId, err).post();
+                std::error_code ec;
+                std::filesystem::remove(path, ec);
+                return;
+            }
 
-    out.write(reinterpret_cast<const char*>(data.data()), data.size());
-    out.close();
+            this->storeDownload(std::move(source), nongs.value(), path,
+                                uniqueId);
+        });
+}
 
+void IndexManager::storeDownload(
+    std::variant<index::IndexSongMetadata*, Song*>&& source, Nongs* destination,
+    const std::filesystem::path& path, const std::string& uniqueId) {
     Song* insertedSong = nullptr;
 
     if (auto s = std::holds_alternative<Song*>(source)) {
@@ -3,8 +3,12 @@
 #include <filesystem>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
+#include <vector>
 
 #include "Geode/loader/Event.hpp"
 #include "Geode/Result.hpp"
@@ -13,6 +17,7 @@
 
 #include "events/start_download.hpp"
 #include "index.hpp"
+#include "managers/memory_stats.hpp"
 #include "nong.hpp"
 
 using namespace geode::prelude;
@@ -47,15 +52,59 @@ protected:
     // while a song is being downloaded)
     std::unordered_map<std::string, float> m_downloadProgress;
 
+    // Urls of the indexes registered this session
+    std::unordered_set<std::string> m_loadedUrls;
+    // Registered from the bundled snapshot, a newer fetch replaces them
+    std::unordered_set<std::string> m_snapshotUrls;
+    // Replaced indexes. Cells may still point at their songs, so they're
+    // kept for the session.
+    std::vector<std::unique_ptr<index::IndexMetadata>> m_retiredIndexes;
+
     EventListener<EventFilter<event::StartDownload>> m_downloadSignalListener{
         this, &IndexManager::onDownloadStart};
 
+    // Index file contents, parsed off the main thread
+    struct ParsedIndex {
+        std::unique_ptr<index::IndexMetadata> index;
+        std::vector<std::unique_ptr<index::IndexSongMetadata>> songs;
+        std::vector<std::string> errors;
+    };
+
+    /**
+     * Parses a cached index, JSON or binary. Binary indexes don't store
+     * their url, so it's passed along.
+     */
+    static Result<ParsedIndex> parseIndex(const std::filesystem::path& path,
+                                          const std::string& url);
+    static Result<ParsedIndex> parseBinary(std::span<const uint8_t> data,
+                                           const std::string& url);
+    static Result<std::vector<ParsedIndex>> readSnapshot(
+        const std::vector<std::string>& urls);
+    void loadSnapshotAsync(std::vector<std::string> urls);
+    void registerIndex(ParsedIndex&& parsed,
+                       std::optional<std::string> fetchError,
+                       bool fromSnapshot = false);
+    /**
+     * Whether a fetched index is newer than the snapshot registered for it
+     */
+    bool isNewerThanSnapshot(const index::IndexMetadata& index) const;
+    /**
+     * Unregisters the songs of the index loaded from url
+     */
+    void retireIndex(const std::string& url);
+    void loadIndexAsync(const std::filesystem::path& path,
+                        const std::string& url,
+                        std::optional<std::string> fetchError);
+
     geode::ListenerResult onDownloadStart(event::StartDownload* e);
     void onDownloadProgress(int gdSongID, const std::string& uniqueId,
                             float progress);
     void onDownloadFinish(
         std::variant<index::IndexSongMetadata*, Song*>&& source,
         Nongs* destination, ByteVector&& data);
+    void storeDownload(std::variant<index::IndexSongMetadata*, Song*>&& source,
+                       Nongs* destination, const std::filesystem::path& path,
+                       const std::string& uniqueId);
 
 public:
     bool init();
@@ -67,16 +116,27 @@ public:
 
     Result<> fetchIndexes();
 
-    Result<> loadIndex(std::filesystem::path path);
+    Result<> loadIndex(std::filesystem::path path, const std::string& url);
 
     Result<std::vector<index::IndexSource>> getIndexes();
 
+    /**
+     * Rough heap usage of the loaded indexes and their songs
+     */
+    MemoryEstimate estimateMemory() const;
+
     std::optional<float> getSongDownloadProgress(const std::string& uniqueID);
+    /**
+     * Name of any index seen before, loaded or not
+     */
     std::optional<std::string> getIndexName(const std::string& indexID);
-    void cacheIndexName(const std::string& indexId,
-                        const std::string& indexName);
 
     std::filesystem::path baseIndexesPath();
+    /**
+     * Compiled copy of the default indexes shipped with the mod, see
+     * tools/build_index_snapshot.py. Release builds only, it may not exist.
+     */
+    static std::filesystem::path snapshotPath();
 
     Result<> downloadSong(int gdSongID, const std::string& uniqueID);
 
@@ -0,0 +1,261 @@
+#include "managers/index_registry.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Loader.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+#include "Geode/utils/file.hpp"
+
+#include "index.hpp"
+#include "managers/executor.hpp"
+#include "managers/memory_stats.hpp"
+
+namespace jukebox {
+
+namespace {
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+const char* healthName(IndexHealth health) {
+    switch (health) {
+        case IndexHealth::Unknown:
+            return "unknown";
+        case IndexHealth::Ok:
+            return "ok";
+        case IndexHealth::Stale:
+            return "stale";
+        case IndexHealth::Failed:
+            return "failed";
+    }
+    return "unknown";
+}
+
+IndexHealth healthFromName(const std::string& name) {
+    if (name == "ok") {
+        return IndexHealth::Ok;
+    }
+    if (name == "stale") {
+        return IndexHealth::Stale;
+    }
+    if (name == "failed") {
+        return IndexHealth::Failed;
+    }
+    return IndexHealth::Unknown;
+}
+
+}  // namespace
+
+std::filesystem::path IndexRegistry::path() {
+    static std::filesystem::path path =
+        Mod::get()->getSaveDir() / "index-registry.json";
+    return path;
+}
+
+Result<> IndexRegistry::load() {
+    std::error_code ec;
+    if (!std::filesystem::exists(this->path(), ec)) {
+        // Only names were kept before
+        matjson::Value names =
+            Mod::get()->getSavedValue<matjson::Value>("cached-index-names", {});
+        for (const auto& [id, name] : names) {
+            if (name.isString()) {
+                m_entries[id].name = name.asString().unwrap();
+            }
+        }
+        if (!m_entries.empty()) {
+            this->queueSave();
+        }
+        return Ok();
+    }
+
+    GEODE_UNWRAP_INTO(std::string contents,
+                      file::readString(this->path()).mapErr([](auto err) {
+                          return fmt::format(
+                              "Couldn't read index registry: {}", err);
+                      }));
+    GEODE_UNWRAP_INTO(matjson::Value json,
+                      matjson::parse(contents).mapErr([](auto err) {
+                          return fmt::format(
+                              "Couldn't parse index registry: {}", err);
+                      }));
+
+    if (!json.isObject()) {
+        return Err("Index registry is not an object");
+    }
+
+    for (const auto& [id, value] : json) {
+        if (!value.isObject() || !value["name"].isString()) {
+            continue;
+        }
+
+        IndexEntry entry;
+        entry.name = value["name"].asString().unwrap();
+        entry.url = value["url"].asString().unwrapOr("");
+        if (value["last_update"].isNumber()) {
+            entry.lastUpdate = value["last_update"].asInt().unwrap();
+        }
+        entry.health = healthFromName(value["health"].asString().unwrapOr(""));
+        if (value["error"].isString()) {
+            entry.error = value["error"].asString().unwrap();
+        }
+        entry.checkedAt = value["checked_at"].asInt().unwrapOr(0);
+
+        if (!entry.url.empty()) {
+            m_idForUrl[entry.url] = id;
+        }
+        m_entries[id] = std::move(entry);
+    }
+
+    log::info("Loaded {} registered indexes", m_entries.size());
+    return Ok();
+}
+
+std::string IndexRegistry::serialize() const {
+    matjson::Value json = matjson::makeObject({});
+    for (const auto& [id, entry] : m_entries) {
+        matjson::Value value = matjson::makeObject({
+            {"name", entry.name},
+            {"url", entry.url},
+            {"health", healthName(entry.health)},
+            {"checked_at", entry.checkedAt},
+        });
+        if (entry.lastUpdate.has_value()) {
+            value.set("last_update", entry.lastUpdate.value());
+        }
+        if (entry.error.has_value()) {
+            value.set("error", entry.error.value());
+        }
+        json.set(id, value);
+    }
+    return json.dump(matjson::NO_INDENTATION);
+}
+
+Result<> IndexRegistry::write(const std::string& contents) {
+    return file::writeString(this->path(), contents).mapErr([](auto err) {
+        return fmt::format("Couldn't write index registry: {}", err);
+    });
+}
+
+void IndexRegistry::queueSave() {
+    if (m_saveQueued) {
+        return;
+    }
+    m_saveQueued = true;
+
+    // All indexes load around the same time, write them out together
+    geode::queueInMainThread([this]() {
+        m_saveQueued = false;
+
+        const uint64_t generation = ++m_saveGeneration;
+        Executor::get().run(
+            Lane::Idle, [this, contents = this->serialize(), generation]() {
+                std::lock_guard lock(m_writeMutex);
+                // A newer save already made it to disk
+                if (generation <= m_writtenGeneration) {
+                    return;
+                }
+                m_writtenGeneration = generation;
+
+                if (Result<> res = this->write(contents); res.isErr()) {
+                    log::error("{}", res.unwrapErr());
+                }
+            });
+    });
+}
+
+const IndexEntry* IndexRegistry::find(const std::string& indexID) const {
+    auto it = m_entries.find(indexID);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+std::optional<std::string> IndexRegistry::name(
+    const std::string& indexID) const {
+    if (const IndexEntry* entry = this->find(indexID)) {
+        return entry->name;
+    }
+    return std::nullopt;
+}
+
+void IndexRegistry::setHealth(IndexEntry& entry, IndexHealth health,
+                              std::optional<std::string> error) {
+    if (entry.health == health && entry.error == error) {
+        return;
+    }
+    entry.health = health;
+    entry.error = std::move(error);
+    entry.checkedAt = now();
+}
+
+void IndexRegistry::update(const index::IndexMetadata& index,
+                           std::optional<std::string> fetchError) {
+    IndexEntry& entry = m_entries[index.m_id];
+    // Features aren't saved, they don't need a write
+    entry.features = index.m_features;
+
+    const IndexHealth health =
+        fetchError.has_value() ? IndexHealth::Stale : IndexHealth::Ok;
+    if (entry.name == index.m_name && entry.url == index.m_url &&
+        entry.lastUpdate == index.m_lastUpdate && entry.health == health &&
+        entry.error == fetchError) {
+        return;
+    }
+
+    if (entry.url != index.m_url) {
+        m_idForUrl.erase(entry.url);
+        m_idForUrl[index.m_url] = index.m_id;
+    }
+    entry.name = index.m_name;
+    entry.url = index.m_url;
+    entry.lastUpdate = index.m_lastUpdate;
+    this->setHealth(entry, health, std::move(fetchError));
+    this->queueSave();
+}
+
+void IndexRegistry::markFailed(const std::string& url,
+                               const std::string& error) {
+    auto id = m_idForUrl.find(url);
+    if (id == m_idForUrl.end()) {
+        return;
+    }
+    IndexEntry& entry = m_entries[id->second];
+    if (entry.health == IndexHealth::Failed && entry.error == error) {
+        return;
+    }
+    this->setHealth(entry, IndexHealth::Failed, error);
+    this->queueSave();
+}
+
+MemoryEstimate IndexRegistry::estimateMemory() const {
+    MemoryEstimate estimate;
+    estimate.bytes = m_entries.bucket_count() * sizeof(void*) +
+                     m_idForUrl.bucket_count() * sizeof(void*);
+    for (const auto& [id, entry] : m_entries) {
+        estimate.bytes += memory::node<decltype(m_entries)::value_type>() +
+                          memory::heap(id) + memory::heap(entry.name) +
+                          memory::heap(entry.url) + memory::heap(entry.error);
+    }
+    for (const auto& [url, id] : m_idForUrl) {
+        estimate.bytes += memory::node<decltype(m_idForUrl)::value_type>() +
+                          memory::heap(url) + memory::heap(id);
+    }
+    estimate.count = m_entries.size();
+    return estimate;
+}
+
+}  // namespace jukebox
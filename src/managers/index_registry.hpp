@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "Geode/Result.hpp"
+
+#include "index.hpp"
+#include "managers/memory_stats.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+enum class IndexHealth {
+    Unknown,
+    // Fetched and loaded this session
+    Ok,
+    // Fetch failed, the cached copy is in use
+    Stale,
+    // Neither the fetch nor the cached copy worked
+    Failed,
+};
+
+struct IndexEntry final {
+    std::string name;
+    std::string url;
+    std::optional<int> lastUpdate;
+    // Only known once the index was loaded this session
+    std::optional<index::IndexMetadata::Features> features;
+    IndexHealth health = IndexHealth::Unknown;
+    std::optional<std::string> error;
+    // Unix timestamp (seconds) of the last health change
+    int64_t checkedAt = 0;
+};
+
+/**
+ * Index ID -> metadata of every index seen, including ones that aren't
+ * loaded right now, so cells can show index names without any lookups
+ * outside of this map. Saved on a worker, and only when an entry changed.
+ */
+class IndexRegistry {
+protected:
+    std::unordered_map<std::string, IndexEntry> m_entries;
+    std::unordered_map<std::string, std::string> m_idForUrl;
+    bool m_saveQueued = false;
+
+    // Saves are written on a worker, the generations keep an older save
+    // from overwriting a newer one
+    uint64_t m_saveGeneration = 0;
+    std::mutex m_writeMutex;
+    uint64_t m_writtenGeneration = 0;
+
+    IndexRegistry() = default;
+
+    IndexRegistry(const IndexRegistry&) = delete;
+    IndexRegistry(IndexRegistry&&) = delete;
+
+    IndexRegistry& operator=(const IndexRegistry&) = delete;
+    IndexRegistry& operator=(IndexRegistry&&) = delete;
+
+    void queueSave();
+    std::string serialize() const;
+    Result<> write(const std::string& contents);
+    void setHealth(IndexEntry& entry, IndexHealth health,
+                   std::optional<std::string> error);
+
+public:
+    std::filesystem::path path();
+
+    /**
+     * Reads the saved registry, or the index names cached by older versions
+     * if there's none yet
+     */
+    Result<> load();
+
+    const IndexEntry* find(const std::string& indexID) const;
+    std::optional<std::string> name(const std::string& indexID) const;
+
+    /**
+     * Records a loaded index. fetchError is set when the index came from
+     * the cache because fetching it failed.
+     */
+    void update(const index::IndexMetadata& index,
+                std::optional<std::string> fetchError);
+    /**
+     * Marks the index at url as unusable, if it was ever seen before
+     */
+    void markFailed(const std::string& url, const std::string& error);
+
+    MemoryEstimate estimateMemory() const;
+
+    static IndexRegistry& get() {
+        static IndexRegistry instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
@@ -0,0 +1,120 @@
+#include "managers/latency_recorder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+namespace jukebox {
+
+namespace {
+
+constexpr double s_frameMs = 1000.0 / 60.0;
+
+// Nearest rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    const size_t rank = static_cast<size_t>(
+        std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+}  // namespace
+
+LatencyRecorder::Scope::Scope(std::string_view flow) : m_flow(flow) {
+    if (LatencyRecorder::get().enabled()) {
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+LatencyRecorder::Scope::~Scope() {
+    if (m_start.has_value()) {
+        LatencyRecorder::get().record(
+            m_flow, std::chrono::steady_clock::now() - m_start.value());
+    }
+}
+
+bool LatencyRecorder::enabled() const {
+    return m_forced ||
+           geode::Mod::get()->getSettingValue<bool>("record-latency");
+}
+
+void LatencyRecorder::record(std::string_view flow,
+                             std::chrono::nanoseconds duration) {
+    const double ms =
+        std::chrono::duration<double, std::milli>(duration).count();
+
+    std::lock_guard lock(m_mutex);
+    Flow& entry = m_flows[std::string(flow)];
+    if (entry.samples.size() < s_maxSamples) {
+        entry.samples.push_back(ms);
+    } else {
+        entry.samples[entry.next] = ms;
+    }
+    entry.next = (entry.next + 1) % s_maxSamples;
+    entry.total++;
+}
+
+void LatencyRecorder::clear() {
+    std::lock_guard lock(m_mutex);
+    m_flows.clear();
+}
+
+std::optional<LatencySummary> LatencyRecorder::summary(
+    std::string_view flow) const {
+    std::vector<double> samples;
+    size_t total = 0;
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = m_flows.find(std::string(flow));
+        if (it == m_flows.end() || it->second.samples.empty()) {
+            return std::nullopt;
+        }
+        samples = it->second.samples;
+        total = it->second.total;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    return LatencySummary{total, percentile(samples, 50),
+                          percentile(samples, 95), percentile(samples, 99),
+                          samples.back()};
+}
+
+std::vector<std::pair<std::string, LatencySummary>>
+LatencyRecorder::summaries() const {
+    std::vector<std::string> names;
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& [name, flow] : m_flows) {
+            names.push_back(name);
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<std::pair<std::string, LatencySummary>> ret;
+    for (std::string& name : names) {
+        if (std::optional<LatencySummary> summary = this->summary(name)) {
+            ret.emplace_back(std::move(name), summary.value());
+        }
+    }
+    return ret;
+}
+
+void LatencyRecorder::log() const {
+    for (const auto& [name, summary] : this->summaries()) {
+        geode::log::info(
+            "{}: n={} p50={:.3f}ms p95={:.3f}ms p99={:.3f}ms max={:.3f}ms "
+            "({:.1f}% of a frame at p95)",
+            name, summary.count, summary.p50, summary.p95, summary.p99,
+            summary.max, summary.p95 / s_frameMs * 100.0);
+    }
+}
+
+}  // namespace jukebox
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace jukebox {
+
+struct LatencySummary {
+    size_t count;
+    // Milliseconds
+    double p50;
+    double p95;
+    double p99;
+    double max;
+};
+
+/**
+ * Keeps recent timings of user facing flows, like opening the nong popup
+ * or rebuilding its list, so they can be judged against a frame budget.
+ * Only records while the record-latency setting is on, or while the
+ * benchmark runs.
+ */
+class LatencyRecorder {
+protected:
+    struct Flow {
+        // Ring buffer of the most recent samples, in milliseconds
+        std::vector<double> samples;
+        size_t next = 0;
+        size_t total = 0;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, Flow> m_flows;
+    bool m_forced = false;
+
+    static constexpr size_t s_maxSamples = 1024;
+
+    LatencyRecorder() = default;
+
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder(LatencyRecorder&&) = delete;
+
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(LatencyRecorder&&) = delete;
+
+public:
+    /**
+     * Times its own lifetime and records it under a flow name
+     */
+    class Scope {
+    private:
+        std::string_view m_flow;
+        std::optional<std::chrono::steady_clock::time_point> m_start;
+
+    public:
+        // The flow name has to outlive the scope, use a literal
+        explicit Scope(std::string_view flow);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static LatencyRecorder& get() {
+        static LatencyRecorder instance;
+        return instance;
+    }
+
+    bool enabled() const;
+    // Records regardless of the setting, used by the benchmark
+    void setForced(bool forced) { m_forced = forced; }
+
+    void record(std::string_view flow, std::chrono::nanoseconds duration);
+    void clear();
+
+    std::optional<LatencySummary> summary(std::string_view flow) const;
+    std::vector<std::pair<std::string, LatencySummary>> summaries() const;
+
+    /**
+     * Logs one line per flow, with the 95th percentile as a share of a
+     * 60fps frame
+     */
+    void log() const;
+};
+
+}  // namespace jukebox
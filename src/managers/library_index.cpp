@@ -0,0 +1,232 @@
+#include "managers/library_index.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace jukebox {
+
+namespace {
+
+size_t setHeap(const std::unordered_set<int>& ids) {
+    return ids.bucket_count() * sizeof(void*) +
+           ids.size() * memory::node<int>();
+}
+
+template <class K>
+size_t tableHeap(
+    const std::unordered_map<K, std::unordered_set<int>>& table) {
+    size_t bytes = table.bucket_count() * sizeof(void*);
+    for (const auto& [key, ids] : table) {
+        bytes += memory::node<std::pair<const K, std::unordered_set<int>>>() +
+                 setHeap(ids);
+        if constexpr (std::is_same_v<K, std::string>) {
+            bytes += memory::heap(key);
+        }
+    }
+    return bytes;
+}
+
+}  // namespace
+
+std::string LibraryIndex::normalizeArtist(const std::string& artist) {
+    std::string ret = artist;
+    std::transform(ret.begin(), ret.end(), ret.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return ret;
+}
+
+void LibraryIndex::add(const NongsSnapshot& nongs) {
+    const int id = nongs.songID;
+
+    for (const SongSnapshot& song : nongs.songs) {
+        m_byType[song.type].insert(id);
+        if (song.indexID.has_value()) {
+            m_byIndex[song.indexID.value()].insert(id);
+        }
+        m_byArtist[normalizeArtist(song.metadata.artist)].insert(id);
+        (song.downloaded() ? m_downloaded : m_missing).insert(id);
+    }
+
+    const SongSnapshot& def = nongs.defaultSong;
+    m_defaultByArtist[normalizeArtist(def.metadata.artist)].insert(id);
+    (def.downloaded() ? m_defaultDownloaded : m_defaultMissing).insert(id);
+}
+
+void LibraryIndex::remove(const NongsSnapshot& nongs) {
+    const int id = nongs.songID;
+
+    auto erase = [id](std::unordered_map<std::string, IDSet>& map,
+                      const std::string& key) {
+        auto it = map.find(key);
+        if (it == map.end()) {
+            return;
+        }
+        it->second.erase(id);
+        if (it->second.empty()) {
+            map.erase(it);
+        }
+    };
+
+    for (const SongSnapshot& song : nongs.songs) {
+        m_byType[song.type].erase(id);
+        if (song.indexID.has_value()) {
+            erase(m_byIndex, song.indexID.value());
+        }
+        erase(m_byArtist, normalizeArtist(song.metadata.artist));
+    }
+    m_downloaded.erase(id);
+    m_missing.erase(id);
+
+    erase(m_defaultByArtist, normalizeArtist(nongs.defaultSong.metadata.artist));
+    m_defaultDownloaded.erase(id);
+    m_defaultMissing.erase(id);
+}
+
+void LibraryIndex::clear() {
+    m_byType.clear();
+    m_byIndex.clear();
+    m_byArtist.clear();
+    m_downloaded.clear();
+    m_missing.clear();
+    m_defaultByArtist.clear();
+    m_defaultDownloaded.clear();
+    m_defaultMissing.clear();
+}
+
+void LibraryIndex::update(std::shared_ptr<const ManifestSnapshot> snapshot,
+                          const std::vector<Change>& changes) {
+    std::unique_lock lock(m_mutex);
+    for (const Change& change : changes) {
+        if (change.previous) {
+            this->remove(*change.previous);
+        }
+        if (change.next) {
+            this->add(*change.next);
+        }
+    }
+    m_snapshot = std::move(snapshot);
+}
+
+void LibraryIndex::rebuild(std::shared_ptr<const ManifestSnapshot> snapshot) {
+    std::unique_lock lock(m_mutex);
+    this->clear();
+    for (const auto& [id, nongs] : snapshot->nongs()) {
+        this->add(*nongs);
+    }
+    m_snapshot = std::move(snapshot);
+}
+
+LibraryIndex::Candidates LibraryIndex::candidates(const Filter& filter) const {
+    static const IDSet s_empty;
+
+    std::shared_lock lock(m_mutex);
+
+    // Each indexed filter contributes one or two sets, an ID has to be in
+    // at least one set of every filter
+    std::vector<std::vector<const IDSet*>> groups;
+
+    auto lookup = [](const std::unordered_map<std::string, IDSet>& map,
+                     const std::string& key) -> const IDSet* {
+        auto it = map.find(key);
+        return it == map.end() ? &s_empty : &it->second;
+    };
+
+    if (filter.type.has_value()) {
+        auto it = m_byType.find(filter.type.value());
+        const IDSet* custom = it == m_byType.end() ? &s_empty : &it->second;
+        // Default songs are always local, so every ID would match
+        if (!(filter.includeDefaults &&
+              filter.type.value() == NongType::LOCAL)) {
+            groups.push_back({custom});
+        }
+    }
+    if (filter.indexID.has_value()) {
+        // Default songs never come from an index
+        groups.push_back({lookup(m_byIndex, filter.indexID.value())});
+    }
+    if (filter.artist.has_value()) {
+        std::vector<const IDSet*> group = {
+            lookup(m_byArtist, filter.artist.value())};
+        if (filter.includeDefaults) {
+            group.push_back(lookup(m_defaultByArtist, filter.artist.value()));
+        }
+        groups.push_back(std::move(group));
+    }
+    if (filter.downloaded.has_value()) {
+        const bool downloaded = filter.downloaded.value();
+        std::vector<const IDSet*> group = {downloaded ? &m_downloaded
+                                                      : &m_missing};
+        if (filter.includeDefaults) {
+            group.push_back(downloaded ? &m_defaultDownloaded
+                                       : &m_defaultMissing);
+        }
+        groups.push_back(std::move(group));
+    }
+
+    if (groups.empty()) {
+        return Candidates{m_snapshot, std::nullopt};
+    }
+
+    auto groupSize = [](const std::vector<const IDSet*>& group) {
+        size_t size = 0;
+        for (const IDSet* set : group) {
+            size += set->size();
+        }
+        return size;
+    };
+
+    // Walk the smallest group and probe the others
+    std::sort(groups.begin(), groups.end(),
+              [&groupSize](const auto& a, const auto& b) {
+                  return groupSize(a) < groupSize(b);
+              });
+
+    auto inGroup = [](const std::vector<const IDSet*>& group, int id) {
+        for (const IDSet* set : group) {
+            if (set->contains(id)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    IDSet seen;
+    std::vector<int> ids;
+    for (const IDSet* set : groups.front()) {
+        for (int id : *set) {
+            if (!seen.insert(id).second) {
+                continue;
+            }
+            bool matches = true;
+            for (size_t i = 1; i < groups.size() && matches; i++) {
+                matches = inGroup(groups[i], id);
+            }
+            if (matches) {
+                ids.push_back(id);
+            }
+        }
+    }
+
+    return Candidates{m_snapshot, std::move(ids)};
+}
+
+MemoryEstimate LibraryIndex::estimateMemory() const {
+    std::shared_lock lock(m_mutex);
+
+    MemoryEstimate estimate;
+    estimate.bytes = tableHeap(m_byType) + tableHeap(m_byIndex) +
+                     tableHeap(m_byArtist) + setHeap(m_downloaded) +
+                     setHeap(m_missing) + tableHeap(m_defaultByArtist) +
+                     setHeap(m_defaultDownloaded) + setHeap(m_defaultMissing);
+    estimate.count = m_byType.size() + m_byIndex.size() + m_byArtist.size() +
+                     m_defaultByArtist.size();
+    return estimate;
+}
+
+}  // namespace jukebox
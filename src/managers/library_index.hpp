@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "managers/memory_stats.hpp"
+#include "manifest_snapshot.hpp"
+#include "nong.hpp"
+
+namespace jukebox {
+
+/**
+ * Secondary indexes from song attributes to the GD song IDs that have at
+ * least one song matching them. Updated together with every published
+ * snapshot, so lookups always agree with the snapshot they return.
+ */
+class LibraryIndex {
+public:
+    struct Filter {
+        std::optional<NongType> type;
+        std::optional<std::string> indexID;
+        // Already lowercased
+        std::optional<std::string> artist;
+        std::optional<bool> downloaded;
+        bool includeDefaults = false;
+    };
+
+    struct Candidates {
+        std::shared_ptr<const ManifestSnapshot> snapshot;
+        // nullopt when no indexed filter was set, every ID is a candidate
+        std::optional<std::vector<int>> songIDs;
+    };
+
+    // Either entry may be null
+    struct Change {
+        std::shared_ptr<const NongsSnapshot> previous;
+        std::shared_ptr<const NongsSnapshot> next;
+    };
+
+private:
+    using IDSet = std::unordered_set<int>;
+
+    mutable std::shared_mutex m_mutex;
+    std::shared_ptr<const ManifestSnapshot> m_snapshot =
+        std::make_shared<const ManifestSnapshot>();
+
+    // Custom songs only
+    std::unordered_map<NongType, IDSet> m_byType;
+    std::unordered_map<std::string, IDSet> m_byIndex;
+    std::unordered_map<std::string, IDSet> m_byArtist;
+    IDSet m_downloaded;
+    IDSet m_missing;
+
+    // Same keys, but for default songs
+    std::unordered_map<std::string, IDSet> m_defaultByArtist;
+    IDSet m_defaultDownloaded;
+    IDSet m_defaultMissing;
+
+    void add(const NongsSnapshot& nongs);
+    void remove(const NongsSnapshot& nongs);
+    void clear();
+
+public:
+    static std::string normalizeArtist(const std::string& artist);
+
+    /**
+     * Re-indexes the changed song IDs in one go
+     */
+    void update(std::shared_ptr<const ManifestSnapshot> snapshot,
+                const std::vector<Change>& changes);
+
+    void rebuild(std::shared_ptr<const ManifestSnapshot> snapshot);
+
+    Candidates candidates(const Filter& filter) const;
+
+    /**
+     * Rough heap usage of the lookup tables, not counting the snapshot
+     */
+    MemoryEstimate estimateMemory() const;
+};
+
+}  // namespace jukebox
@@ -0,0 +1,499 @@
+#include "managers/link_prober.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Loader.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+#include "Geode/utils/file.hpp"
+#include "Geode/utils/web.hpp"
+
+#include "events/link_probed.hpp"
+#include "index.hpp"
+#include "managers/executor.hpp"
+#include "managers/memory_stats.hpp"
+
+namespace jukebox {
+
+namespace {
+
+// A host that ignores the range header sends the whole song, it's
+// cancelled once it gets past this
+constexpr uint64_t s_rangeLimit = 64 * 1024;
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+template <class Duration>
+int64_t seconds(Duration duration) {
+    return std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+}
+
+std::string hostOf(const std::string& url) {
+    const size_t scheme = url.find("://");
+    const size_t start = scheme == std::string::npos ? 0 : scheme + 3;
+    return url.substr(0, url.find('/', start));
+}
+
+// HTTP/2 hosts send every header name in lowercase
+std::optional<std::string> headerOf(web::WebResponse* response,
+                                    std::string_view name) {
+    if (std::optional<std::string> value = response->header(name)) {
+        return value;
+    }
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return response->header(lower);
+}
+
+std::optional<uint64_t> parseSize(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') {
+        text.remove_prefix(1);
+    }
+    uint64_t ret = 0;
+    auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), ret);
+    if (ec != std::errc() || end == text.data()) {
+        return std::nullopt;
+    }
+    return ret;
+}
+
+std::optional<uint64_t> contentLength(web::WebResponse* response,
+                                      bool range) {
+    // "bytes 0-0/1234", the total is "*" if the host doesn't know it
+    if (response->code() == 206) {
+        std::optional<std::string> header =
+            headerOf(response, "Content-Range");
+        if (!header.has_value()) {
+            return std::nullopt;
+        }
+        const size_t slash = header->rfind('/');
+        if (slash == std::string::npos) {
+            return std::nullopt;
+        }
+        return parseSize(std::string_view(header.value()).substr(slash + 1));
+    }
+
+    if (std::optional<std::string> header =
+            headerOf(response, "Content-Length")) {
+        return parseSize(header.value());
+    }
+    // A range request the host answered with the whole, small, file
+    if (range && !response->data().empty()) {
+        return response->data().size();
+    }
+    return std::nullopt;
+}
+
+LinkState classify(int code) {
+    if (code >= 200 && code < 300) {
+        return LinkState::Alive;
+    }
+    // Timeouts and rate limits say nothing about the file itself
+    if (code >= 400 && code < 500 && code != 408 && code != 429) {
+        return LinkState::Dead;
+    }
+    return LinkState::Unreachable;
+}
+
+}  // namespace
+
+std::filesystem::path LinkProber::path() {
+    static std::filesystem::path path =
+        Mod::get()->getSaveDir() / "link-status.json";
+    return path;
+}
+
+Result<> LinkProber::load() {
+    std::error_code ec;
+    if (!std::filesystem::exists(this->path(), ec)) {
+        return Ok();
+    }
+
+    GEODE_UNWRAP_INTO(std::string contents,
+                      file::readString(this->path()).mapErr([](auto err) {
+                          return fmt::format("Couldn't read link status: {}",
+                                             err);
+                      }));
+    GEODE_UNWRAP_INTO(matjson::Value json,
+                      matjson::parse(contents).mapErr([](auto err) {
+                          return fmt::format("Couldn't parse link status: {}",
+                                             err);
+                      }));
+
+    if (!json.isObject()) {
+        return Err("Link status is not an object");
+    }
+
+    // Entries are stored as
+    // "url": [state, code, length, etag, lastModified, checkedAt]
+    // with a length of -1 when the host didn't send one
+    const int64_t oldest = now() - seconds(s_forgetAfter);
+    for (const auto& [url, value] : json) {
+        if (!value.isArray() || value.size() != 6 || !value[0].isNumber() ||
+            !value[1].isNumber() || !value[2].isNumber() ||
+            !value[3].isString() || !value[4].isString() ||
+            !value[5].isNumber()) {
+            continue;
+        }
+
+        const int state = value[0].asInt().unwrapOr(0);
+        const int64_t checkedAt = value[5].asInt().unwrapOr(0);
+        if (state <= static_cast<int>(LinkState::Unknown) ||
+            state > static_cast<int>(LinkState::Unreachable) ||
+            checkedAt < oldest) {
+            continue;
+        }
+
+        const int64_t length = value[2].asInt().unwrapOr(-1);
+        m_entries[url] = LinkStatus{
+            .state = static_cast<LinkState>(state),
+            .code = static_cast<int>(value[1].asInt().unwrapOr(0)),
+            .contentLength = length >= 0
+                                 ? std::optional(static_cast<uint64_t>(length))
+                                 : std::nullopt,
+            .etag = value[3].asString().unwrap(),
+            .lastModified = value[4].asString().unwrap(),
+            .checkedAt = checkedAt};
+    }
+
+    log::info("Loaded the status of {} index song links", m_entries.size());
+    return Ok();
+}
+
+std::string LinkProber::serialize() const {
+    matjson::Value json = matjson::makeObject({});
+    for (const auto& [url, status] : m_entries) {
+        matjson::Value entry = matjson::Value::array();
+        entry.push(static_cast<int>(status.state));
+        entry.push(status.code);
+        entry.push(status.contentLength.has_value()
+                       ? static_cast<int64_t>(status.contentLength.value())
+                       : int64_t(-1));
+        entry.push(status.etag);
+        entry.push(status.lastModified);
+        entry.push(status.checkedAt);
+        json.set(url, entry);
+    }
+    return json.dump(matjson::NO_INDENTATION);
+}
+
+Result<> LinkProber::write(const std::string& contents) {
+    return file::writeString(this->path(), contents).mapErr([](auto err) {
+        return fmt::format("Couldn't write link status: {}", err);
+    });
+}
+
+void LinkProber::queueSave() {
+    if (m_saveQueued) {
+        return;
+    }
+    m_saveQueued = true;
+
+    // Probes finish in bursts, write them out together
+    geode::queueInMainThread([this]() {
+        m_saveQueued = false;
+
+        const uint64_t generation = ++m_saveGeneration;
+        Executor::get().run(
+            Lane::Idle, [this, contents = this->serialize(), generation]() {
+                std::lock_guard lock(m_writeMutex);
+                // A newer save already made it to disk
+                if (generation <= m_writtenGeneration) {
+                    return;
+                }
+                m_writtenGeneration = generation;
+
+                if (Result<> res = this->write(contents); res.isErr()) {
+                    log::error("{}", res.unwrapErr());
+                }
+            });
+    });
+}
+
+std::optional<LinkStatus> LinkProber::find(const std::string& url) const {
+    auto it = m_entries.find(url);
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+bool LinkProber::isFresh(const LinkStatus& status) const {
+    int64_t ttl = 0;
+    switch (status.state) {
+        case LinkState::Alive:
+            ttl = seconds(s_aliveFor);
+            break;
+        case LinkState::Dead:
+            ttl = seconds(s_deadFor);
+            break;
+        case LinkState::Unreachable:
+            ttl = seconds(s_unreachableFor);
+            break;
+        case LinkState::Unknown:
+            return false;
+    }
+    return now() - status.checkedAt < ttl;
+}
+
+void LinkProber::probe(const std::vector<index::IndexSongMetadata*>& songs,
+                       bool urgent) {
+    if (!Mod::get()->getSettingValue<bool>("probe-index-links")) {
+        return;
+    }
+
+    std::vector<std::string> urls;
+    for (index::IndexSongMetadata* song : songs) {
+        if (!song->url.has_value() || song->url->empty()) {
+            continue;
+        }
+        const std::string& url = song->url.value();
+
+        std::vector<index::IndexSongMetadata*>& known = m_songs[url];
+        if (std::find(known.begin(), known.end(), song) == known.end()) {
+            known.push_back(song);
+        }
+
+        auto it = m_entries.find(url);
+        if (it != m_entries.end() && this->isFresh(it->second)) {
+            continue;
+        }
+        urls.push_back(url);
+    }
+
+    // Urgent urls are put in front one by one, so the first song on
+    // screen has to go in last
+    if (urgent) {
+        std::reverse(urls.begin(), urls.end());
+    }
+    for (const std::string& url : urls) {
+        this->enqueue(url, urgent);
+    }
+    this->pump();
+}
+
+void LinkProber::recheck(index::IndexSongMetadata* song) {
+    if (!song->url.has_value()) {
+        return;
+    }
+    if (auto it = m_entries.find(song->url.value()); it != m_entries.end()) {
+        it->second.checkedAt = 0;
+    }
+    this->probe({song}, true);
+}
+
+void LinkProber::recordDownload(index::IndexSongMetadata* song,
+                                uint64_t size) {
+    if (!song->url.has_value()) {
+        return;
+    }
+    const std::string& url = song->url.value();
+
+    std::vector<index::IndexSongMetadata*>& known = m_songs[url];
+    if (std::find(known.begin(), known.end(), song) == known.end()) {
+        known.push_back(song);
+    }
+
+    LinkStatus status = this->find(url).value_or(LinkStatus());
+    status.state = LinkState::Alive;
+    status.code = 200;
+    status.contentLength = size;
+    status.checkedAt = now();
+    this->record(url, std::move(status));
+}
+
+void LinkProber::enqueue(const std::string& url, bool urgent) {
+    if (m_inFlight.contains(url)) {
+        return;
+    }
+
+    if (m_queued.contains(url)) {
+        if (urgent) {
+            m_queue.erase(std::find(m_queue.begin(), m_queue.end(), url));
+            m_queue.push_front(url);
+        }
+        return;
+    }
+
+    if (!urgent) {
+        if (m_backgroundProbes >= s_maxBackgroundProbes) {
+            return;
+        }
+        m_backgroundProbes++;
+    }
+
+    m_queued.insert(url);
+    if (urgent) {
+        m_queue.push_front(url);
+    } else {
+        m_queue.push_back(url);
+    }
+}
+
+void LinkProber::pump() {
+    while (m_inFlight.size() < s_maxInFlight && !m_queue.empty()) {
+        const std::string url = m_queue.front();
+        m_queue.pop_front();
+        m_queued.erase(url);
+        this->start(url);
+    }
+}
+
+void LinkProber::start(const std::string& url) {
+    const bool range = m_rangeHosts.contains(hostOf(url));
+
+    web::WebRequest request;
+    request.timeout(s_timeout);
+    // Lets an unchanged file answer with a bare 304
+    if (auto it = m_entries.find(url);
+        it != m_entries.end() && it->second.state == LinkState::Alive) {
+        if (!it->second.etag.empty()) {
+            request.header("If-None-Match", it->second.etag);
+        }
+        if (!it->second.lastModified.empty()) {
+            request.header("If-Modified-Since", it->second.lastModified);
+        }
+    }
+
+    web::WebTask task;
+    if (range) {
+        request.header("Range", "bytes=0-0");
+        task = request.get(url);
+    } else {
+        task = request.send("HEAD", url);
+    }
+
+    InFlight& flight = m_inFlight[url];
+    flight.task = task;
+    flight.listener.bind([this, url, range](web::WebTask::Event* event) {
+        if (web::WebProgress* progress = event->getProgress()) {
+            InFlight& flight = m_inFlight.at(url);
+            if (!range || flight.finished ||
+                progress->downloaded() <= s_rangeLimit) {
+                return;
+            }
+            flight.finished = true;
+
+            LinkStatus status = this->find(url).value_or(LinkStatus());
+            status.state = LinkState::Alive;
+            status.code = 200;
+            if (progress->downloadTotal() > 0) {
+                status.contentLength = progress->downloadTotal();
+            }
+            status.checkedAt = now();
+            this->record(url, std::move(status));
+
+            // Ends up back here as a cancellation, which cleans up
+            web::WebTask task = flight.task;
+            task.cancel();
+            return;
+        }
+
+        std::optional<int> code;
+        if (web::WebResponse* response = event->getValue()) {
+            code = response->code();
+            this->onResponse(url, range, response);
+        } else if (!event->isCancelled()) {
+            return;
+        }
+
+        // Hosts without HEAD support get the same url again as a range
+        // request, once this probe is out of the way
+        const bool retry = !range && code.has_value() &&
+                           (code.value() == 405 || code.value() == 501);
+        geode::queueInMainThread([this, url, retry]() {
+            if (retry) {
+                this->enqueue(url, true);
+            }
+            this->pump();
+        });
+
+        // Destroys this callback, nothing it captured is used after
+        m_inFlight.erase(url);
+    });
+    flight.listener.setFilter(task);
+}
+
+void LinkProber::onResponse(const std::string& url, bool range,
+                            web::WebResponse* response) {
+    const int code = response->code();
+    if (!range && (code == 405 || code == 501)) {
+        log::info("{} doesn't take HEAD requests, probing with ranges",
+                  hostOf(url));
+        m_rangeHosts.insert(hostOf(url));
+        return;
+    }
+
+    std::optional<LinkStatus> previous = this->find(url);
+    LinkStatus status;
+    if (code == 304 && previous.has_value()) {
+        status = std::move(previous).value();
+    } else {
+        status.state = classify(code);
+        status.code = code;
+        if (status.state == LinkState::Alive) {
+            status.contentLength = contentLength(response, range);
+            status.etag = headerOf(response, "ETag").value_or("");
+            status.lastModified =
+                headerOf(response, "Last-Modified").value_or("");
+        }
+    }
+    status.checkedAt = now();
+
+    if (status.state == LinkState::Dead) {
+        log::warn("Index song link {} is dead ({})", url, code);
+    }
+    this->record(url, std::move(status));
+}
+
+void LinkProber::record(const std::string& url, LinkStatus status) {
+    m_entries[url] = std::move(status);
+    this->queueSave();
+
+    // Copied, a listener could ask for another probe
+    const std::vector<index::IndexSongMetadata*> songs = m_songs[url];
+    for (index::IndexSongMetadata* song : songs) {
+        for (int id : song->songIDs) {
+            event::LinkProbed(id, song->uniqueID, url).post();
+        }
+    }
+}
+
+MemoryEstimate LinkProber::estimateMemory() const {
+    MemoryEstimate estimate;
+    estimate.bytes = m_entries.bucket_count() * sizeof(void*) +
+                     m_songs.bucket_count() * sizeof(void*);
+    for (const auto& [url, status] : m_entries) {
+        estimate.bytes += memory::node<decltype(m_entries)::value_type>() +
+                          memory::heap(url) + memory::heap(status.etag) +
+                          memory::heap(status.lastModified);
+    }
+    for (const auto& [url, songs] : m_songs) {
+        estimate.bytes += memory::node<decltype(m_songs)::value_type>() +
+                          memory::heap(url) + memory::heap(songs);
+    }
+    estimate.count = m_entries.size();
+    return estimate;
+}
+
+}  // namespace jukebox
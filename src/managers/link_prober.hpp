@@ -0,0 +1,154 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Geode/Result.hpp"
+#include "Geode/loader/Event.hpp"
+#include "Geode/utils/web.hpp"
+
+#include "index.hpp"
+#include "managers/memory_stats.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+enum class LinkState {
+    Unknown,
+    // Answered with a success status
+    Alive,
+    // The host answered, but the file is gone or locked away
+    Dead,
+    // No answer, an error page or rate limiting, might work later
+    Unreachable,
+};
+
+struct LinkStatus final {
+    LinkState state = LinkState::Unknown;
+    // HTTP status of the last probe, 0 if the host didn't answer
+    int code = 0;
+    std::optional<uint64_t> contentLength;
+    // Validators, sent back so an unchanged file is only a 304
+    std::string etag;
+    std::string lastModified;
+    // Unix timestamp (seconds) of the last probe
+    int64_t checkedAt = 0;
+};
+
+/**
+ * Checks the links of index songs before anyone tries to download them,
+ * so dead hosts show up in the list instead of after a 30 second timeout.
+ *
+ * Sends HEAD requests, or a one byte range request to hosts that don't
+ * take HEAD, a few at a time. Results are kept per url with a TTL based on
+ * the outcome and saved to the save dir, so most launches don't probe at
+ * all. Songs in the manifest are probed in the background once indexes
+ * load, songs of an open list jump the queue.
+ *
+ * Main thread only, except for the write of the save file.
+ */
+class LinkProber {
+protected:
+    struct InFlight {
+        web::WebTask task;
+        EventListener<web::WebTask> listener;
+        // Set once the outcome is recorded and the task is being cancelled
+        bool finished = false;
+    };
+
+    std::unordered_map<std::string, LinkStatus> m_entries;
+    // Songs to notify when a url was probed
+    std::unordered_map<std::string, std::vector<index::IndexSongMetadata*>>
+        m_songs;
+
+    std::deque<std::string> m_queue;
+    std::unordered_set<std::string> m_queued;
+    std::unordered_map<std::string, InFlight> m_inFlight;
+    // Hosts that turned down HEAD, probed with a range request instead
+    std::unordered_set<std::string> m_rangeHosts;
+    size_t m_backgroundProbes = 0;
+
+    bool m_saveQueued = false;
+
+    // Saves are written on a worker, the generations keep an older save
+    // from overwriting a newer one
+    uint64_t m_saveGeneration = 0;
+    std::mutex m_writeMutex;
+    uint64_t m_writtenGeneration = 0;
+
+    LinkProber() = default;
+
+    LinkProber(const LinkProber&) = delete;
+    LinkProber(LinkProber&&) = delete;
+
+    LinkProber& operator=(const LinkProber&) = delete;
+    LinkProber& operator=(LinkProber&&) = delete;
+
+    void enqueue(const std::string& url, bool urgent);
+    void pump();
+    void start(const std::string& url);
+    void onResponse(const std::string& url, bool range,
+                    web::WebResponse* response);
+    void record(const std::string& url, LinkStatus status);
+
+    void queueSave();
+    std::string serialize() const;
+    Result<> write(const std::string& contents);
+
+public:
+    static constexpr size_t s_maxInFlight = 4;
+    // Background probes per session, a huge manifest shouldn't turn into
+    // thousands of requests on every launch
+    static constexpr size_t s_maxBackgroundProbes = 256;
+    static constexpr std::chrono::seconds s_timeout{10};
+
+    static constexpr std::chrono::hours s_aliveFor{24};
+    static constexpr std::chrono::hours s_deadFor{6};
+    static constexpr std::chrono::minutes s_unreachableFor{15};
+    // Entries not probed for this long are dropped on load
+    static constexpr std::chrono::hours s_forgetAfter{24 * 30};
+
+    static LinkProber& get() {
+        static LinkProber instance;
+        return instance;
+    }
+
+    std::filesystem::path path();
+
+    Result<> load();
+
+    std::optional<LinkStatus> find(const std::string& url) const;
+    /**
+     * Whether a status is recent enough to skip probing its url again
+     */
+    bool isFresh(const LinkStatus& status) const;
+
+    /**
+     * Probes the links of songs that have no fresh status. Urgent probes
+     * are for songs on screen, they go first and don't count against the
+     * background limit. Does nothing with the probe-index-links setting off.
+     */
+    void probe(const std::vector<index::IndexSongMetadata*>& songs,
+               bool urgent);
+    /**
+     * Probes a song's link again right away, e.g. after its download failed
+     */
+    void recheck(index::IndexSongMetadata* song);
+    /**
+     * A download of the song worked, which says more than any probe
+     */
+    void recordDownload(index::IndexSongMetadata* song, uint64_t size);
+
+    MemoryEstimate estimateMemory() const;
+};
+
+}  // namespace jukebox
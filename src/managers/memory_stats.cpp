@@ -0,0 +1,167 @@
+#include "managers/memory_stats.hpp"
+
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/cocos/CCScheduler.h"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "managers/audio_preloader.hpp"
+#include "managers/index_manager.hpp"
+#include "managers/index_registry.hpp"
+#include "managers/link_prober.hpp"
+#include "managers/nong_manager.hpp"
+#include "managers/song_info_cache.hpp"
+
+namespace jukebox {
+
+namespace {
+
+std::string formatBytes(size_t bytes) {
+    if (bytes >= 1024 * 1024) {
+        return fmt::format("{:.2f}MB", bytes / 1024.0 / 1024.0);
+    }
+    return fmt::format("{:.1f}KB", bytes / 1024.0);
+}
+
+}  // namespace
+
+size_t MemoryReport::total() const {
+    size_t total = 0;
+    for (const MemoryUsage& usage : arenas) {
+        total += usage.total();
+    }
+    return total;
+}
+
+const char* MemoryStats::arenaName(MemoryArena arena) {
+    switch (arena) {
+        case MemoryArena::Manifest:
+            return "manifest";
+        case MemoryArena::Snapshots:
+            return "snapshots";
+        case MemoryArena::Indexes:
+            return "indexes";
+        case MemoryArena::Downloads:
+            return "downloads";
+        case MemoryArena::Caches:
+            return "caches";
+        case MemoryArena::Preload:
+            return "preload";
+    }
+    return "unknown";
+}
+
+void MemoryStats::start() {
+    if (m_started) {
+        return;
+    }
+    m_started = true;
+    CCScheduler::get()->scheduleSelector(
+        schedule_selector(MemoryStats::tick), this,
+        static_cast<float>(s_reportInterval.count()), false);
+}
+
+void MemoryStats::tick(float) {
+    if (!Mod::get()->getSettingValue<bool>("log-memory")) {
+        return;
+    }
+
+    MemoryReport report = this->report();
+    this->log(report);
+    if (Result<> res = this->dump(report); res.isErr()) {
+        geode::log::error("Couldn't write memory report: {}", res.unwrapErr());
+    }
+}
+
+void MemoryStats::charge(MemoryArena arena, size_t bytes) {
+    const size_t i = static_cast<size_t>(arena);
+    m_tracked[i].fetch_add(bytes, std::memory_order_relaxed);
+    m_trackedCount[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MemoryStats::release(MemoryArena arena, size_t bytes) {
+    const size_t i = static_cast<size_t>(arena);
+    m_tracked[i].fetch_sub(bytes, std::memory_order_relaxed);
+    m_trackedCount[i].fetch_sub(1, std::memory_order_relaxed);
+}
+
+MemoryReport MemoryStats::report() const {
+    std::array<MemoryEstimate, s_arenaCount> estimates = {};
+    auto at = [&estimates](MemoryArena arena) -> MemoryEstimate& {
+        return estimates[static_cast<size_t>(arena)];
+    };
+
+    NongManager& nongs = NongManager::get();
+    at(MemoryArena::Manifest) += nongs.estimateManifestMemory();
+    at(MemoryArena::Snapshots) += nongs.estimateSnapshotMemory();
+    at(MemoryArena::Indexes) += IndexManager::get().estimateMemory();
+    at(MemoryArena::Caches) += SongInfoCache::get().estimateMemory();
+    at(MemoryArena::Caches) += nongs.library().estimateMemory();
+    at(MemoryArena::Caches) += IndexRegistry::get().estimateMemory();
+    at(MemoryArena::Caches) += LinkProber::get().estimateMemory();
+    at(MemoryArena::Preload) += AudioPreloader::get().estimateMemory();
+
+    MemoryReport report;
+    report.takenAt = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+    for (size_t i = 0; i < s_arenaCount; i++) {
+        report.arenas.push_back(MemoryUsage{
+            .arena = static_cast<MemoryArena>(i),
+            .estimated = estimates[i].bytes,
+            .tracked = m_tracked[i].load(std::memory_order_relaxed),
+            .count = estimates[i].count +
+                     m_trackedCount[i].load(std::memory_order_relaxed)});
+    }
+    return report;
+}
+
+matjson::Value MemoryStats::toJson(const MemoryReport& report) {
+    matjson::Value arenas = matjson::Value::object();
+    for (const MemoryUsage& usage : report.arenas) {
+        arenas[arenaName(usage.arena)] = matjson::makeObject({
+            {"bytes", usage.total()},
+            {"estimated", usage.estimated},
+            {"tracked", usage.tracked},
+            {"count", usage.count},
+        });
+    }
+
+    return matjson::makeObject({
+        {"taken_at", report.takenAt},
+        {"total", report.total()},
+        {"arenas", arenas},
+    });
+}
+
+std::filesystem::path MemoryStats::dumpPath() const {
+    return Mod::get()->getSaveDir() / "memory.json";
+}
+
+Result<> MemoryStats::dump(const MemoryReport& report) const {
+    std::ofstream output(this->dumpPath());
+    if (!output.is_open()) {
+        return Err("Couldn't open {}", this->dumpPath().string());
+    }
+    output << toJson(report).dump();
+    output.close();
+    return Ok();
+}
+
+void MemoryStats::log(const MemoryReport& report) const {
+    std::string line;
+    for (const MemoryUsage& usage : report.arenas) {
+        line += fmt::format(" {}={} ({})", arenaName(usage.arena),
+                            formatBytes(usage.total()), usage.count);
+    }
+    geode::log::info("Memory: total={}{}", formatBytes(report.total()), line);
+}
+
+}  // namespace jukebox
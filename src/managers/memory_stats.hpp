@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <matjson.hpp>
+#include "Geode/cocos/cocoa/CCObject.h"
+#include "Geode/Result.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+/**
+ * Subsystems memory is reported for
+ */
+enum class MemoryArena : uint8_t {
+    // Nongs and songs owned by NongManager
+    Manifest,
+    // The latest published ManifestSnapshot
+    Snapshots,
+    // Loaded indexes and their songs
+    Indexes,
+    // Downloaded songs waiting to be written to disk
+    Downloads,
+    // Song info cache and library lookup tables
+    Caches,
+    // Song files read ahead for FMOD
+    Preload,
+};
+
+struct MemoryEstimate {
+    size_t bytes = 0;
+    size_t count = 0;
+
+    MemoryEstimate& operator+=(const MemoryEstimate& other) {
+        bytes += other.bytes;
+        count += other.count;
+        return *this;
+    }
+};
+
+struct MemoryUsage {
+    MemoryArena arena;
+    // Walked from the owning manager's containers
+    size_t estimated;
+    // Charged and released by the owner as buffers come and go
+    size_t tracked;
+    // Live objects in the arena, e.g. songs or entries
+    size_t count;
+
+    size_t total() const { return estimated + tracked; }
+};
+
+struct MemoryReport {
+    std::vector<MemoryUsage> arenas;
+    // Unix timestamp (seconds)
+    int64_t takenAt;
+
+    size_t total() const;
+};
+
+/**
+ * Estimates for the heap usage of common containers. They don't know about
+ * allocator overhead, so they're meant for comparing reports over time.
+ */
+namespace memory {
+
+// Zero while the string fits its small buffer
+inline size_t heap(const std::string& str) {
+    return str.capacity() > std::string().capacity() ? str.capacity() + 1 : 0;
+}
+
+inline size_t heap(const std::optional<std::string>& str) {
+    return str.has_value() ? heap(str.value()) : 0;
+}
+
+template <class T>
+size_t heap(const std::vector<T>& vec) {
+    return vec.capacity() * sizeof(T);
+}
+
+// One node of an unordered container holding a T, plus its bucket
+template <class T>
+constexpr size_t node() {
+    return sizeof(T) + 3 * sizeof(void*);
+}
+
+}  // namespace memory
+
+/**
+ * Per subsystem memory accounting. Long lived state is estimated by
+ * walking the owning manager when a report is taken, short lived buffers
+ * are charged and released by whoever holds them.
+ *
+ * With the log-memory setting on, a line is logged and memory.json written
+ * to the save directory every few minutes.
+ */
+class MemoryStats : public CCObject {
+protected:
+    static constexpr size_t s_arenaCount =
+        static_cast<size_t>(MemoryArena::Preload) + 1;
+
+    std::array<std::atomic<size_t>, s_arenaCount> m_tracked = {};
+    std::array<std::atomic<size_t>, s_arenaCount> m_trackedCount = {};
+    bool m_started = false;
+
+    MemoryStats() = default;
+
+    MemoryStats(const MemoryStats&) = delete;
+    MemoryStats(MemoryStats&&) = delete;
+
+    MemoryStats& operator=(const MemoryStats&) = delete;
+    MemoryStats& operator=(MemoryStats&&) = delete;
+
+    void tick(float);
+
+public:
+    static constexpr std::chrono::seconds s_reportInterval{300};
+
+    static MemoryStats& get() {
+        static MemoryStats instance;
+        return instance;
+    }
+
+    static const char* arenaName(MemoryArena arena);
+
+    /**
+     * Schedules the periodic report. Main thread only.
+     */
+    void start();
+
+    /**
+     * Charge or release a buffer. Safe to call from any thread.
+     */
+    void charge(MemoryArena arena, size_t bytes);
+    void release(MemoryArena arena, size_t bytes);
+
+    /**
+     * Walks every subsystem, main thread only
+     */
+    MemoryReport report() const;
+
+    static matjson::Value toJson(const MemoryReport& report);
+
+    std::filesystem::path dumpPath() const;
+    Result<> dump(const MemoryReport& report) const;
+    void log(const MemoryReport& report) const;
+};
+
+}  // namespace jukebox
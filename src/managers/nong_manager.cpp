@@ -1,11 +1,16 @@
 #include "managers/nong_manager.hpp"
 
+#include <chrono>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <vector>
 
 #include <fmt/chrono.h>
 #include <fmt/core.h>
@@ -19,13 +24,84 @@
 
 #include "compat/compat.hpp"
 #include "compat/v2.hpp"
+#include "io/io_backend.hpp"
+#include "managers/deletion_queue.hpp"
+#include "managers/executor.hpp"
+#include "managers/hook_trace.hpp"
 #include "managers/index_manager.hpp"
+#include "managers/memory_stats.hpp"
+#include "managers/song_info_cache.hpp"
+#include "managers/song_info_queue.hpp"
+#include "managers/song_pack.hpp"
 #include "nong.hpp"
 #include "nong_serialize.hpp"
+#include "song_path.hpp"
 #include "utils/random_string.hpp"
 
 namespace jukebox {
 
+namespace {
+
+size_t metadataHeap(const SongMetadata& metadata) {
+    return memory::heap(metadata.uniqueID) + memory::heap(metadata.name) +
+           memory::heap(metadata.artist) + memory::heap(metadata.level);
+}
+
+// Checks for cancellation between files, returns nothing if cancelled
+std::optional<std::string> multiAssetSize(
+    const std::shared_ptr<const ManifestSnapshot>& snapshot,
+    const std::string& songs, const std::string& sfx,
+    const std::filesystem::path& resources,
+    const std::filesystem::path& songDir,
+    const std::function<bool()>& cancelled) {
+    float sum = 0.f;
+    std::istringstream stream(songs);
+    std::string s;
+    while (std::getline(stream, s, ',')) {
+        if (cancelled()) {
+            return std::nullopt;
+        }
+        int id = std::stoi(s);
+        std::shared_ptr<const NongsSnapshot> nongs = snapshot->find(id);
+        if (!nongs || !nongs->active.path.has_value()) {
+            continue;
+        }
+        auto path = nongs->active.path.value();
+        if (path.string().starts_with("songs/")) {
+            path = resources / path;
+        }
+        if (std::optional<uintmax_t> size = SongPack::get().size(path)) {
+            sum += size.value();
+        }
+    }
+    stream = std::istringstream(sfx);
+    while (std::getline(stream, s, ',')) {
+        if (cancelled()) {
+            return std::nullopt;
+        }
+        std::stringstream ss;
+        ss << "s" << s << ".ogg";
+        std::string filename = ss.str();
+        auto localPath = resources / "sfx" / filename;
+        std::error_code _ec;
+        if (std::filesystem::exists(localPath, _ec)) {
+            sum += std::filesystem::file_size(localPath);
+            continue;
+        }
+        auto path = songDir / filename;
+        if (std::filesystem::exists(path, _ec)) {
+            sum += std::filesystem::file_size(path);
+        }
+    }
+
+    double toMegabytes = sum / 1024.f / 1024.f;
+    std::stringstream ss;
+    ss << std::setprecision(3) << toMegabytes << "MB";
+    return ss.str();
+}
+
+}  // namespace
+
 std::optional<Nongs*> NongManager::getNongs(int songID) {
     if (!m_manifest.m_nongs.contains(songID)) {
         return std::nullopt;
@@ -57,15 +133,13 @@ void NongManager::initSongID(SongInfoObject* obj, int id, bool robtop) {
 
     if (obj && robtop) {
         std::string filename = LevelTools::getAudioFileName(id);
-        std::filesystem::path gdDir = std::filesystem::path(
-            CCFileUtils::sharedFileUtils()->getWritablePath2().c_str());
         m_manifest.m_nongs.insert(
             {adjusted,
              std::make_unique<Nongs>(Nongs{
                  adjusted,
                  LocalSong{SongMetadata{adjusted, jukebox::random_string(16),
                                         obj->m_songName, obj->m_artistName},
-                           gdDir / "Resources" / filename}})});
+                           SongPath{PathRoot::Resources, filename}}})});
         initialized = true;
     }
 
@@ -75,12 +149,34 @@ void NongManager::initSongID(SongInfoObject* obj, int id, bool robtop) {
     }
 
     if (!obj && !initialized) {
-        // Try fetch song info from servers
-        MusicDownloadManager::sharedState()->getSongInfo(id, true);
-        m_manifest.m_nongs.insert(
-            {adjusted,
-             std::make_unique<Nongs>(Nongs{id, LocalSong::createUnknown(id)})});
-        return;
+        std::optional<CachedSongInfo> cached = SongInfoCache::get().find(id);
+        if (!cached.has_value()) {
+            // Try fetch song info from servers
+            SongInfoQueue::get().request(id);
+            m_manifest.m_nongs.insert(
+                {adjusted, std::make_unique<Nongs>(
+                               Nongs{id, LocalSong::createUnknown(id)})});
+        } else {
+            // Refresh lazily, the cached info is good enough in the meantime
+            if (SongInfoCache::get().isStale(cached.value())) {
+                SongInfoQueue::get().request(id);
+            }
+
+            m_manifest.m_nongs.insert(
+                {adjusted,
+                 std::make_unique<Nongs>(Nongs{
+                     adjusted,
+                     LocalSong{SongMetadata{adjusted,
+                                            jukebox::random_string(16),
+                                            cached.value().name,
+                                            cached.value().artist},
+                               std::filesystem::path(
+                                   MusicDownloadManager::sharedState()
+                                       ->pathForSong(id)
+                                       .c_str())}})});
+        }
+        // Index songs and the snapshot are set up below either way
+        initialized = true;
     }
 
     if (!initialized) {
@@ -98,15 +194,173 @@ void NongManager::initSongID(SongInfoObject* obj, int id, bool robtop) {
 
     Nongs* nongs = m_manifest.m_nongs[adjusted].get();
     IndexManager::get().registerIndexNongs(nongs);
+    this->publishSnapshot(adjusted);
+}
+
+void NongManager::storeSnapshot(
+    std::shared_ptr<const ManifestSnapshot> snapshot) {
+    std::lock_guard lock(m_snapshotMutex);
+    m_snapshot.swap(snapshot);
+}
+
+void NongManager::publishSnapshot(int songID) {
+    HookTrace::Scope trace(TraceOp::Publish, songID);
+    this->publishSnapshot(std::span<const int>(&songID, 1));
+}
+
+void NongManager::publishSnapshot(std::span<const int> songIDs) {
+    std::shared_ptr<const ManifestSnapshot> current = this->snapshot();
+    const uint64_t version = current->version() + 1;
+
+    // Copy-on-write: every other song ID keeps sharing its previous entry.
+    // The map is copied once per publish, so batches go through here whole.
+    ManifestSnapshot::Entries entries = current->nongs();
+    std::vector<LibraryIndex::Change> changes;
+    changes.reserve(songIDs.size());
+    for (int songID : songIDs) {
+        std::shared_ptr<const NongsSnapshot> next = nullptr;
+        if (std::optional<Nongs*> nongs = this->getNongs(songID)) {
+            next = NongsSnapshot::from(*nongs.value(), version);
+            entries[songID] = next;
+        } else {
+            entries.erase(songID);
+        }
+        changes.push_back({current->find(songID), std::move(next)});
+    }
+
+    auto snapshot =
+        std::make_shared<const ManifestSnapshot>(version, std::move(entries));
+    m_library.update(snapshot, changes);
+    this->storeSnapshot(std::move(snapshot));
+}
+
+void NongManager::publishSnapshot() {
+    const uint64_t version = this->snapshot()->version() + 1;
+
+    // Every audio file is stat'd in one batch instead of one at a time,
+    // which is most of the cost of a full publish on a large library
+    std::vector<std::filesystem::path> paths;
+    auto addPath = [&paths](const Song& song) {
+        if (std::optional<std::filesystem::path> path = song.path()) {
+            paths.push_back(std::move(path.value()));
+        }
+    };
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        addPath(*nongs->defaultSong());
+        for (const std::unique_ptr<LocalSong>& i : nongs->locals()) {
+            addPath(*i);
+        }
+        for (const std::unique_ptr<YTSong>& i : nongs->youtube()) {
+            addPath(*i);
+        }
+        for (const std::unique_ptr<HostedSong>& i : nongs->hosted()) {
+            addPath(*i);
+        }
+    }
+
+    std::vector<std::optional<uintmax_t>> sizes = io::backend().sizes(paths);
+    std::unordered_map<std::filesystem::path, std::optional<uintmax_t>,
+                       DeletionQueue::PathHash>
+        known;
+    known.reserve(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        known.emplace(paths[i], sizes[i]);
+    }
+    auto sizeOf = [&known](const std::filesystem::path& path) {
+        auto it = known.find(path);
+        if (it != known.end() && it->second.has_value()) {
+            return it->second;
+        }
+        // Not loose, might still be packed
+        return SongPack::get().packedSize(path);
+    };
+
+    ManifestSnapshot::Entries entries;
+    entries.reserve(m_manifest.m_nongs.size());
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        entries.emplace(id, NongsSnapshot::from(*nongs, version, sizeOf));
+    }
+
+    auto snapshot =
+        std::make_shared<const ManifestSnapshot>(version, std::move(entries));
+    m_library.rebuild(snapshot);
+    this->storeSnapshot(std::move(snapshot));
+}
+
+MemoryEstimate NongManager::estimateManifestMemory() const {
+    MemoryEstimate estimate;
+    estimate.bytes = m_manifest.m_nongs.bucket_count() * sizeof(void*);
+
+    auto addSong = [&estimate](const Song& song, size_t size) {
+        estimate.bytes += size + sizeof(SongMetadata) +
+                          metadataHeap(*song.metadata()) +
+                          memory::heap(song.indexID());
+        if (const SongPath* path = song.songPath()) {
+            estimate.bytes += memory::heap(path->relative());
+        }
+        estimate.count++;
+    };
+
+    for (const auto& [id, nongs] : m_manifest.m_nongs) {
+        estimate.bytes +=
+            memory::node<std::pair<const int, std::unique_ptr<Nongs>>>() +
+            sizeof(Nongs) + memory::heap(nongs->locals()) +
+            memory::heap(nongs->youtube()) + memory::heap(nongs->hosted()) +
+            memory::heap(nongs->indexSongs());
+
+        addSong(*nongs->defaultSong(), sizeof(LocalSong));
+        for (const std::unique_ptr<LocalSong>& song : nongs->locals()) {
+            addSong(*song, sizeof(LocalSong));
+        }
+        for (const std::unique_ptr<YTSong>& song : nongs->youtube()) {
+            addSong(*song, sizeof(YTSong));
+        }
+        for (const std::unique_ptr<HostedSong>& song : nongs->hosted()) {
+            addSong(*song, sizeof(HostedSong));
+        }
+    }
+
+    return estimate;
+}
+
+MemoryEstimate NongManager::estimateSnapshotMemory() const {
+    std::shared_ptr<const ManifestSnapshot> snapshot = this->snapshot();
+
+    MemoryEstimate estimate;
+    estimate.bytes = sizeof(ManifestSnapshot) +
+                     snapshot->nongs().bucket_count() * sizeof(void*);
+
+    auto addSong = [&estimate](const SongSnapshot& song) {
+        estimate.bytes += metadataHeap(song.metadata) +
+                          memory::heap(song.indexID) +
+                          (song.path.has_value()
+                               ? song.path->native().capacity() *
+                                     sizeof(std::filesystem::path::value_type)
+                               : 0);
+        estimate.count++;
+    };
+
+    for (const auto& [id, nongs] : snapshot->nongs()) {
+        estimate.bytes +=
+            memory::node<ManifestSnapshot::Entries::value_type>() +
+            sizeof(NongsSnapshot) + memory::heap(nongs->songs);
+
+        addSong(nongs->defaultSong);
+        addSong(nongs->active);
+        for (const SongSnapshot& song : nongs->songs) {
+            addSong(song);
+        }
+    }
+
+    return estimate;
 }
 
 std::string NongManager::getFormattedSize(const std::filesystem::path& path) {
-    std::error_code code;
-    auto size = std::filesystem::file_size(path, code);
-    if (code) {
+    std::optional<uintmax_t> size = SongPack::get().size(path);
+    if (!size.has_value()) {
         return "N/A";
     }
-    double toMegabytes = size / 1024.f / 1024.f;
+    double toMegabytes = size.value() / 1024.f / 1024.f;
     std::stringstream ss;
     ss << std::setprecision(3) << toMegabytes << "MB";
     return ss.str();
@@ -119,52 +373,82 @@ NongManager::MultiAssetSizeTask NongManager::getMultiAssetSizes(
         "Resources";
     auto songDir = std::filesystem::path(CCFileUtils::get()->getWritablePath());
 
-    return MultiAssetSizeTask::run(
-        [this, songs, sfx, resources, songDir](
-            auto progress, auto hasBeenCanceled) -> MultiAssetSizeTask::Result {
-            float sum = 0.f;
-            std::istringstream stream(songs);
-            std::string s;
-            while (std::getline(stream, s, ',')) {
-                int id = std::stoi(s);
-                auto result = this->getNongs(id);
-                if (!result.has_value()) {
-                    continue;
-                }
-                auto nongs = result.value();
-                auto path = nongs->active()->path().value();
-                if (path.string().starts_with("songs/")) {
-                    path = resources / path;
-                }
-                if (std::filesystem::exists(path)) {
-                    sum += std::filesystem::file_size(path);
+    // Runs on a worker thread, so read from a snapshot instead of the live
+    // manifest the main thread keeps mutating
+    std::shared_ptr<const ManifestSnapshot> snapshot = this->snapshot();
+
+    // Jobs on an older snapshot count sizes of songs that may have changed
+    const std::string key =
+        fmt::format("{}|{}|{}", songs, sfx, snapshot->version());
+
+    return MultiAssetSizeTask::runWithCallback(
+        [this, key, snapshot, songs, sfx, resources, songDir](
+            auto finish, auto progress, auto hasBeenCanceled) {
+            std::shared_ptr<MultiAssetJob> job;
+            {
+                std::lock_guard lock(m_multiAssetMutex);
+                auto [it, inserted] = m_multiAssetJobs.try_emplace(key);
+                if (!inserted) {
+                    // Another widget already asked for the same assets
+                    it->second->waiters.push_back({finish, hasBeenCanceled});
+                    return;
                 }
+                it->second = std::make_shared<MultiAssetJob>();
+                it->second->waiters.push_back({finish, hasBeenCanceled});
+                job = it->second;
             }
-            stream = std::istringstream(sfx);
-            while (std::getline(stream, s, ',')) {
-                std::stringstream ss;
-                ss << "s" << s << ".ogg";
-                std::string filename = ss.str();
-                auto localPath = resources / "sfx" / filename;
-                std::error_code _ec;
-                if (std::filesystem::exists(localPath, _ec)) {
-                    sum += std::filesystem::file_size(localPath);
-                    continue;
+
+            // The level page is open and waiting on this
+            Executor::get().run(Lane::Interactive, [=, this]() {
+                std::optional<std::string> size = multiAssetSize(
+                    snapshot, songs, sfx, resources, songDir,
+                    [this, &key, &job]() {
+                        return this->multiAssetJobCancelled(key, job);
+                    });
+                if (!size.has_value()) {
+                    return;
                 }
-                auto path = songDir / filename;
-                if (std::filesystem::exists(path, _ec)) {
-                    sum += std::filesystem::file_size(path);
+
+                std::vector<MultiAssetJob::Waiter> waiters;
+                {
+                    std::lock_guard lock(m_multiAssetMutex);
+                    waiters = std::move(job->waiters);
+                    if (auto it = m_multiAssetJobs.find(key);
+                        it != m_multiAssetJobs.end() && it->second == job) {
+                        m_multiAssetJobs.erase(it);
+                    }
                 }
-            }
 
-            double toMegabytes = sum / 1024.f / 1024.f;
-            std::stringstream ss;
-            ss << std::setprecision(3) << toMegabytes << "MB";
-            return ss.str();
+                for (MultiAssetJob::Waiter& waiter : waiters) {
+                    if (!waiter.cancelled()) {
+                        waiter.finish(size.value());
+                    }
+                }
+            });
         },
         "Multiasset calculation");
 }
 
+bool NongManager::multiAssetJobCancelled(
+    const std::string& key, const std::shared_ptr<MultiAssetJob>& job) {
+    std::lock_guard lock(m_multiAssetMutex);
+    std::erase_if(job->waiters, [](const MultiAssetJob::Waiter& waiter) {
+        return waiter.cancelled();
+    });
+    if (!job->waiters.empty()) {
+        return false;
+    }
+
+    // Nobody is waiting anymore. Unlisting the job under the same lock
+    // means a new request starts a fresh calculation instead of joining
+    // this one.
+    if (auto it = m_multiAssetJobs.find(key);
+        it != m_multiAssetJobs.end() && it->second == job) {
+        m_multiAssetJobs.erase(it);
+    }
+    return true;
+}
+
 bool NongManager::init() {
     if (m_initialized) {
         return true;
@@ -176,6 +460,9 @@ bool NongManager::init() {
     });
 
     m_songInfoListener.bind([this](event::GetSongInfo* event) {
+        SongInfoCache::get().store(event->gdSongID(), event->songName(),
+                                   event->artistName());
+
         std::optional<Nongs*> nongs = this->getNongs(event->gdSongID());
         if (!nongs.has_value()) {
             return ListenerResult::Stop;
@@ -195,47 +482,39 @@ bool NongManager::init() {
         return ListenerResult::Propagate;
     });
 
+    if (Result<> res = SongInfoCache::get().load(); res.isErr()) {
+        log::error("{}", res.unwrapErr());
+    }
+
     log::info("Starting NONG read");
 
-    auto path = this->baseManifestPath();
-    if (!std::filesystem::exists(path)) {
-        log::info("No manifest directory found. Creating...");
-        std::filesystem::create_directory(path);
-    }
+    // Must be set before any song is loaded, paths are split against them
+    SongPath::setRoot(PathRoot::Nongs, this->baseNongsPath());
+    SongPath::setRoot(PathRoot::Songs,
+                      std::filesystem::path(
+                          CCFileUtils::get()->getWritablePath().c_str()));
+    SongPath::setRoot(PathRoot::Resources,
+                      std::filesystem::path(
+                          CCFileUtils::get()->getWritablePath2().c_str()) /
+                          "Resources");
+
     auto nongsPath = this->baseNongsPath();
     if (!std::filesystem::exists(nongsPath)) {
         std::filesystem::create_directory(nongsPath);
     }
 
-    for (const std::filesystem::directory_entry& entry :
-         std::filesystem::directory_iterator(path)) {
-        if (entry.path().extension() != ".json") {
-            continue;
-        }
-
-        auto res = this->loadNongsFromPath(entry.path());
-        if (res.isErr()) {
-            log::error("Failed to read file {}: {}", entry.path().filename(),
-                       res.unwrapErr());
-            std::filesystem::rename(
-                entry.path(),
-                path / fmt::format("{}.bak", entry.path().filename().string()));
-            continue;
-        }
-
-        std::unique_ptr<Nongs> ptr = std::move(res.unwrap());
-        int id = ptr->songID();
-
-        m_manifest.m_nongs.insert({id, std::move(ptr)});
+    m_storage = storage::createStorageBackend();
+    if (Result<> res = this->loadNongs(); res.isErr()) {
+        log::error("Failed to read manifest: {}", res.unwrapErr());
     }
 
-    log::info("Read {} files successfuly!", m_manifest.m_nongs.size());
-
     Result<> res = this->migrateV2();
     if (res.isErr()) {
         log::error("{}", res.unwrapErr());
     }
 
+    this->publishSnapshot();
+
     m_initialized = true;
     return true;
 }
@@ -321,53 +600,54 @@ Result<> NongManager::saveNongs(std::optional<int> saveID) {
     return Ok();
 }
 
-Result<std::unique_ptr<Nongs>> NongManager::loadNongsFromPath(
-    const std::filesystem::path& path) {
-    auto stem = path.stem().string();
-    // Watch someone edit a json name and have the game crash
-    int id = std::stoi(stem);
-    if (id == 0) {
-        return Err(
-            fmt::format("Invalid filename {}", path.filename().string()));
-    }
-
-    std::ifstream input(path);
-    if (!input.is_open()) {
-        return Err(
-            fmt::format("Couldn't open file: {}", path.filename().string()));
-    }
-
-    // Did some brief research, this seems to be the most efficient method
-    // https://insanecoding.blogspot.com/2011/11/how-to-read-in-file-in-c.html
-
-    std::string contents;
-    input.seekg(0, std::ios::end);
-    contents.resize(input.tellg());
-    input.seekg(0, std::ios::beg);
-    input.read(&contents[0], contents.size());
-    input.close();
-
-    GEODE_UNWRAP_INTO(matjson::Value json,
-                      matjson::parse(std::string_view(contents))
-                          .mapErr([id](std::string err) {
-                              return fmt::format(
-                                  "{}: Couldn't parse JSON from file: {}", id,
-                                  err);
-                          }));
-
-    GEODE_UNWRAP_INTO(Nongs nongs,
-                      matjson::Serialize<Nongs>::fromJson(json, id).mapErr(
-                          [id](std::string err) {
-                              return fmt::format("{}: Failed to parse JSON: {}",
-                                                 id, err);
-                          }));
-
-    return Ok(std::make_unique<Nongs>(std::move(nongs)));
+Result<> NongManager::loadNongs() {
+    auto start = std::chrono::steady_clock::now();
+
+    GEODE_UNWRAP(m_storage->open());
+
+    std::vector<int> broken;
+    GEODE_UNWRAP(m_storage->forEach([this, &broken](
+                                        int id, Result<matjson::Value> record) {
+        if (record.isErr()) {
+            log::error("Failed to read song {}: {}", id, record.unwrapErr());
+            broken.push_back(id);
+            return;
+        }
+
+        Result<Nongs> nongs =
+            matjson::Serialize<Nongs>::fromJson(record.unwrap(), id);
+        if (nongs.isErr()) {
+            log::error("Failed to read song {}: {}", id, nongs.unwrapErr());
+            broken.push_back(id);
+            return;
+        }
+
+        m_manifest.m_nongs.insert(
+            {id, std::make_unique<Nongs>(std::move(nongs.unwrap()))});
+    }));
+
+    for (int id : broken) {
+        if (Result<> res = m_storage->quarantine(id); res.isErr()) {
+            log::error("{}", res.unwrapErr());
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    log::info("Read {} songs from the {} backend in {}",
+              m_manifest.m_nongs.size(), m_storage->name(), elapsed);
+
+    return Ok();
 }
 
-void NongManager::refetchDefault(int songID) {
+void NongManager::refetchDefault(int songID,
+                                 std::function<void(bool)> callback) {
     MusicDownloadManager::sharedState()->clearSong(songID);
-    MusicDownloadManager::sharedState()->getSongInfo(songID, true);
+    SongInfoQueue::get().request(songID, std::move(callback));
+}
+
+void NongManager::resolveSongInfoCallback(int id) {
+    SongInfoQueue::get().resolve(id);
 }
 
 Result<> NongManager::addNongs(Nongs&& nongs) {
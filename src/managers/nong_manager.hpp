@@ -1,8 +1,14 @@
 #pragma once
 
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Geode/binding/SongInfoObject.hpp"
 #include "Geode/loader/Event.hpp"
@@ -11,16 +17,51 @@
 
 #include "events/get_song_info.hpp"
 #include "events/song_error.hpp"
+#include "managers/library_index.hpp"
+#include "managers/memory_stats.hpp"
+#include "manifest_snapshot.hpp"
 #include "nong.hpp"
+#include "storage/storage_backend.hpp"
 
 using namespace geode::prelude;
 
 namespace jukebox {
 
+class Transaction;
+
 class NongManager {
 protected:
+    friend class Transaction;
+
     Manifest m_manifest;
     bool m_initialized = false;
+    // Set while a Transaction is being applied
+    bool m_batching = false;
+
+    // Read from any thread. The mutex is only held to copy or swap the
+    // pointer, the atomic shared_ptr functions are deprecated in C++20 and
+    // std::atomic<std::shared_ptr> is missing from libc++.
+    std::shared_ptr<const ManifestSnapshot> m_snapshot =
+        std::make_shared<const ManifestSnapshot>();
+    mutable std::mutex m_snapshotMutex;
+    LibraryIndex m_library;
+    std::unique_ptr<storage::StorageBackend> m_storage;
+
+    // Size calculations in flight, shared by every widget asking for the
+    // same assets. Touched from workers, so guarded by m_multiAssetMutex.
+    struct MultiAssetJob {
+        struct Waiter {
+            std::function<void(std::string)> finish;
+            std::function<bool()> cancelled;
+        };
+        std::vector<Waiter> waiters;
+    };
+    std::mutex m_multiAssetMutex;
+    std::unordered_map<std::string, std::shared_ptr<MultiAssetJob>>
+        m_multiAssetJobs;
+
+    bool multiAssetJobCancelled(const std::string& key,
+                                const std::shared_ptr<MultiAssetJob>& job);
 
     NongManager() = default;
     NongManager(const NongManager&) = delete;
@@ -29,6 +70,9 @@ protected:
     NongManager& operator=(const NongManager&) = delete;
     NongManager& operator=(NongManager&&) = delete;
 
+    // Swaps in a new snapshot, the previous one is released after unlocking
+    void storeSnapshot(std::shared_ptr<const ManifestSnapshot> snapshot);
+
     void setupManifestPath() {
         auto path = this->baseManifestPath();
         if (!std::filesystem::exists(path)) {
@@ -39,8 +83,7 @@ protected:
     Result<> saveNongs(std::optional<int> saveId = std::nullopt);
     EventListener<EventFilter<jukebox::event::SongError>> m_songErrorListener;
     EventListener<EventFilter<jukebox::event::GetSongInfo>> m_songInfoListener;
-    Result<std::unique_ptr<Nongs>> loadNongsFromPath(
-        const std::filesystem::path& path);
+    Result<> loadNongs();
 
     Result<> migrateV2();
 
@@ -52,6 +95,53 @@ public:
 
     bool initialized() const { return m_initialized; }
 
+    /**
+     * Whether Nongs mutations should post their own events. False before
+     * init and while a transaction is applied.
+     */
+    bool shouldPostEvents() const { return m_initialized && !m_batching; }
+
+    /**
+     * Gets the latest published manifest snapshot. Safe to call from any
+     * thread, the snapshot stays valid for as long as it's held.
+     */
+    std::shared_ptr<const ManifestSnapshot> snapshot() const {
+        std::lock_guard lock(m_snapshotMutex);
+        return m_snapshot;
+    }
+
+    /**
+     * Persistence for the manifest. Only valid after init.
+     */
+    storage::StorageBackend& storage() { return *m_storage; }
+
+    /**
+     * Secondary indexes over the published snapshot, used by LibraryQuery
+     */
+    const LibraryIndex& library() const { return m_library; }
+
+    /**
+     * Rough heap usage of the manifest and of the latest published
+     * snapshot. Main thread only.
+     */
+    MemoryEstimate estimateManifestMemory() const;
+    MemoryEstimate estimateSnapshotMemory() const;
+
+    /**
+     * Publishes a new snapshot with the current state of a song ID. Must be
+     * called from the main thread after mutating its Nongs.
+     */
+    void publishSnapshot(int songID);
+    /**
+     * Same for several song IDs, published as one snapshot
+     */
+    void publishSnapshot(std::span<const int> songIDs);
+
+    /**
+     * Publishes a new snapshot of the whole manifest
+     */
+    void publishSnapshot();
+
     std::filesystem::path baseManifestPath() {
         static std::filesystem::path path =
             Mod::get()->getSaveDir() / "manifest";
@@ -107,6 +197,9 @@ public:
      * Runs on a separate thread. Returns a task that will resolve to the total
      * size.
      *
+     * Identical requests in flight share one calculation. It stops between
+     * files once every task waiting on it has been cancelled.
+     *
      * @param songs string of song ids, separated by commas
      * @param sfx string of sfx ids, separated by commas
      */
@@ -115,8 +208,9 @@ public:
     /**
      * Add actions needed to fix a broken song default
      * @param songID id of the song
+     * @param callback called with whether the song info could be refetched
      */
-    void refetchDefault(int songID);
+    void refetchDefault(int songID, std::function<void(bool)> callback = {});
 
     /**
      * Add NONGs
@@ -0,0 +1,70 @@
+#include "managers/preload_cache.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jukebox {
+
+void PreloadCache::evict(size_t needed) {
+    while (!m_lru.empty() && m_used + needed > m_budget) {
+        this->erase(m_lru.back());
+    }
+}
+
+bool PreloadCache::insert(const std::string& key, Buffer data) {
+    if (!data || !this->accepts(data->size())) {
+        return false;
+    }
+
+    this->erase(key);
+    this->evict(data->size());
+
+    m_lru.push_front(key);
+    m_used += data->size();
+    m_entries.emplace(key, Entry{std::move(data), m_lru.begin()});
+    return true;
+}
+
+PreloadCache::Buffer PreloadCache::find(const std::string& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return it->second.data;
+}
+
+void PreloadCache::erase(const std::string& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_used -= it->second.data->size();
+    m_lru.erase(it->second.lru);
+    m_entries.erase(it);
+}
+
+void PreloadCache::clear() {
+    m_entries.clear();
+    m_lru.clear();
+    m_used = 0;
+}
+
+void PreloadCache::setLimits(size_t budget, size_t maxFileSize) {
+    m_budget = budget;
+    m_maxFileSize = maxFileSize;
+
+    std::vector<std::string> tooBig;
+    for (const auto& [key, entry] : m_entries) {
+        if (!this->accepts(entry.data->size())) {
+            tooBig.push_back(key);
+        }
+    }
+    for (const std::string& key : tooBig) {
+        this->erase(key);
+    }
+    this->evict(0);
+}
+
+}  // namespace jukebox
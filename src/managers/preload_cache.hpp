@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace jukebox {
+
+/**
+ * Byte budgeted LRU of whole song files. Only does the bookkeeping, so it
+ * doesn't depend on the game or FMOD.
+ *
+ * Buffers are shared, evicting one only drops the cache's reference. A
+ * sound still playing from it keeps it alive.
+ */
+class PreloadCache {
+public:
+    using Buffer = std::shared_ptr<const std::vector<uint8_t>>;
+
+protected:
+    struct Entry {
+        Buffer data;
+        std::list<std::string>::iterator lru;
+    };
+
+    size_t m_budget;
+    size_t m_maxFileSize;
+    size_t m_used = 0;
+    std::unordered_map<std::string, Entry> m_entries;
+    // Most recently used first
+    std::list<std::string> m_lru;
+
+    void evict(size_t needed);
+
+public:
+    PreloadCache(size_t budget, size_t maxFileSize)
+        : m_budget(budget), m_maxFileSize(maxFileSize) {}
+
+    /**
+     * Whether a file of this size would be kept at all
+     */
+    bool accepts(size_t size) const {
+        return size > 0 && size <= m_maxFileSize && size <= m_budget;
+    }
+
+    /**
+     * Stores a file, evicting the least recently used ones until it fits.
+     * Returns false if the file is rejected by the size limits.
+     */
+    bool insert(const std::string& key, Buffer data);
+
+    /**
+     * Returns the buffer for a key and marks it as recently used
+     */
+    Buffer find(const std::string& key);
+    bool contains(const std::string& key) const {
+        return m_entries.contains(key);
+    }
+
+    void erase(const std::string& key);
+    void clear();
+
+    /**
+     * Changes the limits, evicting what no longer fits
+     */
+    void setLimits(size_t budget, size_t maxFileSize);
+
+    size_t used() const { return m_used; }
+    size_t budget() const { return m_budget; }
+    size_t size() const { return m_entries.size(); }
+};
+
+}  // namespace jukebox
@@ -0,0 +1,170 @@
+#include "managers/song_info_cache.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Loader.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+#include "Geode/utils/file.hpp"
+
+#include "managers/executor.hpp"
+#include "managers/memory_stats.hpp"
+
+namespace jukebox {
+
+namespace {
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+}  // namespace
+
+std::filesystem::path SongInfoCache::path() {
+    static std::filesystem::path path =
+        Mod::get()->getSaveDir() / "song-info-cache.json";
+    return path;
+}
+
+Result<> SongInfoCache::load() {
+    std::error_code ec;
+    if (!std::filesystem::exists(this->path(), ec)) {
+        return Ok();
+    }
+
+    GEODE_UNWRAP_INTO(std::string contents,
+                      file::readString(this->path()).mapErr([](auto err) {
+                          return fmt::format(
+                              "Couldn't read song info cache: {}", err);
+                      }));
+    GEODE_UNWRAP_INTO(matjson::Value json,
+                      matjson::parse(contents).mapErr([](auto err) {
+                          return fmt::format(
+                              "Couldn't parse song info cache: {}", err);
+                      }));
+
+    if (!json.isObject()) {
+        return Err("Song info cache is not an object");
+    }
+
+    // Entries are stored as "id": [name, artist, fetchedAt] to keep the file
+    // small, since it grows with every song ID seen without a SongInfoObject
+    for (const auto& [key, value] : json) {
+        if (!value.isArray() || value.size() != 3 || !value[0].isString() ||
+            !value[1].isString() || !value[2].isNumber()) {
+            continue;
+        }
+
+        int id = std::strtol(key.c_str(), nullptr, 10);
+        if (id == 0) {
+            continue;
+        }
+
+        m_entries[id] = CachedSongInfo{value[0].asString().unwrap(),
+                                       value[1].asString().unwrap(),
+                                       value[2].asInt().unwrapOr(0)};
+    }
+
+    log::info("Loaded {} cached song infos", m_entries.size());
+    return Ok();
+}
+
+std::string SongInfoCache::serialize() const {
+    matjson::Value json = matjson::makeObject({});
+    for (const auto& [id, info] : m_entries) {
+        matjson::Value entry = matjson::Value::array();
+        entry.push(info.name);
+        entry.push(info.artist);
+        entry.push(info.fetchedAt);
+        json.set(std::to_string(id), entry);
+    }
+    return json.dump(matjson::NO_INDENTATION);
+}
+
+Result<> SongInfoCache::write(const std::string& contents) {
+    return file::writeString(this->path(), contents).mapErr([](auto err) {
+        return fmt::format("Couldn't write song info cache: {}", err);
+    });
+}
+
+Result<> SongInfoCache::save() { return this->write(this->serialize()); }
+
+void SongInfoCache::queueSave() {
+    if (m_saveQueued) {
+        return;
+    }
+    m_saveQueued = true;
+
+    // Coalesce all stores done in a frame into a single write
+    geode::queueInMainThread([this]() {
+        m_saveQueued = false;
+
+        const uint64_t generation = ++m_saveGeneration;
+        Executor::get().run(
+            Lane::Idle, [this, contents = this->serialize(), generation]() {
+                std::lock_guard lock(m_writeMutex);
+                // A newer save already made it to disk
+                if (generation <= m_writtenGeneration) {
+                    return;
+                }
+                m_writtenGeneration = generation;
+
+                if (Result<> res = this->write(contents); res.isErr()) {
+                    log::error("{}", res.unwrapErr());
+                }
+            });
+    });
+}
+
+std::optional<CachedSongInfo> SongInfoCache::find(int songID) const {
+    auto it = m_entries.find(songID);
+    if (it == m_entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+MemoryEstimate SongInfoCache::estimateMemory() const {
+    MemoryEstimate estimate;
+    estimate.bytes = m_entries.bucket_count() * sizeof(void*);
+    for (const auto& [id, info] : m_entries) {
+        estimate.bytes += memory::node<decltype(m_entries)::value_type>() +
+                          memory::heap(info.name) + memory::heap(info.artist);
+    }
+    estimate.count = m_entries.size();
+    return estimate;
+}
+
+bool SongInfoCache::isStale(const CachedSongInfo& info) const {
+    return now() - info.fetchedAt >
+           std::chrono::duration_cast<std::chrono::seconds>(s_staleAfter)
+               .count();
+}
+
+void SongInfoCache::store(int songID, const std::string& name,
+                          const std::string& artist) {
+    if (songID <= 0 || name.empty()) {
+        return;
+    }
+
+    auto it = m_entries.find(songID);
+    if (it != m_entries.end() && it->second.name == name &&
+        it->second.artist == artist && !this->isStale(it->second)) {
+        return;
+    }
+
+    m_entries[songID] = CachedSongInfo{name, artist, now()};
+    this->queueSave();
+}
+
+}  // namespace jukebox
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "Geode/Result.hpp"
+
+#include "managers/memory_stats.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+struct CachedSongInfo final {
+    std::string name;
+    std::string artist;
+    // Unix timestamp (seconds) of when the info was received from the servers
+    int64_t fetchedAt;
+};
+
+/**
+ * Persistent song ID -> (name, artist) cache for songs that GD doesn't have a
+ * SongInfoObject for. Lets us skip the getSongInfo round trip when opening
+ * level pages, and keeps metadata around while offline.
+ */
+class SongInfoCache {
+protected:
+    std::unordered_map<int, CachedSongInfo> m_entries;
+    bool m_saveQueued = false;
+
+    // Saves are written on a worker, the generations keep an older save
+    // from overwriting a newer one
+    uint64_t m_saveGeneration = 0;
+    std::mutex m_writeMutex;
+    uint64_t m_writtenGeneration = 0;
+
+    SongInfoCache() = default;
+
+    SongInfoCache(const SongInfoCache&) = delete;
+    SongInfoCache(SongInfoCache&&) = delete;
+
+    SongInfoCache& operator=(const SongInfoCache&) = delete;
+    SongInfoCache& operator=(SongInfoCache&&) = delete;
+
+    void queueSave();
+    std::string serialize() const;
+    Result<> write(const std::string& contents);
+
+public:
+    // Entries older than this are still used, but a refresh gets requested
+    static constexpr std::chrono::hours s_staleAfter{24 * 7};
+
+    std::filesystem::path path();
+
+    Result<> load();
+    Result<> save();
+
+    std::optional<CachedSongInfo> find(int songID) const;
+    bool isStale(const CachedSongInfo& info) const;
+
+    MemoryEstimate estimateMemory() const;
+
+    /**
+     * Stores info for a song ID. Only queues a write to disk if something
+     * actually changed (or the entry got stale).
+     */
+    void store(int songID, const std::string& name, const std::string& artist);
+
+    static SongInfoCache& get() {
+        static SongInfoCache instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
@@ -0,0 +1,132 @@
+#include "managers/song_info_queue.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Geode/binding/MusicDownloadManager.hpp"
+#include "Geode/cocos/CCScheduler.h"
+#include "Geode/loader/Log.hpp"
+
+namespace jukebox {
+
+void SongInfoQueue::request(int songID, Callback callback) {
+    auto it = m_pending.find(songID);
+    if (it != m_pending.end()) {
+        if (callback) {
+            it->second.waiters.push_back(std::move(callback));
+        }
+        return;
+    }
+
+    Pending pending;
+    if (callback) {
+        pending.waiters.push_back(std::move(callback));
+    }
+    m_pending.emplace(songID, std::move(pending));
+    m_queue.push_back(songID);
+
+    this->schedule();
+}
+
+void SongInfoQueue::resolve(int songID) {
+    if (!m_pending.contains(songID)) {
+        return;
+    }
+    this->finish(songID, true);
+}
+
+void SongInfoQueue::reject(int songID) {
+    auto it = m_pending.find(songID);
+    if (it == m_pending.end() || !it->second.inFlight) {
+        return;
+    }
+    this->retryOrFail(songID, it->second);
+}
+
+void SongInfoQueue::schedule() {
+    if (m_scheduled) {
+        return;
+    }
+    m_scheduled = true;
+    CCScheduler::get()->scheduleSelector(
+        schedule_selector(SongInfoQueue::tick), this, 0.1f, false);
+}
+
+void SongInfoQueue::tick(float) {
+    const Clock::time_point now = Clock::now();
+
+    std::vector<int> timedOut;
+    for (const auto& [id, pending] : m_pending) {
+        if (pending.inFlight && now - pending.sentAt > s_responseTimeout) {
+            timedOut.push_back(id);
+        }
+    }
+    for (int id : timedOut) {
+        this->retryOrFail(id, m_pending.at(id));
+    }
+
+    if (now - m_lastRequest >= s_spacing) {
+        // Drop IDs that got resolved while they were waiting in the queue
+        std::erase_if(m_queue, [this](int id) {
+            auto it = m_pending.find(id);
+            return it == m_pending.end() || it->second.inFlight;
+        });
+
+        auto next = std::find_if(m_queue.begin(), m_queue.end(),
+                                 [this, now](int id) {
+                                     return m_pending.at(id).retryAt <= now;
+                                 });
+        if (next != m_queue.end()) {
+            int id = *next;
+            m_queue.erase(next);
+            this->send(id, m_pending.at(id));
+        }
+    }
+
+    if (m_pending.empty()) {
+        m_scheduled = false;
+        CCScheduler::get()->unscheduleSelector(
+            schedule_selector(SongInfoQueue::tick), this);
+    }
+}
+
+void SongInfoQueue::send(int songID, Pending& pending) {
+    pending.attempts++;
+    pending.inFlight = true;
+    pending.sentAt = Clock::now();
+    m_lastRequest = pending.sentAt;
+
+    MusicDownloadManager::sharedState()->getSongInfo(songID, true);
+}
+
+void SongInfoQueue::retryOrFail(int songID, Pending& pending) {
+    pending.inFlight = false;
+
+    if (pending.attempts >= s_maxAttempts) {
+        log::warn("Giving up on song info for {} after {} attempts", songID,
+                  pending.attempts);
+        this->finish(songID, false);
+        return;
+    }
+
+    pending.retryAt =
+        Clock::now() + s_baseBackoff * (1 << (pending.attempts - 1));
+    m_queue.push_back(songID);
+}
+
+void SongInfoQueue::finish(int songID, bool success) {
+    auto it = m_pending.find(songID);
+    if (it == m_pending.end()) {
+        return;
+    }
+
+    std::vector<Callback> waiters = std::move(it->second.waiters);
+    m_pending.erase(it);
+
+    for (Callback& callback : waiters) {
+        callback(success);
+    }
+}
+
+}  // namespace jukebox
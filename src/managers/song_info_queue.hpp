@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "Geode/cocos/cocoa/CCObject.h"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+/**
+ * Funnels all getSongInfo requests to the GD servers. Requests for the same
+ * song ID are merged, requests are spaced out so the servers don't throttle
+ * us, and requests that never got an answer are retried with backoff.
+ */
+class SongInfoQueue : public CCObject {
+public:
+    // Called with true once the song info arrived, false if we gave up
+    using Callback = std::function<void(bool)>;
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending {
+        int attempts = 0;
+        bool inFlight = false;
+        Clock::time_point sentAt;
+        Clock::time_point retryAt;
+        std::vector<Callback> waiters;
+    };
+
+    std::unordered_map<int, Pending> m_pending;
+    // Song IDs waiting to be sent, in request order
+    std::deque<int> m_queue;
+    Clock::time_point m_lastRequest;
+    bool m_scheduled = false;
+
+    void schedule();
+    void tick(float);
+    void send(int songID, Pending& pending);
+    void retryOrFail(int songID, Pending& pending);
+    void finish(int songID, bool success);
+
+public:
+    static constexpr std::chrono::milliseconds s_spacing{750};
+    static constexpr std::chrono::seconds s_responseTimeout{10};
+    static constexpr std::chrono::seconds s_baseBackoff{2};
+    static constexpr int s_maxAttempts = 4;
+
+    /**
+     * Queue a song info request. If one is already pending for the song ID,
+     * the callback is attached to it instead.
+     */
+    void request(int songID, Callback callback = {});
+
+    /**
+     * Resolve all waiters for a song ID. Called once GD received the info.
+     */
+    void resolve(int songID);
+
+    /**
+     * Mark the in-flight request for a song ID as failed, so it gets retried.
+     */
+    void reject(int songID);
+
+    bool isPending(int songID) const { return m_pending.contains(songID); }
+
+    static SongInfoQueue& get() {
+        static SongInfoQueue instance;
+        return instance;
+    }
+};
+
+}  // namespace jukebox
@@ -0,0 +1,425 @@
+#include "managers/song_pack.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "io/io_backend.hpp"
+#include "io/pack_archive.hpp"
+#include "managers/deletion_queue.hpp"
+#include "managers/executor.hpp"
+#include "managers/nong_manager.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace {
+
+constexpr uint64_t s_megabyte = 1024 * 1024;
+
+// Istream over a packed file, keeps the mapping alive while it's read
+class ViewBuffer : public std::streambuf {
+protected:
+    io::PackView m_view;
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir dir,
+                     std::ios_base::openmode) override {
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = this->gptr() - this->eback();
+        } else if (dir == std::ios_base::end) {
+            base = this->egptr() - this->eback();
+        }
+        return this->seekpos(base + offset, std::ios_base::in);
+    }
+
+    pos_type seekpos(pos_type position, std::ios_base::openmode) override {
+        const off_type offset = position;
+        if (offset < 0 || offset > this->egptr() - this->eback()) {
+            return pos_type(off_type(-1));
+        }
+        this->setg(this->eback(), this->eback() + offset, this->egptr());
+        return position;
+    }
+
+public:
+    ViewBuffer(io::PackView view) : m_view(std::move(view)) {
+        // Never written through, streambuf just has no const get area
+        char* data = const_cast<char*>(
+            reinterpret_cast<const char*>(m_view.data.data()));
+        this->setg(data, data, data + m_view.data.size());
+    }
+};
+
+class ViewStream : public std::istream {
+protected:
+    ViewBuffer m_buffer;
+
+public:
+    ViewStream(io::PackView view)
+        : std::istream(nullptr), m_buffer(std::move(view)) {
+        this->rdbuf(&m_buffer);
+    }
+};
+
+std::optional<uintmax_t> looseSize(const std::filesystem::path& path) {
+    std::error_code ec;
+    const uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return std::nullopt;
+    }
+    return size;
+}
+
+bool skipped(const std::filesystem::path& path) {
+    // Writes that haven't been renamed into place yet
+    const std::filesystem::path extension = path.extension();
+    return extension == ".tmp" || extension == ".part";
+}
+
+struct LooseFile {
+    std::filesystem::path path;
+    std::string key;
+    std::filesystem::file_time_type modified;
+    std::vector<uint8_t> data;
+};
+
+std::optional<LooseFile> readLoose(const std::filesystem::path& path,
+                                   std::string key, uintmax_t size) {
+    std::error_code ec;
+    LooseFile ret{path, std::move(key),
+                  std::filesystem::last_write_time(path, ec), {}};
+    if (ec) {
+        return std::nullopt;
+    }
+
+    std::ifstream input(path, std::ios_base::binary);
+    if (!input.is_open()) {
+        return std::nullopt;
+    }
+    ret.data.resize(size);
+    input.read(reinterpret_cast<char*>(ret.data.data()), size);
+    if (static_cast<uintmax_t>(input.gcount()) != size) {
+        return std::nullopt;
+    }
+    return ret;
+}
+
+}  // namespace
+
+std::filesystem::path SongPack::packPath() {
+    static std::filesystem::path path = Mod::get()->getSaveDir() / "nongs.jbpk";
+    return path;
+}
+
+std::optional<std::string> SongPack::key(
+    const std::filesystem::path& path) const {
+    if (path.parent_path().lexically_normal() != m_directory) {
+        return std::nullopt;
+    }
+    const std::u8string name = path.filename().u8string();
+    return std::string(reinterpret_cast<const char*>(name.data()),
+                       name.size());
+}
+
+void SongPack::start() {
+    m_directory = NongManager::get().baseNongsPath().lexically_normal();
+    const bool enabled = Mod::get()->getSettingValue<bool>("pack-small-songs");
+
+    std::error_code ec;
+    if (!enabled && !std::filesystem::exists(this->packPath(), ec)) {
+        return;
+    }
+
+    Result<std::unique_ptr<io::PackArchive>> res =
+        io::PackArchive::open(this->packPath());
+    if (res.isErr()) {
+        log::error("Couldn't open the song pack, using loose files: {}",
+                   res.unwrapErr());
+        return;
+    }
+    std::unique_ptr<io::PackArchive> archive = std::move(res).unwrap();
+
+    const io::PackArchive::Stats stats = archive->stats();
+    if (stats.recoveredBytes > 0) {
+        log::warn("Dropped {} bytes of an unfinished write from the song pack",
+                  stats.recoveredBytes);
+    }
+
+    if (!enabled && stats.entries == 0) {
+        // Unpacked last session, nothing left to read from
+        archive.reset();
+        std::filesystem::remove(this->packPath(), ec);
+        return;
+    }
+
+    m_archive = std::move(archive);
+    if (enabled) {
+        const uint64_t maxSize =
+            std::max<int64_t>(
+                Mod::get()->getSettingValue<int64_t>("pack-max-size"), 0) *
+            s_megabyte;
+        Executor::get().run(Lane::Background,
+                            [this, maxSize]() { this->pack(maxSize); });
+    } else {
+        Executor::get().run(Lane::Background, [this]() { this->unpack(); });
+    }
+}
+
+void SongPack::pack(uint64_t maxSize) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(m_directory, ec);
+    if (ec) {
+        return;
+    }
+
+    struct Candidate {
+        std::filesystem::path path;
+        std::string key;
+        uintmax_t size;
+    };
+    std::vector<Candidate> candidates;
+    for (const std::filesystem::directory_entry& entry : it) {
+        const std::filesystem::path& path = entry.path();
+        if (!entry.is_regular_file(ec) || skipped(path) ||
+            DeletionQueue::get().pending(path)) {
+            continue;
+        }
+        const uintmax_t size = entry.file_size(ec);
+        if (ec || size == 0 || size > maxSize) {
+            continue;
+        }
+        if (std::optional<std::string> key = this->key(path)) {
+            candidates.push_back(
+                Candidate{path, std::move(key.value()), size});
+        }
+    }
+
+    size_t packed = 0;
+    uint64_t packedBytes = 0;
+    for (size_t i = 0; i < candidates.size();) {
+        // Read in batches, so every batch is one fsync
+        std::vector<LooseFile> batch;
+        uint64_t batchBytes = 0;
+        for (; i < candidates.size() && batchBytes < s_batchBytes; i++) {
+            const Candidate& candidate = candidates[i];
+            std::optional<LooseFile> file =
+                readLoose(candidate.path, candidate.key, candidate.size);
+            if (!file.has_value()) {
+                continue;
+            }
+            batchBytes += candidate.size;
+            batch.push_back(std::move(file.value()));
+        }
+
+        std::vector<io::PackEntry> entries;
+        for (const LooseFile& file : batch) {
+            // Left loose after a failed delete, or downloaded again
+            std::optional<io::PackView> existing = m_archive->find(file.key);
+            if (existing.has_value() &&
+                existing->data.size() == file.data.size() &&
+                std::memcmp(existing->data.data(), file.data.data(),
+                            file.data.size()) == 0) {
+                continue;
+            }
+            entries.push_back(io::PackEntry{file.key, std::span(file.data)});
+        }
+        if (Result<> res = m_archive->add(entries); res.isErr()) {
+            log::error("Couldn't pack songs: {}", res.unwrapErr());
+            return;
+        }
+
+        for (const LooseFile& file : batch) {
+            // Rewritten or deleted while it was packed, the loose file wins
+            if (DeletionQueue::get().pending(file.path) ||
+                looseSize(file.path) != file.data.size() ||
+                std::filesystem::last_write_time(file.path, ec) !=
+                    file.modified) {
+                continue;
+            }
+            // Fails while something has the file open on Windows, it's
+            // tried again next start
+            std::filesystem::remove(file.path, ec);
+            if (!ec) {
+                packed++;
+                packedBytes += file.data.size();
+            }
+        }
+    }
+
+    if (packed > 0) {
+        log::info("Packed {} songs ({:.2f}MB)", packed,
+                  packedBytes / static_cast<double>(s_megabyte));
+    }
+    this->compact();
+}
+
+void SongPack::unpack() {
+    std::vector<std::string> keys = m_archive->keys();
+
+    size_t unpacked = 0;
+    for (size_t i = 0; i < keys.size();) {
+        std::vector<io::PackView> views;
+        std::vector<io::FileWrite> writes;
+        std::vector<std::string> done;
+        uint64_t batchBytes = 0;
+        for (; i < keys.size() && batchBytes < s_batchBytes; i++) {
+            const std::string& key = keys[i];
+            const std::filesystem::path path =
+                m_directory / std::filesystem::path(std::u8string(
+                                  reinterpret_cast<const char8_t*>(key.data()),
+                                  key.size()));
+            done.push_back(key);
+
+            std::optional<io::PackView> view = m_archive->find(key);
+            std::error_code ec;
+            // A newer loose copy is kept as is
+            if (!view.has_value() || std::filesystem::exists(path, ec)) {
+                continue;
+            }
+            batchBytes += view->data.size();
+            writes.push_back(io::FileWrite{path, view->data});
+            views.push_back(std::move(view.value()));
+        }
+
+        if (Result<> res = io::backend().write(writes); res.isErr()) {
+            log::error("Couldn't unpack songs: {}", res.unwrapErr());
+            return;
+        }
+        // Only dropped once the loose copies are on disk
+        if (Result<uint64_t> res = m_archive->remove(done); res.isErr()) {
+            log::error("Couldn't unpack songs: {}", res.unwrapErr());
+            return;
+        }
+        unpacked += writes.size();
+    }
+
+    log::info("Unpacked {} songs", unpacked);
+    this->compact();
+}
+
+void SongPack::compact() {
+    if (!m_archive->shouldCompact()) {
+        return;
+    }
+
+    const uint64_t before = m_archive->stats().fileBytes;
+    const auto start = std::chrono::steady_clock::now();
+    if (Result<> res = m_archive->compact(); res.isErr()) {
+        log::warn("Couldn't compact the song pack: {}", res.unwrapErr());
+        return;
+    }
+    log::info(
+        "Compacted the song pack from {:.2f}MB to {:.2f}MB in {}ms",
+        before / static_cast<double>(s_megabyte),
+        m_archive->stats().fileBytes / static_cast<double>(s_megabyte),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+}
+
+bool SongPack::exists(const std::filesystem::path& path) {
+    std::error_code ec;
+    return std::filesystem::exists(path, ec) ||
+           this->packedSize(path).has_value();
+}
+
+std::optional<uintmax_t> SongPack::size(const std::filesystem::path& path) {
+    if (std::optional<uintmax_t> size = looseSize(path)) {
+        return size;
+    }
+    return this->packedSize(path);
+}
+
+std::optional<uintmax_t> SongPack::packedSize(
+    const std::filesystem::path& path) {
+    if (!m_archive) {
+        return std::nullopt;
+    }
+    std::optional<std::string> key = this->key(path);
+    if (!key.has_value()) {
+        return std::nullopt;
+    }
+    return m_archive->size(key.value());
+}
+
+std::optional<io::PackView> SongPack::find(const std::string& path) {
+    if (!m_archive) {
+        return std::nullopt;
+    }
+    const std::filesystem::path file(std::u8string(
+        reinterpret_cast<const char8_t*>(path.data()), path.size()));
+    std::optional<std::string> key = this->key(file);
+    std::error_code ec;
+    if (!key.has_value() || std::filesystem::exists(file, ec)) {
+        return std::nullopt;
+    }
+    return m_archive->find(key.value());
+}
+
+std::unique_ptr<std::istream> SongPack::open(
+    const std::filesystem::path& path) {
+    auto loose = std::make_unique<std::ifstream>(path, std::ios_base::binary);
+    if (loose->is_open()) {
+        return loose;
+    }
+
+    if (!m_archive) {
+        return nullptr;
+    }
+    std::optional<std::string> key = this->key(path);
+    if (!key.has_value()) {
+        return nullptr;
+    }
+    std::optional<io::PackView> view = m_archive->find(key.value());
+    if (!view.has_value()) {
+        return nullptr;
+    }
+    return std::make_unique<ViewStream>(std::move(view.value()));
+}
+
+std::optional<uintmax_t> SongPack::remove(const std::filesystem::path& path) {
+    if (!m_archive) {
+        return std::nullopt;
+    }
+    std::optional<std::string> key = this->key(path);
+    if (!key.has_value()) {
+        return std::nullopt;
+    }
+
+    Result<uint64_t> res = m_archive->remove({key.value()});
+    if (res.isErr()) {
+        log::error("Couldn't remove {} from the song pack: {}", key.value(),
+                   res.unwrapErr());
+        return std::nullopt;
+    }
+    if (res.unwrap() == 0) {
+        return std::nullopt;
+    }
+    return res.unwrap();
+}
+
+io::PackArchive::Stats SongPack::stats() const {
+    if (!m_archive) {
+        return {};
+    }
+    return m_archive->stats();
+}
+
+}  // namespace jukebox
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "io/pack_archive.hpp"
+
+namespace jukebox {
+
+/**
+ * Keeps small songs of the nongs folder in one packed file instead of one
+ * file each, see the pack-small-songs setting. FMOD reads packed songs
+ * straight from the pack's mapping.
+ *
+ * A loose file always wins over a packed one with the same name, so
+ * anything written to the nongs folder shows up right away. Loose files
+ * are packed in the background at startup, and unpacked again once the
+ * setting is turned off. Without a usable pack everything stays loose.
+ *
+ * Code that checks whether a song's file exists has to go through exists()
+ * or size(), the file might only be in the pack.
+ */
+class SongPack {
+protected:
+    // Set once in start() and never replaced, so reads don't need a lock
+    std::unique_ptr<io::PackArchive> m_archive;
+    std::filesystem::path m_directory;
+
+    SongPack() = default;
+
+    SongPack(const SongPack&) = delete;
+    SongPack(SongPack&&) = delete;
+
+    SongPack& operator=(const SongPack&) = delete;
+    SongPack& operator=(SongPack&&) = delete;
+
+    /**
+     * Name of a song in the pack, nullopt for files outside the nongs folder
+     */
+    std::optional<std::string> key(const std::filesystem::path& path) const;
+
+    void pack(uint64_t maxSize);
+    void unpack();
+    void compact();
+
+public:
+    static constexpr uint64_t s_batchBytes = 16 * 1024 * 1024;
+
+    static SongPack& get() {
+        static SongPack instance;
+        return instance;
+    }
+
+    std::filesystem::path packPath();
+
+    /**
+     * Opens the pack and starts packing or unpacking on a worker. Call
+     * before the manifest is loaded, so packed songs count as downloaded.
+     */
+    void start();
+
+    /**
+     * Whether a file exists loose or packed
+     */
+    bool exists(const std::filesystem::path& path);
+    std::optional<uintmax_t> size(const std::filesystem::path& path);
+    /**
+     * Size of the packed copy only
+     */
+    std::optional<uintmax_t> packedSize(const std::filesystem::path& path);
+
+    /**
+     * A packed file FMOD should read from, null if the file is loose or
+     * not packed. Takes the UTF-8 path the song hooks hand to GD.
+     */
+    std::optional<io::PackView> find(const std::string& path);
+    /**
+     * Reads a file loose or packed, null if it's neither
+     */
+    std::unique_ptr<std::istream> open(const std::filesystem::path& path);
+
+    /**
+     * Drops a file from the pack, returns the bytes it took
+     */
+    std::optional<uintmax_t> remove(const std::filesystem::path& path);
+
+    bool enabled() const { return m_archive != nullptr; }
+    io::PackArchive::Stats stats() const;
+};
+
+}  // namespace jukebox
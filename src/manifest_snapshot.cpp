@@ -0,0 +1,66 @@
+#include "manifest_snapshot.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "managers/deletion_queue.hpp"
+#include "managers/song_pack.hpp"
+#include "nong.hpp"
+
+namespace jukebox {
+
+namespace {
+
+std::optional<uintmax_t> statSize(const std::filesystem::path& path) {
+    return SongPack::get().size(path);
+}
+
+}  // namespace
+
+SongSnapshot SongSnapshot::from(const Song& song) {
+    return SongSnapshot::from(song, statSize);
+}
+
+SongSnapshot SongSnapshot::from(const Song& song, const SizeLookup& sizeOf) {
+    std::optional<std::filesystem::path> path = song.path();
+    std::optional<uintmax_t> size = std::nullopt;
+    // Queued for deletion counts as deleted already
+    if (path.has_value() && !DeletionQueue::get().pending(path.value())) {
+        size = sizeOf(path.value());
+    }
+
+    return SongSnapshot{song.type(), *song.metadata(), song.indexID(),
+                        std::move(path), size};
+}
+
+std::shared_ptr<const NongsSnapshot> NongsSnapshot::from(const Nongs& nongs,
+                                                         uint64_t version) {
+    return NongsSnapshot::from(nongs, version, statSize);
+}
+
+std::shared_ptr<const NongsSnapshot> NongsSnapshot::from(
+    const Nongs& nongs, uint64_t version,
+    const SongSnapshot::SizeLookup& sizeOf) {
+    std::vector<SongSnapshot> songs;
+    songs.reserve(nongs.locals().size() + nongs.youtube().size() +
+                  nongs.hosted().size());
+
+    for (const std::unique_ptr<LocalSong>& i : nongs.locals()) {
+        songs.push_back(SongSnapshot::from(*i, sizeOf));
+    }
+    for (const std::unique_ptr<YTSong>& i : nongs.youtube()) {
+        songs.push_back(SongSnapshot::from(*i, sizeOf));
+    }
+    for (const std::unique_ptr<HostedSong>& i : nongs.hosted()) {
+        songs.push_back(SongSnapshot::from(*i, sizeOf));
+    }
+
+    return std::make_shared<const NongsSnapshot>(NongsSnapshot{
+        nongs.songID(), version,
+        SongSnapshot::from(*nongs.defaultSong(), sizeOf),
+        SongSnapshot::from(*nongs.active(), sizeOf), std::move(songs)});
+}
+
+}  // namespace jukebox
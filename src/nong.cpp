@@ -1,11 +1,10 @@
 #include "nong.hpp"
 
+#include <algorithm>
 #include <filesystem>
-#include <fstream>
 #include <memory>
 #include <optional>
 #include <string>
-#include <system_error>
 #include <vector>
 
 #include <fmt/core.h>
@@ -23,8 +22,11 @@
 #include "events/nong_deleted.hpp"
 #include "events/song_state_changed.hpp"
 #include "index.hpp"
+#include "managers/deletion_queue.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
 #include "nong_serialize.hpp"
+#include "storage/storage_backend.hpp"
 #include "utils/random_string.hpp"
 
 using namespace geode::prelude;
@@ -37,11 +39,12 @@ private:
     friend class LocalSong;
 
     std::unique_ptr<SongMetadata> m_metadata;
-    std::filesystem::path m_path;
+    SongPath m_path;
 
 public:
-    Impl(SongMetadata&& metadata, const std::filesystem::path& path)
-        : m_metadata(std::make_unique<SongMetadata>(metadata)), m_path(path) {}
+    Impl(SongMetadata&& metadata, SongPath path)
+        : m_metadata(std::make_unique<SongMetadata>(metadata)),
+          m_path(std::move(path)) {}
 
     Impl(const Impl& other)
         : m_path(other.m_path),
@@ -54,11 +57,15 @@ public:
     Impl& operator=(Impl&&) = default;
 
     SongMetadata* metadata() const { return m_metadata.get(); }
-    std::filesystem::path path() const { return m_path; }
+    std::filesystem::path path() const { return m_path.absolute(); }
 };
 
 LocalSong::LocalSong(SongMetadata&& metadata, const std::filesystem::path& path)
-    : m_impl(std::make_unique<Impl>(std::move(metadata), path)) {}
+    : m_impl(std::make_unique<Impl>(std::move(metadata),
+                                    SongPath::fromAbsolute(path))) {}
+
+LocalSong::LocalSong(SongMetadata&& metadata, SongPath path)
+    : m_impl(std::make_unique<Impl>(std::move(metadata), std::move(path))) {}
 
 LocalSong::LocalSong(const LocalSong& other)
     : m_impl(std::make_unique<Impl>(*other.m_impl)) {}
@@ -79,6 +86,7 @@ SongMetadata* LocalSong::metadata() const { return m_impl->metadata(); }
 std::optional<std::filesystem::path> LocalSong::path() const {
     return m_impl->path();
 }
+const SongPath* LocalSong::songPath() const { return &m_impl->m_path; }
 
 LocalSong LocalSong::createUnknown(int songID) {
     return LocalSong{
@@ -102,16 +110,16 @@ private:
     std::unique_ptr<SongMetadata> m_metadata;
     std::string m_youtubeID;
     std::optional<std::string> m_indexID;
-    std::optional<std::filesystem::path> m_path;
+    std::optional<SongPath> m_path;
 
 public:
     Impl(SongMetadata&& metadata, std::string youtubeID,
          std::optional<std::string> indexID,
-         std::optional<std::filesystem::path> path = std::nullopt)
+         std::optional<SongPath> path = std::nullopt)
         : m_metadata(std::make_unique<SongMetadata>(metadata)),
           m_youtubeID(youtubeID),
           m_indexID(indexID),
-          m_path(path) {}
+          m_path(std::move(path)) {}
 
     Impl(const Impl& other)
         : m_metadata(std::make_unique<SongMetadata>(*other.m_metadata)),
@@ -126,12 +134,18 @@ public:
     Impl& operator=(Impl&&) = default;
 
     SongMetadata* metadata() const { return m_metadata.get(); }
-    std::optional<std::filesystem::path> path() const { return m_path; }
+    std::optional<std::filesystem::path> path() const {
+        if (!m_path.has_value()) {
+            return std::nullopt;
+        }
+        return m_path->absolute();
+    }
     std::string youtubeID() const { return m_youtubeID; }
     std::optional<std::string> indexID() const { return m_indexID; }
     Result<Task<Result<ByteVector>, float>> startDownload() {
-        std::error_code ec;
-        if (m_path.has_value() && std::filesystem::exists(m_path.value(), ec)) {
+        if (m_path.has_value() &&
+            SongPack::get().exists(m_path->absolute()) &&
+            !DeletionQueue::get().pending(m_path->absolute())) {
             return Err("Song already is downloaded");
         }
 
@@ -142,8 +156,16 @@ public:
 YTSong::YTSong(SongMetadata&& metadata, std::string youtubeID,
                std::optional<std::string> indexID,
                std::optional<std::filesystem::path> path)
+    : m_impl(std::make_unique<Impl>(
+          std::move(metadata), youtubeID, indexID,
+          path.has_value()
+              ? std::optional(SongPath::fromAbsolute(path.value()))
+              : std::nullopt)) {}
+
+YTSong::YTSong(SongMetadata&& metadata, std::string youtubeID,
+               std::optional<std::string> indexID, SongPath path)
     : m_impl(std::make_unique<Impl>(std::move(metadata), youtubeID, indexID,
-                                    path)) {}
+                                    std::move(path))) {}
 
 YTSong::YTSong(const YTSong& other)
     : m_impl(std::make_unique<Impl>(*other.m_impl)) {}
@@ -172,6 +194,9 @@ void YTSong::setIndexID(const std::string& id) { m_impl->m_indexID = id; }
 std::optional<std::filesystem::path> YTSong::path() const {
     return m_impl->path();
 }
+const SongPath* YTSong::songPath() const {
+    return m_impl->m_path.has_value() ? &m_impl->m_path.value() : nullptr;
+}
 
 Result<Task<Result<ByteVector>, float>> YTSong::startDownload() {
     return m_impl->startDownload();
@@ -184,16 +209,16 @@ private:
     std::unique_ptr<SongMetadata> m_metadata;
     std::string m_url;
     std::optional<std::string> m_indexID;
-    std::optional<std::filesystem::path> m_path;
+    std::optional<SongPath> m_path;
 
 public:
     Impl(SongMetadata&& metadata, std::string url,
          std::optional<std::string> indexID,
-         std::optional<std::filesystem::path> path = std::nullopt)
+         std::optional<SongPath> path = std::nullopt)
         : m_metadata(std::make_unique<SongMetadata>(metadata)),
           m_url(url),
           m_indexID(indexID),
-          m_path(path) {}
+          m_path(std::move(path)) {}
 
     Impl(const Impl& other)
         : m_metadata(std::make_unique<SongMetadata>(*other.m_metadata)),
@@ -210,10 +235,16 @@ public:
     SongMetadata* metadata() const { return m_metadata.get(); }
     std::string url() const { return m_url; }
     std::optional<std::string> indexID() const { return m_indexID; }
-    std::optional<std::filesystem::path> path() const { return m_path; }
+    std::optional<std::filesystem::path> path() const {
+        if (!m_path.has_value()) {
+            return std::nullopt;
+        }
+        return m_path->absolute();
+    }
     Result<Task<Result<ByteVector>, float>> startDownload() {
-        std::error_code ec;
-        if (m_path.has_value() && std::filesystem::exists(m_path.value(), ec)) {
+        if (m_path.has_value() &&
+            SongPack::get().exists(m_path->absolute()) &&
+            !DeletionQueue::get().pending(m_path->absolute())) {
             return Err("Song already is downloaded");
         }
 
@@ -224,7 +255,16 @@ public:
 HostedSong::HostedSong(SongMetadata&& metadata, std::string url,
                        std::optional<std::string> indexID,
                        std::optional<std::filesystem::path> path)
-    : m_impl(std::make_unique<Impl>(std::move(metadata), url, indexID, path)) {}
+    : m_impl(std::make_unique<Impl>(
+          std::move(metadata), url, indexID,
+          path.has_value()
+              ? std::optional(SongPath::fromAbsolute(path.value()))
+              : std::nullopt)) {}
+
+HostedSong::HostedSong(SongMetadata&& metadata, std::string url,
+                       std::optional<std::string> indexID, SongPath path)
+    : m_impl(std::make_unique<Impl>(std::move(metadata), url, indexID,
+                                    std::move(path))) {}
 
 HostedSong::HostedSong(const HostedSong& other)
     : m_impl(std::make_unique<Impl>(*other.m_impl)) {}
@@ -247,6 +287,9 @@ void HostedSong::setIndexID(const std::string& id) { m_impl->m_indexID = id; }
 std::optional<std::filesystem::path> HostedSong::path() const {
     return m_impl->path();
 }
+const SongPath* HostedSong::songPath() const {
+    return m_impl->m_path.has_value() ? &m_impl->m_path.value() : nullptr;
+}
 
 Result<Task<Result<ByteVector>, float>> HostedSong::startDownload() {
     return m_impl->startDownload();
@@ -270,15 +313,8 @@ private:
     std::vector<IndexSongMetadata*> m_indexSongs;
 
     void deletePath(std::optional<std::filesystem::path> path) {
-        std::error_code ec;
-        if (path.has_value() && std::filesystem::exists(path.value())) {
-            std::filesystem::remove(path.value(), ec);
-            if (ec) {
-                log::error("Couldn't delete nong. Category: {}, message: {}",
-                           ec.category().name(),
-                           ec.category().message(ec.value()));
-                ec = {};
-            }
+        if (path.has_value()) {
+            DeletionQueue::get().enqueue(path.value());
         }
     }
 
@@ -293,31 +329,10 @@ public:
                std::make_unique<LocalSong>(LocalSong::createUnknown(songID))) {}
 
     geode::Result<> commit(Nongs* self) {
-        const std::filesystem::path path =
-            NongManager::get().baseManifestPath() /
-            fmt::format("{}.json", m_songID);
-
-        // Don't save manifest for songs with no nongs
-        if (m_locals.empty() && m_youtube.empty() && m_hosted.empty()) {
-            std::error_code ec;
-            if (std::filesystem::exists(path, ec)) {
-                std::filesystem::remove(path, ec);
-            }
-
-            return Ok();
-        }
-
-        matjson::Value json = matjson::Serialize<Nongs>::toJson(*self);
+        NongManager::get().publishSnapshot(m_songID);
 
-        std::ofstream output(path);
-        if (!output.is_open()) {
-            return Err(fmt::format("Couldn't open file: {}", path));
-        }
-
-        output << json.dump(matjson::NO_INDENTATION);
-        output.close();
-
-        return Ok();
+        return NongManager::get().storage().apply(
+            {storage::Write::from(*self)});
     }
 
     geode::Result<> canSetActive(const std::string& uniqueID,
@@ -328,9 +343,9 @@ public:
             return Ok();
         }
 
-        std::error_code ec;
-
-        if (!IS_DEFAULT && !std::filesystem::exists(path, ec)) {
+        // Queued files count as deleted, see DeletionQueue
+        if (!IS_DEFAULT && (!SongPack::get().exists(path) ||
+                            DeletionQueue::get().pending(path))) {
             return Err("Song doesn't exist on disk");
         }
 
@@ -347,7 +362,7 @@ public:
 
             m_active = song.value();
 
-            if (NongManager::get().initialized()) {
+            if (NongManager::get().shouldPostEvents()) {
                 event::SongStateChanged(self).post();
             }
 
@@ -365,7 +380,7 @@ public:
             }
 
             m_active = song.value();
-            if (NongManager::get().initialized()) {
+            if (NongManager::get().shouldPostEvents()) {
                 event::SongStateChanged(self).post();
             }
             return Ok();
@@ -382,7 +397,7 @@ public:
             }
 
             m_active = song.value();
-            if (NongManager::get().initialized()) {
+            if (NongManager::get().shouldPostEvents()) {
                 event::SongStateChanged(self).post();
             }
             return Ok();
@@ -451,7 +466,7 @@ public:
                     this->deletePath((*i)->path());
                 }
                 m_locals.erase(i);
-                if (NongManager::get().initialized()) {
+                if (NongManager::get().shouldPostEvents()) {
                     event::NongDeleted(uniqueID, m_songID).post();
                 }
                 return Ok();
@@ -464,7 +479,7 @@ public:
                     this->deletePath((*i)->path());
                 }
                 m_youtube.erase(i);
-                if (NongManager::get().initialized()) {
+                if (NongManager::get().shouldPostEvents()) {
                     event::NongDeleted(uniqueID, m_songID).post();
                 }
                 return Ok();
@@ -477,7 +492,7 @@ public:
                     this->deletePath((*i)->path());
                 }
                 m_hosted.erase(i);
-                if (NongManager::get().initialized()) {
+                if (NongManager::get().shouldPostEvents()) {
                     event::NongDeleted(uniqueID, m_songID).post();
                 }
                 return Ok();
@@ -581,6 +596,45 @@ public:
         return std::nullopt;
     }
 
+    // Moves each restored song into the existing object with the same
+    // unique ID, so the pointers held by the UI stay valid
+    template <typename T>
+    static void adoptSongs(std::vector<std::unique_ptr<T>>& current,
+                           std::vector<std::unique_ptr<T>>& restored) {
+        for (std::unique_ptr<T>& song : restored) {
+            auto it = std::find_if(
+                current.begin(), current.end(),
+                [&song](const std::unique_ptr<T>& i) {
+                    return i && i->metadata()->uniqueID ==
+                                    song->metadata()->uniqueID;
+                });
+            if (it == current.end()) {
+                continue;
+            }
+            **it = std::move(*song);
+            song = std::move(*it);
+        }
+        current = std::move(restored);
+    }
+
+    geode::Result<> restore(Nongs&& other) {
+        if (other.songID() != m_songID) {
+            return Err("Restoring NONGs of a different song ID");
+        }
+
+        Impl& restored = *other.m_impl;
+        std::string activeID = restored.m_active->metadata()->uniqueID;
+
+        *m_default = std::move(*restored.m_default);
+        adoptSongs(m_locals, restored.m_locals);
+        adoptSongs(m_youtube, restored.m_youtube);
+        adoptSongs(m_hosted, restored.m_hosted);
+        m_indexSongs = std::move(restored.m_indexSongs);
+        m_active = this->findSong(activeID).value_or(m_default.get());
+
+        return Ok();
+    }
+
     geode::Result<> replaceSong(const std::string& id, LocalSong&& song,
                                 Nongs* self) {
         bool isActive = m_active->metadata()->uniqueID == id;
@@ -749,6 +803,9 @@ Result<> Nongs::setActive(const std::string& uniqueID) {
     return m_impl->setActive(uniqueID, this);
 }
 Result<> Nongs::merge(Nongs&& other) { return m_impl->merge(std::move(other)); }
+Result<> Nongs::restore(Nongs&& other) {
+    return m_impl->restore(std::move(other));
+}
 Result<> Nongs::deleteAllSongs() { return m_impl->deleteAllSongs(); }
 Result<> Nongs::deleteSong(const std::string& uniqueID, bool audio) {
     return m_impl->deleteSong(uniqueID, audio, this);
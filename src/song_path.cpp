@@ -0,0 +1,132 @@
+#include "song_path.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "Geode/utils/string.hpp"
+
+namespace jukebox {
+
+namespace {
+
+constexpr size_t s_rootCount = static_cast<size_t>(PathRoot::External);
+
+// UTF-8, preferred separators, with a trailing separator
+std::array<std::string, s_rootCount> s_roots;
+// Bumped on every root change so cached paths get rebuilt
+uint32_t s_generation = 1;
+
+std::string toUtf8(const std::filesystem::path& path) {
+#ifdef GEODE_IS_WINDOWS
+    return geode::utils::string::wideToUtf8(path.wstring());
+#else
+    return path.string();
+#endif
+}
+
+std::filesystem::path fromUtf8(const std::string& path) {
+#ifdef GEODE_IS_WINDOWS
+    return std::filesystem::path(geode::utils::string::utf8ToWide(path));
+#else
+    return std::filesystem::path(path);
+#endif
+}
+
+}  // namespace
+
+SongPath::SongPath(PathRoot root, std::string relative)
+    : m_root(root), m_relative(std::move(relative)) {
+    if (m_root != PathRoot::External) {
+        std::replace(m_relative.begin(), m_relative.end(), '\\', '/');
+    }
+}
+
+SongPath SongPath::fromAbsolute(const std::filesystem::path& path) {
+    std::string full = toUtf8(std::filesystem::path(path).make_preferred());
+
+    for (size_t i = 0; i < s_rootCount; i++) {
+        const std::string& root = s_roots[i];
+        if (root.empty() || full.size() <= root.size() ||
+            !full.starts_with(root)) {
+            continue;
+        }
+        return SongPath(static_cast<PathRoot>(i), full.substr(root.size()));
+    }
+
+    return SongPath(PathRoot::External, toUtf8(path));
+}
+
+void SongPath::setRoot(PathRoot root, const std::filesystem::path& path) {
+    if (root == PathRoot::External) {
+        return;
+    }
+
+    std::string utf8 = toUtf8(std::filesystem::path(path).make_preferred());
+    const char separator =
+        static_cast<char>(std::filesystem::path::preferred_separator);
+    if (!utf8.empty() && utf8.back() != separator) {
+        utf8 += separator;
+    }
+
+    s_roots[static_cast<size_t>(root)] = std::move(utf8);
+    s_generation++;
+}
+
+const std::string& SongPath::rootPath(PathRoot root) {
+    static const std::string s_empty;
+    if (root == PathRoot::External) {
+        return s_empty;
+    }
+    return s_roots[static_cast<size_t>(root)];
+}
+
+const char* SongPath::rootName(PathRoot root) {
+    switch (root) {
+        case PathRoot::Nongs:
+            return "nongs";
+        case PathRoot::Songs:
+            return "songs";
+        case PathRoot::Resources:
+            return "resources";
+        case PathRoot::External:
+            return "external";
+    }
+    return "external";
+}
+
+std::optional<PathRoot> SongPath::rootFromName(const std::string& name) {
+    for (PathRoot root : {PathRoot::Nongs, PathRoot::Songs,
+                          PathRoot::Resources, PathRoot::External}) {
+        if (name == rootName(root)) {
+            return root;
+        }
+    }
+    return std::nullopt;
+}
+
+const std::string& SongPath::utf8() const {
+    if (m_generation == s_generation) {
+        return m_utf8;
+    }
+
+    if (m_root == PathRoot::External) {
+        m_utf8 = m_relative;
+    } else {
+        std::string relative = m_relative;
+#ifdef GEODE_IS_WINDOWS
+        std::replace(relative.begin(), relative.end(), '/', '\\');
+#endif
+        m_utf8 = rootPath(m_root) + relative;
+    }
+    m_generation = s_generation;
+    return m_utf8;
+}
+
+std::filesystem::path SongPath::absolute() const {
+    return fromUtf8(this->utf8());
+}
+
+}  // namespace jukebox
@@ -0,0 +1,592 @@
+#include "storage/bundle.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+
+#include "managers/deletion_queue.hpp"
+#include "managers/executor.hpp"
+#include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
+#include "manifest_snapshot.hpp"
+#include "nong.hpp"
+#include "nong_serialize.hpp"
+#include "song_path.hpp"
+#include "transaction.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace storage {
+
+namespace bundle {
+
+namespace {
+
+constexpr std::array<char, 4> s_magic = {'J', 'B', 'N', 'B'};
+constexpr size_t s_chunkSize = 256 * 1024;
+
+using Chunk = std::array<char, s_chunkSize>;
+
+// FNV-1a, only used to recognize files, not to authenticate them. The
+// size is always compared too.
+class Hasher {
+private:
+    uint64_t m_state = 0xcbf29ce484222325;
+
+public:
+    void update(const char* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            m_state ^= static_cast<uint8_t>(data[i]);
+            m_state *= 0x100000001b3;
+        }
+    }
+
+    std::string hex() const { return fmt::format("{:016x}", m_state); }
+};
+
+Result<std::string> hashFile(const std::filesystem::path& path,
+                             Chunk& chunk) {
+    // Songs can be packed, see SongPack
+    std::unique_ptr<std::istream> input = SongPack::get().open(path);
+    if (!input) {
+        return Err("Couldn't open {}", path.string());
+    }
+
+    Hasher hasher;
+    while (*input) {
+        input->read(chunk.data(), chunk.size());
+        hasher.update(chunk.data(), input->gcount());
+    }
+    if (input->bad()) {
+        return Err("Couldn't read {}", path.string());
+    }
+    return Ok(hasher.hex());
+}
+
+// Copies size bytes between streams, hashing them on the way
+Result<std::string> copy(std::istream& input, std::ostream& output,
+                         uint64_t size, Chunk& chunk) {
+    Hasher hasher;
+    while (size > 0) {
+        const size_t count =
+            static_cast<size_t>(std::min<uint64_t>(size, chunk.size()));
+        input.read(chunk.data(), count);
+        if (static_cast<size_t>(input.gcount()) != count) {
+            return Err("Unexpected end of file");
+        }
+        hasher.update(chunk.data(), count);
+        output.write(chunk.data(), count);
+        if (!output) {
+            return Err("Couldn't write audio");
+        }
+        size -= count;
+    }
+    return Ok(hasher.hex());
+}
+
+void setPath(matjson::Value& song, const std::filesystem::path& path) {
+    SongPath songPath = SongPath::fromAbsolute(path);
+    song["path_root"] = SongPath::rootName(songPath.root());
+    song["path"] = songPath.relative();
+}
+
+struct ExportSong {
+    int songID;
+    const char* kind;
+    matjson::Value json;
+    std::filesystem::path path;
+};
+
+struct ExportPlan {
+    std::vector<ExportSong> songs;
+    // song ID -> active unique ID
+    std::unordered_map<int, std::string> active;
+};
+
+ExportPlan plan(const std::vector<int>& songIDs) {
+    ExportPlan plan;
+
+    auto add = [&plan](int id, const char* kind, matjson::Value json,
+                       const Song& song) {
+        std::optional<std::filesystem::path> path = song.path();
+        if (!path.has_value() || !SongPack::get().exists(path.value())) {
+            return;
+        }
+        plan.songs.push_back(
+            ExportSong{id, kind, std::move(json), std::move(path.value())});
+    };
+
+    for (int id : songIDs) {
+        std::optional<Nongs*> opt = NongManager::get().getNongs(id);
+        if (!opt.has_value()) {
+            continue;
+        }
+        Nongs* nongs = opt.value();
+
+        for (std::unique_ptr<LocalSong>& song : nongs->locals()) {
+            add(id, "locals", matjson::Serialize<LocalSong>::toJson(*song),
+                *song);
+        }
+        for (std::unique_ptr<YTSong>& song : nongs->youtube()) {
+            add(id, "youtube", matjson::Serialize<YTSong>::toJson(*song),
+                *song);
+        }
+        for (std::unique_ptr<HostedSong>& song : nongs->hosted()) {
+            add(id, "hosted", matjson::Serialize<HostedSong>::toJson(*song),
+                *song);
+        }
+        plan.active.emplace(id, nongs->active()->metadata()->uniqueID);
+    }
+
+    return plan;
+}
+
+Result<BundleSummary> write(ExportPlan&& plan,
+                            const std::filesystem::path& path,
+                            const CancellationToken& token) {
+    auto chunk = std::make_unique<Chunk>();
+    BundleSummary summary;
+
+    struct Blob {
+        std::string hash;
+        uint64_t size;
+        std::filesystem::path path;
+    };
+    std::vector<Blob> blobs;
+    std::unordered_map<std::string, size_t> blobByPath;
+    // "hash:size" -> blob
+    std::unordered_map<std::string, size_t> blobByContents;
+
+    matjson::Value songs = matjson::Value::object();
+    for (ExportSong& song : plan.songs) {
+        if (token.cancelled()) {
+            return Err("Export cancelled");
+        }
+
+        const std::string key = song.path.string();
+        auto it = blobByPath.find(key);
+        if (it == blobByPath.end()) {
+            GEODE_UNWRAP_INTO(std::string hash, hashFile(song.path, *chunk));
+            std::optional<uintmax_t> size = SongPack::get().size(song.path);
+            if (!size.has_value()) {
+                return Err("Couldn't read {}", song.path.string());
+            }
+            // Same audio stored under two paths is written once
+            auto [same, added] = blobByContents.emplace(
+                fmt::format("{}:{}", hash, size.value()), blobs.size());
+            if (added) {
+                blobs.push_back(Blob{hash, size.value(), song.path});
+            }
+            it = blobByPath.emplace(key, same->second).first;
+        }
+
+        song.json["blob"] = blobs[it->second].hash;
+        setPath(song.json, song.path.filename());
+
+        const std::string id = std::to_string(song.songID);
+        if (!songs.contains(id)) {
+            songs[id] = matjson::makeObject({
+                {"active", plan.active.at(song.songID)},
+                {"locals", matjson::Value::array()},
+                {"youtube", matjson::Value::array()},
+                {"hosted", matjson::Value::array()},
+            });
+            summary.songIDs++;
+        }
+        songs[id][song.kind].push(std::move(song.json));
+        summary.songs++;
+    }
+
+    matjson::Value blobList = matjson::Value::array();
+    for (const Blob& blob : blobs) {
+        blobList.push(matjson::makeObject({
+            {"hash", blob.hash},
+            {"size", blob.size},
+            {"extension", blob.path.extension().string()},
+        }));
+    }
+
+    const std::string manifest =
+        matjson::makeObject({{"songs", songs}, {"blobs", blobList}})
+            .dump(matjson::NO_INDENTATION);
+
+    std::ofstream output(path, std::ios_base::binary);
+    if (!output.is_open()) {
+        return Err("Couldn't open {} for writing", path.string());
+    }
+    output.write(s_magic.data(), s_magic.size());
+    output.put(static_cast<char>(s_version));
+    const uint32_t length = manifest.size();
+    for (int i = 0; i < 4; i++) {
+        output.put(static_cast<char>((length >> (i * 8)) & 0xff));
+    }
+    output.write(manifest.data(), manifest.size());
+
+    for (const Blob& blob : blobs) {
+        if (token.cancelled()) {
+            return Err("Export cancelled");
+        }
+        std::unique_ptr<std::istream> input = SongPack::get().open(blob.path);
+        if (!input) {
+            return Err("Couldn't open {}", blob.path.string());
+        }
+        GEODE_UNWRAP_INTO(std::string hash,
+                          copy(*input, output, blob.size, *chunk));
+        if (hash != blob.hash) {
+            return Err("{} changed while exporting", blob.path.string());
+        }
+        summary.bytes += blob.size;
+    }
+    summary.blobs = blobs.size();
+
+    output.close();
+    if (!output) {
+        return Err("Couldn't finish writing {}", path.string());
+    }
+    return Ok(std::move(summary));
+}
+
+struct ImportedBundle {
+    matjson::Value songs;
+    // hash -> local file with the same contents
+    std::unordered_map<std::string, std::filesystem::path> blobs;
+    // Files created by this import, removed again if the commit fails
+    std::vector<std::filesystem::path> written;
+    // Files taken back from the deletion queue, queued again if the commit
+    // fails
+    std::vector<std::filesystem::path> kept;
+    BundleSummary summary;
+};
+
+void removeAll(const std::vector<std::filesystem::path>& paths) {
+    for (const std::filesystem::path& path : paths) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+}
+
+void requeueAll(std::vector<std::filesystem::path> paths) {
+    if (paths.empty()) {
+        return;
+    }
+    // The queue batches on the main thread
+    Executor::get().runOnMainThread([paths = std::move(paths)]() {
+        for (const std::filesystem::path& path : paths) {
+            DeletionQueue::get().enqueue(path);
+        }
+    });
+}
+
+// Any pending delete of a file the import reuses or replaces has to go
+// first, or the worker deletes it right after the import
+void keep(const std::filesystem::path& path, ImportedBundle& bundle) {
+    if (DeletionQueue::get().cancel(path)) {
+        bundle.kept.push_back(path);
+    }
+}
+
+// A stored song whose audio matches a blob, if there is one
+class LocalBlobs {
+private:
+    std::shared_ptr<const ManifestSnapshot> m_snapshot;
+    // Hashed files grouped by size, filled on first use of a size
+    std::unordered_map<uint64_t,
+                       std::unordered_map<std::string, std::filesystem::path>>
+        m_bySize;
+
+public:
+    explicit LocalBlobs(std::shared_ptr<const ManifestSnapshot> snapshot)
+        : m_snapshot(std::move(snapshot)) {}
+
+    std::optional<std::filesystem::path> find(const std::string& hash,
+                                              uint64_t size, Chunk& chunk) {
+        auto it = m_bySize.find(size);
+        if (it == m_bySize.end()) {
+            it = m_bySize.emplace(size, this->hashSize(size, chunk)).first;
+        }
+        auto found = it->second.find(hash);
+        if (found == it->second.end()) {
+            return std::nullopt;
+        }
+        return found->second;
+    }
+
+    std::unordered_map<std::string, std::filesystem::path> hashSize(
+        uint64_t size, Chunk& chunk) {
+        std::unordered_map<std::string, std::filesystem::path> ret;
+        std::unordered_set<std::string> seen;
+
+        auto check = [&](const SongSnapshot& song) {
+            if (!song.path.has_value() || song.fileSize != size ||
+                !seen.insert(song.path->string()).second) {
+                return;
+            }
+            if (Result<std::string> hash = hashFile(song.path.value(), chunk);
+                hash.isOk()) {
+                ret.emplace(hash.unwrap(), song.path.value());
+            }
+        };
+
+        for (const auto& [id, nongs] : m_snapshot->nongs()) {
+            check(nongs->defaultSong);
+            for (const SongSnapshot& song : nongs->songs) {
+                check(song);
+            }
+        }
+        return ret;
+    }
+};
+
+Result<ImportedBundle> read(const std::filesystem::path& path,
+                            const std::filesystem::path& nongsPath,
+                            std::shared_ptr<const ManifestSnapshot> snapshot,
+                            const CancellationToken& token) {
+    std::ifstream input(path, std::ios_base::binary);
+    if (!input.is_open()) {
+        return Err("Couldn't open {}", path.string());
+    }
+
+    std::array<char, 4> magic;
+    input.read(magic.data(), magic.size());
+    const int version = input.get();
+    if (!input || magic != s_magic) {
+        return Err("{} isn't a nong bundle", path.string());
+    }
+    if (version != s_version) {
+        return Err("Unsupported bundle version {}", version);
+    }
+
+    uint32_t length = 0;
+    for (int i = 0; i < 4; i++) {
+        length |= static_cast<uint32_t>(input.get() & 0xff) << (i * 8);
+    }
+    std::string manifestText(length, '\0');
+    input.read(manifestText.data(), length);
+    if (!input) {
+        return Err("Bundle manifest is truncated");
+    }
+    GEODE_UNWRAP_INTO(matjson::Value manifest, matjson::parse(manifestText));
+    if (!manifest["songs"].isObject() || !manifest["blobs"].isArray()) {
+        return Err("Bundle manifest is invalid");
+    }
+
+    ImportedBundle ret;
+    ret.songs = manifest["songs"];
+    auto chunk = std::make_unique<Chunk>();
+    LocalBlobs local(std::move(snapshot));
+
+    auto fail = [&ret](std::string error) -> Result<ImportedBundle> {
+        removeAll(ret.written);
+        requeueAll(std::move(ret.kept));
+        return Err(std::move(error));
+    };
+
+    for (const matjson::Value& blob : manifest["blobs"].asArray().unwrap()) {
+        if (token.cancelled()) {
+            return fail("Import cancelled");
+        }
+
+        const std::string hash = blob["hash"].asString().unwrapOr("");
+        const uint64_t size = blob["size"].asUInt().unwrapOr(0);
+        const std::string extension =
+            blob["extension"].asString().unwrapOr(".mp3");
+        if (hash.empty() || hash.find_first_of("/\\.") != std::string::npos ||
+            extension.find_first_of("/\\") != std::string::npos) {
+            return fail("Bundle lists an invalid blob");
+        }
+        ret.summary.blobs++;
+
+        // Imported earlier, or already stored for some song
+        const std::filesystem::path destination =
+            nongsPath / fmt::format("{}-{}{}", hash, size, extension);
+        keep(destination, ret);
+        std::error_code ec;
+        std::optional<std::filesystem::path> existing;
+        if (std::filesystem::file_size(destination, ec) == size && !ec) {
+            existing = destination;
+        } else {
+            existing = local.find(hash, size, *chunk);
+            // The song it's from may have been deleted since the snapshot
+            if (existing.has_value()) {
+                keep(existing.value(), ret);
+                if (!SongPack::get().exists(existing.value())) {
+                    existing.reset();
+                }
+            }
+        }
+
+        if (existing.has_value()) {
+            input.seekg(size, std::ios_base::cur);
+            if (!input) {
+                return fail("Bundle is truncated");
+            }
+            ret.blobs.emplace(hash, existing.value());
+            ret.summary.blobsSkipped++;
+            continue;
+        }
+
+        std::filesystem::path partial = destination;
+        partial += ".part";
+        {
+            std::ofstream output(partial, std::ios_base::binary);
+            if (!output.is_open()) {
+                return fail(
+                    fmt::format("Couldn't create {}", partial.string()));
+            }
+            Result<std::string> copied = copy(input, output, size, *chunk);
+            output.close();
+            if (copied.isErr() || copied.unwrap() != hash) {
+                std::filesystem::remove(partial, ec);
+                return fail(copied.isErr() ? copied.unwrapErr()
+                                           : "Bundle audio is corrupted");
+            }
+        }
+        std::filesystem::rename(partial, destination, ec);
+        if (ec) {
+            std::filesystem::remove(partial, ec);
+            return fail(fmt::format("Couldn't store {}", destination.string()));
+        }
+
+        ret.written.push_back(destination);
+        ret.blobs.emplace(hash, destination);
+        ret.summary.bytes += size;
+    }
+
+    return Ok(std::move(ret));
+}
+
+template <class T>
+void importSongs(const matjson::Value& songs, ImportedBundle& bundle,
+                 Nongs& current, int songID,
+                 std::vector<std::unique_ptr<T>>& into,
+                 std::unordered_set<std::string>& imported) {
+    if (!songs.isArray()) {
+        return;
+    }
+
+    for (matjson::Value song : songs.asArray().unwrap()) {
+        auto blob = bundle.blobs.find(song["blob"].asString().unwrapOr(""));
+        if (blob == bundle.blobs.end()) {
+            continue;
+        }
+        setPath(song, blob->second);
+
+        Result<T> res = matjson::Serialize<T>::fromJson(song, songID);
+        if (res.isErr()) {
+            log::error("Skipping bundled song: {}", res.unwrapErr());
+            continue;
+        }
+        T parsed = res.unwrap();
+        const std::string uniqueID = parsed.metadata()->uniqueID;
+        if (current.findSong(uniqueID).has_value() ||
+            !imported.insert(uniqueID).second) {
+            continue;
+        }
+
+        into.push_back(std::make_unique<T>(std::move(parsed)));
+        bundle.summary.songs++;
+    }
+}
+
+Result<BundleSummary> apply(ImportedBundle&& bundle) {
+    Transaction transaction;
+
+    for (const auto& [key, value] : bundle.songs) {
+        const int id = std::strtol(key.c_str(), nullptr, 10);
+        if (id == 0) {
+            continue;
+        }
+        std::optional<Nongs*> current = NongManager::get().getNongs(id);
+        if (!current.has_value()) {
+            bundle.summary.missingIDs.push_back(id);
+            continue;
+        }
+
+        Nongs incoming(id);
+        std::unordered_set<std::string> imported;
+        importSongs(value["locals"], bundle, *current.value(), id,
+                    incoming.locals(), imported);
+        importSongs(value["youtube"], bundle, *current.value(), id,
+                    incoming.youtube(), imported);
+        importSongs(value["hosted"], bundle, *current.value(), id,
+                    incoming.hosted(), imported);
+        if (imported.empty()) {
+            continue;
+        }
+
+        bundle.summary.songIDs++;
+        transaction.addNongs(std::move(incoming));
+
+        const std::string active = value["active"].asString().unwrapOr("");
+        if (imported.contains(active)) {
+            transaction.setActive(id, active);
+        }
+    }
+
+    if (Result<> res = transaction.commit(); res.isErr()) {
+        removeAll(bundle.written);
+        requeueAll(std::move(bundle.kept));
+        return Err(res.unwrapErr());
+    }
+
+    // A matching file may have been queued for deletion with its old song
+    // since read() kept it
+    for (const auto& [hash, path] : bundle.blobs) {
+        DeletionQueue::get().cancel(path);
+    }
+    return Ok(std::move(bundle.summary));
+}
+
+}  // namespace
+
+void exportTo(const std::vector<int>& songIDs,
+              const std::filesystem::path& path, Callback callback) {
+    Executor::get().submit(
+        Lane::Background,
+        [plan = plan(songIDs), path](const CancellationToken& token) mutable {
+            return write(std::move(plan), path, token);
+        },
+        std::move(callback));
+}
+
+void importFrom(const std::filesystem::path& path, Callback callback) {
+    Executor::get().submit(
+        Lane::Background,
+        [path, nongsPath = NongManager::get().baseNongsPath(),
+         snapshot = NongManager::get().snapshot()](
+            const CancellationToken& token) {
+            return read(path, nongsPath, snapshot, token);
+        },
+        [callback = std::move(callback)](Result<ImportedBundle> res) {
+            if (res.isErr()) {
+                callback(Err(res.unwrapErr()));
+                return;
+            }
+            callback(apply(res.unwrap()));
+        });
+}
+
+}  // namespace bundle
+
+}  // namespace storage
+
+}  // namespace jukebox
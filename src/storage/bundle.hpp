@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "Geode/Result.hpp"
+
+namespace jukebox {
+
+namespace storage {
+
+struct BundleSummary {
+    size_t songIDs = 0;
+    size_t songs = 0;
+    size_t blobs = 0;
+    // Blobs that were already stored locally and weren't copied
+    size_t blobsSkipped = 0;
+    // Audio bytes written to the bundle or to the nongs folder
+    uint64_t bytes = 0;
+    // Song IDs that aren't set up on this install, only on import
+    std::vector<int> missingIDs;
+};
+
+/**
+ * Single file containing the custom songs of some song IDs and their
+ * audio, so a level's setup can be moved between installs.
+ *
+ * Layout: "JBNB", version (u8), manifest length (u32 LE), manifest JSON,
+ * then the bytes of every blob listed in the manifest, in order. Blobs are
+ * keyed by a hash of their contents, each file is stored once no matter
+ * how many songs use it.
+ *
+ * Both directions stream through a fixed buffer and do their I/O on a
+ * worker. Callbacks run on the main thread.
+ */
+namespace bundle {
+
+using Callback = std::function<void(geode::Result<BundleSummary>)>;
+
+constexpr uint8_t s_version = 1;
+
+/**
+ * Writes every stored song of the song IDs that has its audio on disk
+ */
+void exportTo(const std::vector<int>& songIDs,
+              const std::filesystem::path& path, Callback callback);
+
+/**
+ * Stores the songs of a bundle. Blobs that match a file already on disk
+ * are skipped, the rest are copied to the nongs folder. All song IDs are
+ * then committed in one Transaction, nothing is kept if it fails.
+ */
+void importFrom(const std::filesystem::path& path, Callback callback);
+
+}  // namespace bundle
+
+}  // namespace storage
+
+}  // namespace jukebox
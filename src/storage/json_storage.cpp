@@ -0,0 +1,152 @@
+#include "storage/json_storage.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+
+#include "io/io_backend.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace storage {
+
+std::filesystem::path JsonStorage::recordPath(int songID) const {
+    return m_directory / fmt::format("{}.json", songID);
+}
+
+Result<matjson::Value> JsonStorage::readRecord(
+    const std::filesystem::path& path) const {
+    std::ifstream input(path, std::ios::binary);
+    if (!input.is_open()) {
+        return Err(
+            fmt::format("Couldn't open file: {}", path.filename().string()));
+    }
+
+    // Did some brief research, this seems to be the most efficient method
+    // https://insanecoding.blogspot.com/2011/11/how-to-read-in-file-in-c.html
+    std::string contents;
+    input.seekg(0, std::ios::end);
+    contents.resize(input.tellg());
+    input.seekg(0, std::ios::beg);
+    input.read(&contents[0], contents.size());
+    input.close();
+
+    return matjson::parse(std::string_view(contents))
+        .mapErr([](std::string err) {
+            return fmt::format("Couldn't parse JSON from file: {}", err);
+        });
+}
+
+Result<> JsonStorage::open() {
+    std::error_code ec;
+    if (!std::filesystem::exists(m_directory, ec)) {
+        log::info("No manifest directory found. Creating...");
+        std::filesystem::create_directories(m_directory, ec);
+        if (ec) {
+            return Err(fmt::format("Couldn't create manifest directory: {}",
+                                   ec.message()));
+        }
+    }
+    return Ok();
+}
+
+Result<std::optional<matjson::Value>> JsonStorage::load(int songID) {
+    std::filesystem::path path = this->recordPath(songID);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return Ok(std::nullopt);
+    }
+
+    GEODE_UNWRAP_INTO(matjson::Value json, this->readRecord(path));
+    return Ok(std::move(json));
+}
+
+Result<> JsonStorage::forEach(const RecordCallback& callback) {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(m_directory, ec);
+    if (ec) {
+        return Err(fmt::format("Couldn't read manifest directory: {}",
+                               ec.message()));
+    }
+
+    for (const std::filesystem::directory_entry& entry : it) {
+        if (entry.path().extension() != ".json") {
+            continue;
+        }
+
+        // Watch someone edit a json name and have the game crash
+        int id = 0;
+        std::string stem = entry.path().stem().string();
+        try {
+            id = std::stoi(stem);
+        } catch (...) {
+        }
+        if (id == 0) {
+            log::error("Invalid filename {}", entry.path().filename());
+            continue;
+        }
+
+        callback(id, this->readRecord(entry.path()));
+    }
+
+    return Ok();
+}
+
+Result<> JsonStorage::apply(const std::vector<Write>& batch) {
+    // Kept alive until the backend is done with them
+    std::vector<std::string> dumped;
+    dumped.reserve(batch.size());
+    std::vector<io::FileWrite> writes;
+    writes.reserve(batch.size());
+
+    for (const Write& write : batch) {
+        const std::filesystem::path path = this->recordPath(write.songID);
+
+        if (!write.data.has_value()) {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+            continue;
+        }
+
+        // Records are committed on the main thread, an fsync per commit
+        // would stall the frame
+        const std::string& data =
+            dumped.emplace_back(write.data->dump(matjson::NO_INDENTATION));
+        writes.push_back(io::FileWrite{
+            .path = path,
+            .data = std::span(reinterpret_cast<const uint8_t*>(data.data()),
+                              data.size()),
+            .sync = false});
+    }
+
+    return io::backend().write(writes);
+}
+
+Result<> JsonStorage::quarantine(int songID) {
+    const std::filesystem::path path = this->recordPath(songID);
+    std::error_code ec;
+    std::filesystem::rename(
+        path, m_directory / fmt::format("{}.bak", path.filename().string()),
+        ec);
+    if (ec) {
+        return Err(fmt::format("Couldn't back up {}: {}", path.filename(),
+                               ec.message()));
+    }
+    return Ok();
+}
+
+}  // namespace storage
+
+}  // namespace jukebox
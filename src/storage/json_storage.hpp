@@ -0,0 +1,45 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+
+#include "storage/storage_backend.hpp"
+
+namespace jukebox {
+
+namespace storage {
+
+/**
+ * One <id>.json file per song ID in a directory. This is the original
+ * manifest format. Batches are written file by file, so they aren't atomic.
+ */
+class JsonStorage final : public StorageBackend {
+private:
+    std::filesystem::path m_directory;
+
+    std::filesystem::path recordPath(int songID) const;
+    geode::Result<matjson::Value> readRecord(
+        const std::filesystem::path& path) const;
+
+public:
+    JsonStorage(std::filesystem::path directory)
+        : m_directory(std::move(directory)) {}
+
+    std::string name() const override { return "json"; }
+    const std::filesystem::path& directory() const { return m_directory; }
+
+    geode::Result<> open() override;
+    geode::Result<std::optional<matjson::Value>> load(int songID) override;
+    geode::Result<> forEach(const RecordCallback& callback) override;
+    geode::Result<> apply(const std::vector<Write>& batch) override;
+    geode::Result<> quarantine(int songID) override;
+};
+
+}  // namespace storage
+
+}  // namespace jukebox
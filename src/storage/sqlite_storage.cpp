@@ -0,0 +1,253 @@
+#ifdef JUKEBOX_SQLITE_STORAGE
+
+#include "storage/sqlite_storage.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/core.h>
+#include <sqlite3.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+
+#include "storage/json_storage.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace storage {
+
+namespace {
+
+// Finalizes the statement when going out of scope
+class Statement {
+private:
+    sqlite3_stmt* m_stmt = nullptr;
+
+public:
+    Statement(sqlite3* db, const char* sql) {
+        sqlite3_prepare_v2(db, sql, -1, &m_stmt, nullptr);
+    }
+    ~Statement() { sqlite3_finalize(m_stmt); }
+
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    bool valid() const { return m_stmt != nullptr; }
+    sqlite3_stmt* get() const { return m_stmt; }
+};
+
+Result<matjson::Value> parseColumn(sqlite3_stmt* stmt, int column) {
+    const char* text =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    int size = sqlite3_column_bytes(stmt, column);
+    if (!text) {
+        return Err("Empty record");
+    }
+    return matjson::parse(std::string_view(text, size))
+        .mapErr([](std::string err) {
+            return fmt::format("Couldn't parse JSON from database: {}", err);
+        });
+}
+
+}  // namespace
+
+SqliteStorage::~SqliteStorage() {
+    if (m_db) {
+        sqlite3_close(m_db);
+    }
+}
+
+Result<> SqliteStorage::exec(const char* sql) {
+    char* error = nullptr;
+    if (sqlite3_exec(m_db, sql, nullptr, nullptr, &error) != SQLITE_OK) {
+        std::string message = error ? error : sqlite3_errmsg(m_db);
+        sqlite3_free(error);
+        return Err(message);
+    }
+    return Ok();
+}
+
+Result<> SqliteStorage::open() {
+    if (m_db) {
+        return Ok();
+    }
+
+    // SQLite wants UTF-8, string() is the ANSI code page on Windows and
+    // throws for names it can't hold
+    const std::u8string path = m_databasePath.u8string();
+    if (sqlite3_open(reinterpret_cast<const char*>(path.c_str()), &m_db) !=
+        SQLITE_OK) {
+        std::string err = sqlite3_errmsg(m_db);
+        sqlite3_close(m_db);
+        m_db = nullptr;
+        return Err(fmt::format("Couldn't open database: {}", err));
+    }
+
+    // A half set up database must not be used
+    Result<> res = this->prepare();
+    if (res.isErr()) {
+        sqlite3_close(m_db);
+        m_db = nullptr;
+    }
+    return res;
+}
+
+Result<> SqliteStorage::prepare() {
+    GEODE_UNWRAP(this->exec("PRAGMA journal_mode=WAL"));
+    GEODE_UNWRAP(this->exec("PRAGMA synchronous=NORMAL"));
+    GEODE_UNWRAP(
+        this->exec("CREATE TABLE IF NOT EXISTS nongs ("
+                   "song_id INTEGER PRIMARY KEY, data TEXT NOT NULL)"));
+    GEODE_UNWRAP(
+        this->exec("CREATE TABLE IF NOT EXISTS quarantine ("
+                   "song_id INTEGER NOT NULL, data TEXT NOT NULL)"));
+    GEODE_UNWRAP(
+        this->exec("CREATE TABLE IF NOT EXISTS meta ("
+                   "key TEXT PRIMARY KEY, value TEXT NOT NULL)"));
+
+    return this->importLegacy();
+}
+
+Result<> SqliteStorage::importLegacy() {
+    {
+        Statement stmt(m_db,
+                       "SELECT 1 FROM meta WHERE key = 'imported-json'");
+        if (!stmt.valid()) {
+            return Err(sqlite3_errmsg(m_db));
+        }
+        if (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+            return Ok();
+        }
+    }
+
+    JsonStorage legacy(m_legacyDirectory);
+    std::vector<Write> batch;
+    GEODE_UNWRAP(legacy.open());
+    GEODE_UNWRAP(legacy.forEach(
+        [&batch](int songID, Result<matjson::Value> record) {
+            if (record.isErr()) {
+                log::error("Skipping {}.json: {}", songID, record.unwrapErr());
+                return;
+            }
+            batch.push_back(Write{songID, std::move(record.unwrap())});
+        }));
+
+    GEODE_UNWRAP(this->apply(batch));
+    GEODE_UNWRAP(this->exec(
+        "INSERT OR REPLACE INTO meta (key, value) VALUES ('imported-json', "
+        "'1')"));
+
+    log::info("Imported {} records from the JSON manifest", batch.size());
+    return Ok();
+}
+
+Result<std::optional<matjson::Value>> SqliteStorage::load(int songID) {
+    Statement stmt(m_db, "SELECT data FROM nongs WHERE song_id = ?");
+    if (!stmt.valid()) {
+        return Err(sqlite3_errmsg(m_db));
+    }
+    sqlite3_bind_int(stmt.get(), 1, songID);
+
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        return Ok(std::nullopt);
+    }
+
+    GEODE_UNWRAP_INTO(matjson::Value json, parseColumn(stmt.get(), 0));
+    return Ok(std::move(json));
+}
+
+Result<> SqliteStorage::forEach(const RecordCallback& callback) {
+    Statement stmt(m_db, "SELECT song_id, data FROM nongs");
+    if (!stmt.valid()) {
+        return Err(sqlite3_errmsg(m_db));
+    }
+
+    int rc;
+    while ((rc = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+        callback(sqlite3_column_int(stmt.get(), 0),
+                 parseColumn(stmt.get(), 1));
+    }
+
+    if (rc != SQLITE_DONE) {
+        return Err(sqlite3_errmsg(m_db));
+    }
+    return Ok();
+}
+
+Result<> SqliteStorage::apply(const std::vector<Write>& batch) {
+    if (batch.empty()) {
+        return Ok();
+    }
+
+    GEODE_UNWRAP(this->exec("BEGIN IMMEDIATE"));
+
+    Statement upsert(
+        m_db, "INSERT OR REPLACE INTO nongs (song_id, data) VALUES (?, ?)");
+    Statement remove(m_db, "DELETE FROM nongs WHERE song_id = ?");
+    if (!upsert.valid() || !remove.valid()) {
+        std::string err = sqlite3_errmsg(m_db);
+        (void)this->exec("ROLLBACK");
+        return Err(err);
+    }
+
+    for (const Write& write : batch) {
+        sqlite3_stmt* stmt = write.data.has_value() ? upsert.get()
+                                                    : remove.get();
+        sqlite3_bind_int(stmt, 1, write.songID);
+
+        std::string text;
+        if (write.data.has_value()) {
+            text = write.data->dump(matjson::NO_INDENTATION);
+            sqlite3_bind_text(stmt, 2, text.c_str(),
+                              static_cast<int>(text.size()), SQLITE_STATIC);
+        }
+
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+
+        if (rc != SQLITE_DONE) {
+            std::string err = sqlite3_errmsg(m_db);
+            (void)this->exec("ROLLBACK");
+            return Err(
+                fmt::format("Failed to write song {}: {}", write.songID, err));
+        }
+    }
+
+    return this->exec("COMMIT");
+}
+
+Result<> SqliteStorage::quarantine(int songID) {
+    GEODE_UNWRAP(this->exec("BEGIN IMMEDIATE"));
+
+    Statement move(m_db,
+                   "INSERT INTO quarantine (song_id, data) "
+                   "SELECT song_id, data FROM nongs WHERE song_id = ?");
+    Statement remove(m_db, "DELETE FROM nongs WHERE song_id = ?");
+    if (!move.valid() || !remove.valid()) {
+        std::string err = sqlite3_errmsg(m_db);
+        (void)this->exec("ROLLBACK");
+        return Err(err);
+    }
+
+    sqlite3_bind_int(move.get(), 1, songID);
+    sqlite3_bind_int(remove.get(), 1, songID);
+    if (sqlite3_step(move.get()) != SQLITE_DONE ||
+        sqlite3_step(remove.get()) != SQLITE_DONE) {
+        std::string err = sqlite3_errmsg(m_db);
+        (void)this->exec("ROLLBACK");
+        return Err(err);
+    }
+
+    return this->exec("COMMIT");
+}
+
+}  // namespace storage
+
+}  // namespace jukebox
+
+#endif
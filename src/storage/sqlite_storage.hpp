@@ -0,0 +1,62 @@
+#pragma once
+
+#ifdef JUKEBOX_SQLITE_STORAGE
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+
+#include "storage/storage_backend.hpp"
+
+struct sqlite3;
+
+namespace jukebox {
+
+namespace storage {
+
+/**
+ * Single SQLite database in WAL mode. Batches run in one transaction.
+ *
+ * On first open, records from the JSON manifest directory are imported so
+ * switching backends doesn't lose anything.
+ */
+class SqliteStorage final : public StorageBackend {
+private:
+    std::filesystem::path m_databasePath;
+    std::filesystem::path m_legacyDirectory;
+    sqlite3* m_db = nullptr;
+
+    geode::Result<> exec(const char* sql);
+    // Pragmas, tables and the JSON import, once the database is open
+    geode::Result<> prepare();
+    geode::Result<> importLegacy();
+
+public:
+    SqliteStorage(std::filesystem::path databasePath,
+                  std::filesystem::path legacyDirectory)
+        : m_databasePath(std::move(databasePath)),
+          m_legacyDirectory(std::move(legacyDirectory)) {}
+
+    SqliteStorage(const SqliteStorage&) = delete;
+    SqliteStorage& operator=(const SqliteStorage&) = delete;
+
+    ~SqliteStorage() override;
+
+    std::string name() const override { return "sqlite"; }
+
+    geode::Result<> open() override;
+    geode::Result<std::optional<matjson::Value>> load(int songID) override;
+    geode::Result<> forEach(const RecordCallback& callback) override;
+    geode::Result<> apply(const std::vector<Write>& batch) override;
+    geode::Result<> quarantine(int songID) override;
+};
+
+}  // namespace storage
+
+}  // namespace jukebox
+
+#endif
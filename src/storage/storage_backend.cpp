@@ -0,0 +1,49 @@
+#include "storage/storage_backend.hpp"
+
+#include <memory>
+
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "managers/nong_manager.hpp"
+#include "nong.hpp"
+#include "nong_serialize.hpp"
+#include "storage/json_storage.hpp"
+#include "storage/sqlite_storage.hpp"
+
+namespace jukebox {
+
+namespace storage {
+
+Write Write::from(Nongs& nongs) {
+    // Don't save manifest for songs with no nongs
+    if (nongs.locals().empty() && nongs.youtube().empty() &&
+        nongs.hosted().empty()) {
+        return Write{nongs.songID(), std::nullopt};
+    }
+
+    return Write{nongs.songID(), matjson::Serialize<Nongs>::toJson(nongs)};
+}
+
+std::unique_ptr<StorageBackend> createStorageBackend() {
+#ifdef JUKEBOX_SQLITE_STORAGE
+    auto sqlite = std::make_unique<SqliteStorage>(
+        geode::Mod::get()->getSaveDir() / "manifest.db",
+        NongManager::get().baseManifestPath());
+    geode::Result<> res = sqlite->open();
+    if (res.isOk()) {
+        return sqlite;
+    }
+    // The JSON files are kept after the import, so at worst this loses what
+    // was saved to the database since
+    geode::log::error("Couldn't open the SQLite manifest, using JSON files: {}",
+                      res.unwrapErr());
+#endif
+    return std::make_unique<JsonStorage>(NongManager::get().baseManifestPath());
+}
+
+}  // namespace storage
+
+}  // namespace jukebox
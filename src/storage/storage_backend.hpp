@@ -0,0 +1,79 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+
+#include "nong.hpp"
+
+namespace jukebox {
+
+namespace storage {
+
+/**
+ * A single change to persist. No data means the record is removed.
+ */
+struct Write {
+    int songID;
+    std::optional<matjson::Value> data;
+
+    /**
+     * Serializes a Nongs object. Song IDs without any custom song aren't
+     * stored at all.
+     */
+    static Write from(Nongs& nongs);
+};
+
+/**
+ * Where the manifest lives on disk. Records are the serialized JSON of one
+ * Nongs object, keyed by GD song ID.
+ */
+class StorageBackend {
+public:
+    using RecordCallback =
+        std::function<void(int songID, geode::Result<matjson::Value> record)>;
+
+    virtual ~StorageBackend() = default;
+
+    // Used in logs
+    virtual std::string name() const = 0;
+
+    virtual geode::Result<> open() = 0;
+
+    /**
+     * Loads a single record, nullopt if it isn't stored
+     */
+    virtual geode::Result<std::optional<matjson::Value>> load(int songID) = 0;
+
+    /**
+     * Calls the callback for every stored record. Records that fail to load
+     * are still passed along so the caller can quarantine them.
+     */
+    virtual geode::Result<> forEach(const RecordCallback& callback) = 0;
+
+    /**
+     * Applies all writes. Backends that support it do so atomically.
+     */
+    virtual geode::Result<> apply(const std::vector<Write>& batch) = 0;
+
+    /**
+     * Moves a broken record out of the way so it isn't loaded again, while
+     * keeping it around for manual recovery
+     */
+    virtual geode::Result<> quarantine(int songID) = 0;
+};
+
+/**
+ * Creates the backend selected at build time. Falls back to JSON files,
+ * with a logged error, if the SQLite database can't be opened.
+ */
+std::unique_ptr<StorageBackend> createStorageBackend();
+
+}  // namespace storage
+
+}  // namespace jukebox
@@ -0,0 +1,300 @@
+#include "transaction.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+
+#include "batch_committed.hpp"
+#include "managers/deletion_queue.hpp"
+#include "managers/index_manager.hpp"
+#include "managers/nong_manager.hpp"
+#include "nong.hpp"
+#include "nong_serialize.hpp"
+#include "storage/storage_backend.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+class Transaction::Impl {
+private:
+    friend class Transaction;
+
+    // Audio files to delete once the whole batch went through
+    struct PendingDeletes {
+        // Files of songs that were removed, kept if another song of the
+        // batch still points at them
+        std::vector<std::filesystem::path> released;
+        // Audio deleted on purpose, the song stays with the same path
+        std::vector<std::filesystem::path> audio;
+    };
+
+    struct Op {
+        int gdSongID;
+        std::function<Result<>(Nongs*, PendingDeletes&)> apply;
+    };
+
+    std::vector<Op> m_ops;
+
+    static void collectPath(Song* song,
+                            std::vector<std::filesystem::path>& paths) {
+        if (song->path().has_value()) {
+            paths.push_back(song->path().value());
+        }
+    }
+
+    void push(int gdSongID,
+              std::function<Result<>(Nongs*, PendingDeletes&)> apply) {
+        m_ops.push_back(Op{gdSongID, std::move(apply)});
+    }
+
+    static Result<> restore(Nongs* nongs, const matjson::Value& backup) {
+        GEODE_UNWRAP_INTO(
+            Nongs restored,
+            matjson::Serialize<Nongs>::fromJson(backup, nongs->songID()));
+        GEODE_UNWRAP(nongs->restore(std::move(restored)));
+        IndexManager::get().registerIndexNongs(nongs);
+        return Ok();
+    }
+
+    static void restoreAll(const std::vector<int>& touched,
+                           std::unordered_map<int, matjson::Value>& backups) {
+        for (int id : touched) {
+            std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+            if (!nongs.has_value()) {
+                continue;
+            }
+            if (Result<> res = restore(nongs.value(), backups.at(id));
+                res.isErr()) {
+                log::error("Failed to roll back song ID {}: {}", id,
+                           res.unwrapErr());
+            }
+        }
+        NongManager::get().publishSnapshot(touched);
+        // Songs the batch removed come back as new objects
+        event::BatchCommitted(touched, true).post();
+    }
+
+    static bool isReferenced(const std::filesystem::path& path,
+                             const std::vector<int>& touched) {
+        for (int id : touched) {
+            std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+            if (!nongs.has_value()) {
+                continue;
+            }
+            Nongs* n = nongs.value();
+            if (n->defaultSong()->path() == path) {
+                return true;
+            }
+            for (const std::unique_ptr<LocalSong>& i : n->locals()) {
+                if (i->path() == path) {
+                    return true;
+                }
+            }
+            for (const std::unique_ptr<YTSong>& i : n->youtube()) {
+                if (i->path() == path) {
+                    return true;
+                }
+            }
+            for (const std::unique_ptr<HostedSong>& i : n->hosted()) {
+                if (i->path() == path) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    Result<> commit() {
+        if (m_ops.empty()) {
+            return Ok();
+        }
+
+        NongManager& manager = NongManager::get();
+        std::unordered_map<int, matjson::Value> backups;
+        std::vector<int> touched;
+        PendingDeletes deletes;
+        Result<> res = Ok();
+
+        manager.m_batching = true;
+        for (Op& op : m_ops) {
+            std::optional<Nongs*> nongs = manager.getNongs(op.gdSongID);
+            if (!nongs.has_value()) {
+                res = Err(fmt::format("Song {} not initialized in manifest",
+                                      op.gdSongID));
+                break;
+            }
+
+            if (!backups.contains(op.gdSongID)) {
+                backups.emplace(op.gdSongID, matjson::Serialize<Nongs>::toJson(
+                                                 *nongs.value()));
+                touched.push_back(op.gdSongID);
+            }
+
+            res = op.apply(nongs.value(), deletes)
+                      .mapErr([&op](std::string err) {
+                          return fmt::format("Song {}: {}", op.gdSongID, err);
+                      });
+            if (res.isErr()) {
+                break;
+            }
+        }
+
+        if (res.isErr()) {
+            restoreAll(touched, backups);
+            manager.m_batching = false;
+            m_ops.clear();
+            return res;
+        }
+
+        // Single write, atomic when the backend supports it
+        manager.publishSnapshot(touched);
+        std::vector<storage::Write> batch;
+        for (int id : touched) {
+            Nongs* nongs = manager.getNongs(id).value();
+            batch.push_back(storage::Write::from(*nongs));
+        }
+
+        if (Result<> saved = manager.storage().apply(batch); saved.isErr()) {
+            restoreAll(touched, backups);
+            // Non-atomic backends may have written part of the batch
+            std::vector<storage::Write> revert;
+            for (int id : touched) {
+                revert.push_back(
+                    storage::Write::from(*manager.getNongs(id).value()));
+            }
+            (void)manager.storage().apply(revert);
+            manager.m_batching = false;
+            m_ops.clear();
+            return Err(fmt::format("Failed to save batch: {}",
+                                   saved.unwrapErr()));
+        }
+
+        manager.m_batching = false;
+        m_ops.clear();
+
+        std::unordered_set<std::filesystem::path, DeletionQueue::PathHash>
+            deleted;
+        // Their songs still reference them, that's the point
+        for (const std::filesystem::path& path : deletes.audio) {
+            if (deleted.insert(path).second) {
+                DeletionQueue::get().enqueue(path);
+            }
+        }
+        for (const std::filesystem::path& path : deletes.released) {
+            if (!deleted.insert(path).second ||
+                isReferenced(path, touched)) {
+                continue;
+            }
+            DeletionQueue::get().enqueue(path);
+        }
+
+        event::BatchCommitted(std::move(touched)).post();
+        return Ok();
+    }
+};
+
+Transaction::Transaction() : m_impl(std::make_unique<Impl>()) {}
+Transaction::Transaction(Transaction&&) = default;
+Transaction& Transaction::operator=(Transaction&&) = default;
+Transaction::~Transaction() = default;
+
+Transaction& Transaction::setActive(int gdSongID, const std::string& uniqueID) {
+    m_impl->push(gdSongID, [uniqueID](Nongs* nongs, Impl::PendingDeletes&) {
+        return nongs->setActive(uniqueID);
+    });
+    return *this;
+}
+
+Transaction& Transaction::deleteSong(int gdSongID, const std::string& uniqueID,
+                                     bool audio) {
+    m_impl->push(gdSongID, [uniqueID, audio](Nongs* nongs,
+                                             Impl::PendingDeletes& deletes) {
+        if (audio) {
+            if (std::optional<Song*> song = nongs->findSong(uniqueID)) {
+                Impl::collectPath(song.value(), deletes.released);
+            }
+        }
+        return nongs->deleteSong(uniqueID, false);
+    });
+    return *this;
+}
+
+Transaction& Transaction::deleteSongAudio(int gdSongID,
+                                          const std::string& uniqueID) {
+    m_impl->push(gdSongID, [uniqueID](Nongs* nongs,
+                                      Impl::PendingDeletes& deletes) {
+        if (nongs->defaultSong()->metadata()->uniqueID == uniqueID) {
+            return Result<>(Err("Cannot delete audio of the default song"));
+        }
+
+        std::optional<Song*> song = nongs->findSong(uniqueID);
+        if (!song.has_value()) {
+            return Result<>(Err("No song found with given path for song ID"));
+        }
+        if (song.value()->type() == NongType::LOCAL) {
+            return Result<>(Err("Cannot delete audio of local songs"));
+        }
+
+        if (nongs->active()->metadata()->uniqueID == uniqueID) {
+            GEODE_UNWRAP(
+                nongs->setActive(nongs->defaultSong()->metadata()->uniqueID));
+        }
+        Impl::collectPath(song.value(), deletes.audio);
+        return Result<>(Ok());
+    });
+    return *this;
+}
+
+Transaction& Transaction::deleteAllSongs(int gdSongID) {
+    m_impl->push(gdSongID, [](Nongs* nongs, Impl::PendingDeletes& deletes) {
+        std::vector<std::string> ids;
+        for (const std::unique_ptr<LocalSong>& i : nongs->locals()) {
+            ids.push_back(i->metadata()->uniqueID);
+            Impl::collectPath(i.get(), deletes.released);
+        }
+        for (const std::unique_ptr<YTSong>& i : nongs->youtube()) {
+            ids.push_back(i->metadata()->uniqueID);
+            Impl::collectPath(i.get(), deletes.released);
+        }
+        for (const std::unique_ptr<HostedSong>& i : nongs->hosted()) {
+            ids.push_back(i->metadata()->uniqueID);
+            Impl::collectPath(i.get(), deletes.released);
+        }
+
+        for (const std::string& id : ids) {
+            GEODE_UNWRAP(nongs->deleteSong(id, false));
+        }
+        return nongs->setActive(nongs->defaultSong()->metadata()->uniqueID);
+    });
+    return *this;
+}
+
+Transaction& Transaction::addNongs(Nongs&& nongs) {
+    int id = nongs.songID();
+    // std::function needs a copyable callable
+    std::shared_ptr<Nongs> ptr = std::make_shared<Nongs>(std::move(nongs));
+    m_impl->push(id, [ptr](Nongs* nongs, Impl::PendingDeletes&) {
+        return nongs->merge(std::move(*ptr));
+    });
+    return *this;
+}
+
+size_t Transaction::size() const { return m_impl->m_ops.size(); }
+
+Result<> Transaction::commit() { return m_impl->commit(); }
+
+void Transaction::rollback() { m_impl->m_ops.clear(); }
+
+}  // namespace jukebox
@@ -0,0 +1,67 @@
+#include "ui/list/build_queue.hpp"
+
+#include <chrono>
+#include <string>
+#include <utility>
+
+namespace jukebox {
+
+void BuildQueue::push(const std::string& key, int priority, Task task) {
+    this->cancel(key);
+
+    const uint64_t order = m_nextOrder++;
+    m_entries.emplace(key, Entry{priority, order, std::move(task)});
+    m_order.emplace(std::make_pair(priority, order), key);
+}
+
+void BuildQueue::reprioritize(const std::string& key, int priority) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second.priority == priority) {
+        return;
+    }
+
+    m_order.erase({it->second.priority, it->second.order});
+    it->second.priority = priority;
+    m_order.emplace(std::make_pair(priority, it->second.order), key);
+}
+
+bool BuildQueue::cancel(const std::string& key) {
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    m_order.erase({it->second.priority, it->second.order});
+    m_entries.erase(it);
+    return true;
+}
+
+void BuildQueue::clear() {
+    m_entries.clear();
+    m_order.clear();
+}
+
+size_t BuildQueue::run(std::chrono::microseconds budget) {
+    const auto start = std::chrono::steady_clock::now();
+    size_t ran = 0;
+
+    while (!m_order.empty()) {
+        if (ran > 0 && std::chrono::steady_clock::now() - start >= budget) {
+            break;
+        }
+
+        auto first = m_order.begin();
+        auto it = m_entries.find(first->second);
+        Task task = std::move(it->second.task);
+        m_entries.erase(it);
+        m_order.erase(first);
+
+        // May push or cancel other tasks
+        task();
+        ran++;
+    }
+
+    return ran;
+}
+
+}  // namespace jukebox
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace jukebox {
+
+/**
+ * Node construction spread over frames. Tasks are keyed so they can be
+ * re-prioritized or cancelled while waiting, and run lowest priority first
+ * until the frame budget is used up.
+ */
+class BuildQueue {
+public:
+    using Task = std::function<void()>;
+
+protected:
+    struct Entry {
+        int priority;
+        uint64_t order;
+        Task task;
+    };
+
+    std::unordered_map<std::string, Entry> m_entries;
+    // (priority, insertion order) -> key
+    std::map<std::pair<int, uint64_t>, std::string> m_order;
+    uint64_t m_nextOrder = 0;
+
+public:
+    /**
+     * Queues a task, replacing the one already queued under the same key
+     */
+    void push(const std::string& key, int priority, Task task);
+
+    /**
+     * Changes the priority of a queued task, keeping its place among tasks
+     * with the same priority
+     */
+    void reprioritize(const std::string& key, int priority);
+
+    bool cancel(const std::string& key);
+    void clear();
+
+    bool contains(const std::string& key) const {
+        return m_entries.contains(key);
+    }
+    bool empty() const { return m_entries.empty(); }
+    size_t size() const { return m_entries.size(); }
+
+    /**
+     * Runs tasks until the budget is spent. At least one task runs so the
+     * queue always makes progress, even if a single task is over budget.
+     *
+     * @return how many tasks ran
+     */
+    size_t run(std::chrono::microseconds budget);
+};
+
+}  // namespace jukebox
@@ -1,5 +1,10 @@
 #include "ui/list/index_song_cell.hpp"
 
+#include <optional>
+#include <string>
+
+#include <fmt/core.h>
+
 #include "GUI/CCControlExtension/CCScale9Sprite.h"
 #include "Geode/cocos/base_nodes/CCNode.h"
 #include "Geode/ui/Layout.hpp"
@@ -12,10 +17,13 @@
 #include "Geode/loader/Event.hpp"
 #include "ccTypes.h"
 
+#include "events/link_probed.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_failed.hpp"
 #include "events/song_download_progress.hpp"
 #include "events/start_download.hpp"
 #include "index.hpp"
+#include "managers/link_prober.hpp"
 
 using namespace jukebox::index;
 
@@ -27,11 +35,6 @@ bool IndexSongCell::init(IndexSongMetadata* song, int gdId,
         return false;
     }
 
-    m_song = song;
-    m_gdId = gdId;
-
-    m_downloadListener.bind(this, &IndexSongCell::onDownloadProgress);
-
     this->setContentSize(size);
     this->setAnchorPoint({0.5f, 0.5f});
     constexpr float PADDING_X = 12.0f;
@@ -53,23 +56,17 @@ bool IndexSongCell::init(IndexSongMetadata* song, int gdId,
     m_songInfoNode->setContentSize({songInfoWidth, maxSize.height});
     m_songInfoNode->setID("song-info-node");
 
-    m_songNameLabel =
-        CCLabelBMFont::create(m_song->name.c_str(), "bigFont.fnt");
+    // Text is set in rebind()
+    m_songNameLabel = CCLabelBMFont::create("", "bigFont.fnt");
     m_songNameLabel->setAnchorPoint({0.0f, 0.5f});
-    m_songNameLabel->limitLabelWidth(songInfoWidth, 0.56f, 0.1f);
     m_songNameLabel->setID("song-info-label");
 
-    m_artistLabel =
-        CCLabelBMFont::create(m_song->artist.c_str(), "goldFont.fnt");
+    m_artistLabel = CCLabelBMFont::create("", "goldFont.fnt");
     m_artistLabel->setAnchorPoint({0.0f, 0.5f});
-    m_artistLabel->limitLabelWidth(songInfoWidth, 0.5f, 0.1f);
     m_songNameLabel->setID("artist-label");
 
-    m_indexNameLabel =
-        CCLabelBMFont::create(m_song->parentID->m_name.c_str(), "bigFont.fnt");
+    m_indexNameLabel = CCLabelBMFont::create("", "bigFont.fnt");
     m_indexNameLabel->setAnchorPoint({0.0f, 0.5f});
-    m_indexNameLabel->limitLabelWidth(songInfoWidth, 0.4f, 0.1f);
-    m_indexNameLabel->setColor({.r = 162, .g = 191, .b = 255});
     m_songNameLabel->setID("index-name-label");
 
     m_songInfoNode->addChild(m_songNameLabel);
@@ -130,9 +127,47 @@ bool IndexSongCell::init(IndexSongMetadata* song, int gdId,
             AxisAlignment::End));
 
     this->addChildAtPosition(m_downloadMenu, Anchor::Right, {-PADDING_X, 0.0f});
+
+    this->rebind(song, gdId);
     return true;
 }
 
+void IndexSongCell::rebind(IndexSongMetadata* song, int gdId) {
+    m_song = song;
+    m_gdId = gdId;
+
+    const float songInfoWidth = m_songInfoNode->getContentWidth();
+    m_songNameLabel->setString(m_song->name.c_str());
+    m_songNameLabel->limitLabelWidth(songInfoWidth, 0.56f, 0.1f);
+    m_artistLabel->setString(m_song->artist.c_str());
+    m_artistLabel->limitLabelWidth(songInfoWidth, 0.5f, 0.1f);
+
+    // A download of the previous song shows up here otherwise, one of this
+    // song shows again with its next progress event
+    if (m_downloading || m_progressContainer->isVisible()) {
+        this->resetDownload();
+    }
+
+    const event::SongKey key{m_gdId, m_song->uniqueID};
+    m_downloadListener =
+        event::SongDispatcher<event::SongDownloadProgress>::get().subscribe(
+            key, [this](auto* e) { this->onDownloadProgress(e); });
+    m_downloadFailedListener =
+        event::SongDispatcher<event::SongDownloadFailed>::get().subscribe(
+            key, [this](auto* e) { this->onDownloadFailed(e); });
+    m_linkListener = event::SongDispatcher<event::LinkProbed>::get().subscribe(
+        key, [this](auto* e) { this->onLinkProbed(e); });
+
+    this->updateLinkStatus();
+}
+
+void IndexSongCell::unbind() {
+    m_downloadListener.reset();
+    m_downloadFailedListener.reset();
+    m_linkListener.reset();
+    m_song = nullptr;
+}
+
 void IndexSongCell::onDownload(CCObject*) {
     if (m_downloading) {
         return;
@@ -150,12 +185,7 @@ void IndexSongCell::onDownload(CCObject*) {
     event::StartDownload(m_song, m_gdId).post();
 }
 
-ListenerResult IndexSongCell::onDownloadProgress(
-    event::SongDownloadProgress* e) {
-    if (e->gdSongID() != m_gdId || e->uniqueID() != m_song->uniqueID) {
-        return ListenerResult::Propagate;
-    }
-
+void IndexSongCell::onDownloadProgress(event::SongDownloadProgress* e) {
     if (!m_progressContainer->isVisible()) {
         CCSprite* newSpr =
             CCSprite::createWithSpriteFrameName("GJ_cancelDownloadBtn_001.png");
@@ -166,14 +196,13 @@ ListenerResult IndexSongCell::onDownloadProgress(
     }
 
     m_progressBar->setPercentage(e->progress());
-    return ListenerResult::Propagate;
 }
 
-ListenerResult IndexSongCell::onDownloadFailed(event::SongDownloadFailed* e) {
-    if (e->gdSongId() != m_gdId || e->uniqueId() != m_song->uniqueID) {
-        return ListenerResult::Propagate;
-    }
+void IndexSongCell::onDownloadFailed(event::SongDownloadFailed* e) {
+    this->resetDownload();
+}
 
+void IndexSongCell::resetDownload() {
     m_progressContainer->setVisible(false);
     m_progressBar->setPercentage(0.0f);
     CCSprite* downloadSpr =
@@ -182,8 +211,50 @@ ListenerResult IndexSongCell::onDownloadFailed(event::SongDownloadFailed* e) {
     m_downloadButton->setSprite(downloadSpr);
     m_downloadButton->setColor({255, 255, 255});
     m_downloading = false;
+}
+
+void IndexSongCell::onLinkProbed(event::LinkProbed* e) {
+    this->updateLinkStatus();
+}
+
+void IndexSongCell::updateLinkStatus() {
+    std::string text = m_song->parentID->m_name;
+    ccColor3B color = {.r = 162, .g = 191, .b = 255};
+    GLubyte opacity = 255;
+
+    std::optional<LinkStatus> status =
+        m_song->url.has_value() ? LinkProber::get().find(m_song->url.value())
+                                : std::nullopt;
+    if (status.has_value()) {
+        switch (status->state) {
+            case LinkState::Alive:
+                if (status->contentLength.has_value()) {
+                    text = fmt::format(
+                        "{} - {:.2f}MB", text,
+                        status->contentLength.value() / 1024.0 / 1024.0);
+                }
+                break;
+            case LinkState::Dead:
+                text = fmt::format("{} - Dead link ({})", text, status->code);
+                color = {.r = 255, .g = 110, .b = 110};
+                opacity = 140;
+                break;
+            case LinkState::Unreachable:
+                text = fmt::format("{} - Host not responding", text);
+                color = {.r = 255, .g = 200, .b = 110};
+                break;
+            case LinkState::Unknown:
+                break;
+        }
+    }
 
-    return ListenerResult::Propagate;
+    m_indexNameLabel->setString(text.c_str());
+    m_indexNameLabel->limitLabelWidth(m_songInfoNode->getContentWidth(), 0.4f,
+                                      0.1f);
+    m_indexNameLabel->setColor(color);
+    m_songNameLabel->setOpacity(opacity);
+    m_artistLabel->setOpacity(opacity);
+    m_songInfoNode->updateLayout();
 }
 
 IndexSongCell* IndexSongCell::create(IndexSongMetadata* song, int gdId,
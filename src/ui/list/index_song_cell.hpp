@@ -10,6 +10,8 @@
 #include "Geode/cocos/sprite_nodes/CCSprite.h"
 #include "Geode/loader/Event.hpp"
 
+#include "events/link_probed.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_failed.hpp"
 #include "events/song_download_progress.hpp"
 #include "index.hpp"
@@ -38,19 +40,39 @@ protected:
 
     bool m_downloading = false;
 
-    EventListener<EventFilter<event::SongDownloadProgress>> m_downloadListener;
-    EventListener<EventFilter<event::SongDownloadFailed>>
-        m_downloadFailedListener{this, &IndexSongCell::onDownloadFailed};
+    event::SongSubscription m_downloadListener;
+    event::SongSubscription m_downloadFailedListener;
+    event::SongSubscription m_linkListener;
 
     bool init(IndexSongMetadata* song, int gdId, const CCSize& size);
 
     void onDownload(CCObject*);
-    geode::ListenerResult onDownloadProgress(event::SongDownloadProgress* e);
-    geode::ListenerResult onDownloadFailed(event::SongDownloadFailed* e);
+    void onDownloadProgress(event::SongDownloadProgress* e);
+    void onDownloadFailed(event::SongDownloadFailed* e);
+    /**
+     * Back to the plain download button
+     */
+    void resetDownload();
+    void onLinkProbed(event::LinkProbed* e);
+    /**
+     * Puts the song's size or a dead link warning next to the index name
+     */
+    void updateLinkStatus();
 
 public:
     IndexSongMetadata* song() const { return m_song; }
 
+    /**
+     * Shows another index song in this cell, so a list can reuse cells that
+     * scrolled out instead of building new ones
+     */
+    void rebind(IndexSongMetadata* song, int gdId);
+    /**
+     * Lets go of the song and its events while the cell waits in a pool.
+     * rebind() has to be called before it's shown again.
+     */
+    void unbind();
+
     static IndexSongCell* create(IndexSongMetadata* song, int gdId,
                                  const CCSize& size);
 };
@@ -15,10 +15,15 @@
 #include "Geode/ui/Layout.hpp"
 #include "Geode/ui/Popup.hpp"
 
+#include "events/get_song_info.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_failed.hpp"
+#include "events/song_download_progress.hpp"
 #include "events/song_state_changed.hpp"
+#include "managers/deletion_queue.hpp"
 #include "managers/index_manager.hpp"
 #include "managers/nong_manager.hpp"
+#include "managers/song_pack.hpp"
 #include "nong.hpp"
 
 namespace jukebox {
@@ -35,19 +40,6 @@ bool NongCell::init(int songID, Song* info, bool isDefault, bool selected,
         return false;
     }
 
-    m_songID = songID;
-    m_uniqueID = info->metadata()->uniqueID;
-    m_songInfo = info;
-    m_isDefault = isDefault;
-    m_isActive = selected;
-    m_isDownloaded = m_songInfo->path().has_value() &&
-                     std::filesystem::exists(m_songInfo->path().value());
-    m_isDownloadable = m_songInfo->type() != NongType::LOCAL;
-    m_onSelect = onSelect;
-    m_onDelete = onDelete;
-    m_onDownload = onDownload;
-    m_onEdit = onEdit;
-
     this->setContentSize(size);
     this->setAnchorPoint({0.5f, 0.5f});
 
@@ -63,106 +55,160 @@ bool NongCell::init(int songID, Song* info, bool isDefault, bool selected,
     bg->setContentSize(size / bg->getScale());
     this->addChildAtPosition(bg, Anchor::Center);
 
-    CCMenu* menu = CCMenu::create();
+    // Every button is created once, rebind() only shows the ones the song
+    // needs
+    m_buttonsMenu = CCMenu::create();
 
-    if (m_isDownloaded || m_isDefault) {
-        const char* selectSprName =
-            selected ? "GJ_checkOn_001.png" : "GJ_checkOff_001.png";
-
-        CCSprite* selectSpr =
-            CCSprite::createWithSpriteFrameName(selectSprName);
-        selectSpr->setScale(0.7f);
-
-        m_selectButton = CCMenuItemSpriteExtra::create(
-            selectSpr, this, menu_selector(NongCell::onSet));
-        m_selectButton->setAnchorPoint({0.5f, 0.5f});
-        m_selectButton->setID("set-button");
-        menu->addChild(m_selectButton);
-    }
-
-    menu->setID("buttons-menu");
-    menu->setAnchorPoint({1.0f, 0.5f});
-    menu->setContentSize({buttonsWidth, maxSize.height});
+    CCSprite* selectSpr =
+        CCSprite::createWithSpriteFrameName("GJ_checkOff_001.png");
+    selectSpr->setScale(0.7f);
+    m_selectButton = CCMenuItemSpriteExtra::create(
+        selectSpr, this, menu_selector(NongCell::onSet));
+    m_selectButton->setAnchorPoint({0.5f, 0.5f});
+    m_selectButton->setID("set-button");
+    m_buttonsMenu->addChild(m_selectButton);
+
+    m_buttonsMenu->setAnchorPoint({1.0f, 0.5f});
+    m_buttonsMenu->setContentSize({buttonsWidth, maxSize.height});
     AxisLayout* layout =
         RowLayout::create()->setGap(5.f)->setAxisAlignment(AxisAlignment::End);
     layout->ignoreInvisibleChildren(true);
-    menu->setLayout(layout);
-
-    if (!m_isDefault && !m_songInfo->indexID().has_value()) {
-        CCSprite* spr = CCSprite::createWithSpriteFrameName("JB_Edit.png"_spr);
-        spr->setScale(0.7f);
-        CCMenuItemSpriteExtra* editButton = CCMenuItemSpriteExtra::create(
-            spr, this, menu_selector(NongCell::onEdit));
-        editButton->setID("edit-button");
-        editButton->setAnchorPoint({0.5f, 0.5f});
-        menu->addChild(editButton);
-    }
+    m_buttonsMenu->setLayout(layout);
+
+    CCSprite* editSpr = CCSprite::createWithSpriteFrameName("JB_Edit.png"_spr);
+    editSpr->setScale(0.7f);
+    m_editButton = CCMenuItemSpriteExtra::create(
+        editSpr, this, menu_selector(NongCell::onEdit));
+    m_editButton->setID("edit-button");
+    m_editButton->setAnchorPoint({0.5f, 0.5f});
+    m_buttonsMenu->addChild(m_editButton);
+
+    CCSprite* fixSpr =
+        CCSprite::createWithSpriteFrameName("GJ_downloadsIcon_001.png");
+    fixSpr->setScale(0.8f);
+    m_fixButton = CCMenuItemSpriteExtra::create(
+        fixSpr, this, menu_selector(NongCell::onFixDefault));
+    m_fixButton->setID("fix-button");
+    m_buttonsMenu->addChild(m_fixButton);
 
-    if (isDefault) {
-        CCSprite* sprite =
-            CCSprite::createWithSpriteFrameName("GJ_downloadsIcon_001.png");
-        sprite->setScale(0.8f);
-        if (!selected) {
-            sprite->setColor({0x80, 0x80, 0x80});
-        }
-        m_fixButton = CCMenuItemSpriteExtra::create(
-            sprite, this, menu_selector(NongCell::onFixDefault));
-        m_fixButton->setID("fix-button");
-        menu->addChild(m_fixButton);
-    } else {
-        CCSprite* sprite =
-            CCSprite::createWithSpriteFrameName("GJ_downloadBtn_001.png");
-        sprite->setScale(0.7f);
-        m_downloadButton = CCMenuItemSpriteExtra::create(
-            sprite, this, menu_selector(NongCell::onDownload));
-        m_downloadButton->setID("download-button");
-        m_downloadButton->setVisible(!m_isDownloaded);
-        menu->addChild(m_downloadButton);
-
-        CCSprite* progressBarBack =
-            CCSprite::createWithSpriteFrameName("d_circle_01_001.png");
-        progressBarBack->setColor({50, 50, 50});
-        progressBarBack->setScale(0.62f);
-
-        CCSprite* spr =
-            CCSprite::createWithSpriteFrameName("d_circle_01_001.png");
-        spr->setColor({0, 255, 0});
-
-        m_downloadProgress = CCProgressTimer::create(spr);
-        m_downloadProgress->setType(
-            CCProgressTimerType::kCCProgressTimerTypeRadial);
-        m_downloadProgress->setPercentage(50.f);
-        m_downloadProgress->setID("progress-bar");
-        m_downloadProgress->setScale(0.66f);
-
-        m_downloadProgressContainer = CCMenu::create();
-
-        m_downloadProgressContainer->addChildAtPosition(m_downloadProgress,
-                                                        Anchor::Center);
-        m_downloadProgressContainer->addChildAtPosition(progressBarBack,
-                                                        Anchor::Center);
-
-        m_downloadProgressContainer->setZOrder(-1);
-        m_downloadProgressContainer->setVisible(false);
-
-        m_downloadButton->addChildAtPosition(m_downloadProgressContainer,
-                                             Anchor::Center);
-    }
+    CCSprite* downloadSpr =
+        CCSprite::createWithSpriteFrameName("GJ_downloadBtn_001.png");
+    downloadSpr->setScale(0.7f);
+    m_downloadButton = CCMenuItemSpriteExtra::create(
+        downloadSpr, this, menu_selector(NongCell::onDownload));
+    m_downloadButton->setID("download-button");
+    m_buttonsMenu->addChild(m_downloadButton);
+
+    CCSprite* progressBarBack =
+        CCSprite::createWithSpriteFrameName("d_circle_01_001.png");
+    progressBarBack->setColor({50, 50, 50});
+    progressBarBack->setScale(0.62f);
+
+    CCSprite* spr = CCSprite::createWithSpriteFrameName("d_circle_01_001.png");
+    spr->setColor({0, 255, 0});
+
+    m_downloadProgress = CCProgressTimer::create(spr);
+    m_downloadProgress->setType(
+        CCProgressTimerType::kCCProgressTimerTypeRadial);
+    m_downloadProgress->setID("progress-bar");
+    m_downloadProgress->setScale(0.66f);
+
+    m_downloadProgressContainer = CCMenu::create();
+
+    m_downloadProgressContainer->addChildAtPosition(m_downloadProgress,
+                                                    Anchor::Center);
+    m_downloadProgressContainer->addChildAtPosition(progressBarBack,
+                                                    Anchor::Center);
+
+    m_downloadProgressContainer->setZOrder(-1);
+
+    m_downloadButton->addChildAtPosition(m_downloadProgressContainer,
+                                         Anchor::Center);
+
+    CCSprite* deleteSpr =
+        CCSprite::createWithSpriteFrameName("GJ_trashBtn_001.png");
+    deleteSpr->setScale(0.6475f);
+    m_deleteButton = CCMenuItemSpriteExtra::create(
+        deleteSpr, this, menu_selector(NongCell::onDelete));
+    m_deleteButton->setID("delete-button");
+    m_buttonsMenu->addChild(m_deleteButton);
+
+    m_buttonsMenu->setID("button-menu");
+    this->addChildAtPosition(m_buttonsMenu, Anchor::Right, {-PADDING_X, 0.0f});
+
+    m_metadataLabel = CCLabelBMFont::create("", "bigFont.fnt");
+    m_metadataLabel->setColor({.r = 162, .g = 191, .b = 255});
+    m_metadataLabel->setID("metadata");
+
+    m_songNameLabel = CCLabelBMFont::create("", "bigFont.fnt");
+    m_authorNameLabel = CCLabelBMFont::create("", "goldFont.fnt");
+    m_authorNameLabel->setID("author-name");
+    m_songNameLabel->setID("song-name");
 
-    if (!m_isDefault) {
-        CCSprite* sprite =
-            CCSprite::createWithSpriteFrameName("GJ_trashBtn_001.png");
-        sprite->setScale(0.6475f);
-        CCMenuItemSpriteExtra* deleteButton = CCMenuItemSpriteExtra::create(
-            sprite, this, menu_selector(NongCell::onDelete));
-        deleteButton->setID("delete-button");
-        menu->addChild(deleteButton);
-    }
+    m_songInfoNode = CCNode::create();
+    m_songInfoNode->setID("song-info-node");
+    m_songInfoNode->setAnchorPoint({0.0f, 0.5f});
+    m_songInfoNode->setContentSize({songInfoWidth, maxSize.height});
+
+    m_songInfoNode->addChild(m_songNameLabel);
+    m_songInfoNode->addChild(m_authorNameLabel);
+    m_songInfoNode->addChild(m_metadataLabel);
+    AxisLayout* infoLayout =
+        ColumnLayout::create()
+            ->setAutoScale(false)
+            ->setAxisReverse(true)
+            ->setCrossAxisOverflow(false)
+            ->setAxisAlignment(AxisAlignment::Even)
+            ->setCrossAxisAlignment(AxisAlignment::Start)
+            ->setCrossAxisOverflow(true)
+            ->setCrossAxisLineAlignment(AxisAlignment::Start);
+    // Songs without metadata hide its label
+    infoLayout->ignoreInvisibleChildren(true);
+    m_songInfoNode->setLayout(infoLayout);
 
-    menu->updateLayout();
-    menu->setID("button-menu");
-    this->addChildAtPosition(menu, Anchor::Right, {-PADDING_X, 0.0f});
+    this->addChildAtPosition(m_songInfoNode, Anchor::Left, {PADDING_X, 0.0f});
 
+    this->rebind(songID, info, isDefault, selected, std::move(onSelect),
+                 std::move(onDelete), std::move(onDownload),
+                 std::move(onEdit));
+    return true;
+}
+
+void NongCell::rebind(int songID, Song* info, bool isDefault, bool selected,
+                      std::function<void()> onSelect,
+                      std::function<void()> onDelete,
+                      std::function<void()> onDownload,
+                      std::function<void()> onEdit) {
+    m_songID = songID;
+    m_uniqueID = info->metadata()->uniqueID;
+    m_songInfo = info;
+    m_isDefault = isDefault;
+    m_isActive = selected;
+    m_isDownloaded = m_songInfo->path().has_value() &&
+                     SongPack::get().exists(m_songInfo->path().value()) &&
+                     !DeletionQueue::get().pending(m_songInfo->path().value());
+    m_isDownloadable = m_songInfo->type() != NongType::LOCAL;
+    m_onSelect = std::move(onSelect);
+    m_onDelete = std::move(onDelete);
+    m_onDownload = std::move(onDownload);
+    m_onEdit = std::move(onEdit);
+
+    m_selectButton->setVisible(m_isDownloaded || m_isDefault);
+    m_editButton->setVisible(!m_isDefault &&
+                             !m_songInfo->indexID().has_value());
+    m_fixButton->setVisible(m_isDefault);
+    m_downloadButton->setVisible(!m_isDefault && !m_isDownloaded);
+    m_deleteButton->setVisible(!m_isDefault);
+
+    // Left over from a download of the song this cell showed before
+    m_downloadProgressContainer->setVisible(false);
+    m_downloadProgress->setPercentage(50.f);
+    m_downloadButton->setColor({255, 255, 255});
+
+    this->updateSelected();
+    m_buttonsMenu->updateLayout();
+
+    const float songInfoWidth = m_songInfoNode->getContentWidth();
     SongMetadata* songMetadata = m_songInfo->metadata();
 
     std::vector<std::string> metadataList = {};
@@ -189,59 +235,78 @@ bool NongCell::init(int songID, Song* info, bool isDefault, bool selected,
         metadataList.push_back(m_songInfo->metadata()->level.value());
     }
 
+    m_metadataLabel->setVisible(metadataList.size() > 0);
     if (metadataList.size() > 0) {
-        m_metadataLabel = CCLabelBMFont::create(
-            metadataList.size() >= 1
-                ? std::accumulate(
-                      std::next(metadataList.begin()), metadataList.end(),
-                      metadataList[0],
-                      [](const std::string& a, const std::string& b) {
-                          return a + ": " + b;
-                      })
-                      .c_str()
-                : "",
-            "bigFont.fnt");
+        m_metadataLabel->setString(
+            std::accumulate(std::next(metadataList.begin()),
+                            metadataList.end(), metadataList[0],
+                            [](const std::string& a, const std::string& b) {
+                                return a + ": " + b;
+                            })
+                .c_str());
         m_metadataLabel->limitLabelWidth(songInfoWidth, 0.4f, 0.1f);
-        m_metadataLabel->setColor({.r = 162, .g = 191, .b = 255});
-        m_metadataLabel->setID("metadata");
     }
 
-    m_songNameLabel =
-        CCLabelBMFont::create(songMetadata->name.c_str(), "bigFont.fnt");
+    m_songNameLabel->setString(songMetadata->name.c_str());
     m_songNameLabel->limitLabelWidth(songInfoWidth, 0.7f, 0.1f);
 
-    if (selected) {
-        m_songNameLabel->setColor({188, 254, 206});
-    }
-
-    m_authorNameLabel =
-        CCLabelBMFont::create(songMetadata->artist.c_str(), "goldFont.fnt");
+    m_authorNameLabel->setString(songMetadata->artist.c_str());
     m_authorNameLabel->limitLabelWidth(songInfoWidth, 0.5f, 0.1f);
-    m_authorNameLabel->setID("author-name");
-    m_songNameLabel->setID("song-name");
 
-    m_songInfoNode = CCNode::create();
-    m_songInfoNode->setID("song-info-node");
-    m_songInfoNode->setAnchorPoint({0.0f, 0.5f});
-    m_songInfoNode->setContentSize({songInfoWidth, maxSize.height});
+    m_songInfoNode->updateLayout();
 
-    m_songInfoNode->addChild(m_songNameLabel);
-    m_songInfoNode->addChild(m_authorNameLabel);
-    if (m_metadataLabel != nullptr) {
-        m_songInfoNode->addChild(m_metadataLabel);
+    const event::SongKey key{m_songID, m_uniqueID};
+    m_progressListener =
+        event::SongDispatcher<event::SongDownloadProgress>::get().subscribe(
+            key, [this](auto* e) { this->onDownloadProgress(e); });
+    m_downloadFailedListener =
+        event::SongDispatcher<event::SongDownloadFailed>::get().subscribe(
+            key, [this](auto* e) { this->onDownloadFailed(e); });
+    // Server info is about the default song, custom nongs keep their own
+    if (m_isDefault) {
+        m_songInfoListener =
+            event::SongDispatcher<event::GetSongInfo>::get().subscribe(
+                m_songID, [this](auto* e) { this->onGetSongInfo(e); });
+    } else {
+        m_songInfoListener.reset();
     }
-    m_songInfoNode->setLayout(
-        ColumnLayout::create()
-            ->setAutoScale(false)
-            ->setAxisReverse(true)
-            ->setCrossAxisOverflow(false)
-            ->setAxisAlignment(AxisAlignment::Even)
-            ->setCrossAxisAlignment(AxisAlignment::Start)
-            ->setCrossAxisOverflow(true)
-            ->setCrossAxisLineAlignment(AxisAlignment::Start));
+    m_stateListener =
+        event::SongDispatcher<event::SongStateChanged>::get().subscribe(
+            m_songID, [this](auto* e) { this->onStateChange(e); });
+}
 
-    this->addChildAtPosition(m_songInfoNode, Anchor::Left, {PADDING_X, 0.0f});
-    return true;
+void NongCell::unbind() {
+    m_progressListener.reset();
+    m_songInfoListener.reset();
+    m_downloadFailedListener.reset();
+    m_stateListener.reset();
+    m_songInfo = nullptr;
+    m_onSelect = nullptr;
+    m_onDelete = nullptr;
+    m_onDownload = nullptr;
+    m_onEdit = nullptr;
+}
+
+void NongCell::updateSelected() {
+    CCSprite* fixSpr =
+        CCSprite::createWithSpriteFrameName("GJ_downloadsIcon_001.png");
+    fixSpr->setScale(0.8f);
+    if (!m_isActive) {
+        fixSpr->setColor({0x80, 0x80, 0x80});
+    }
+    m_fixButton->setSprite(fixSpr);
+
+    const char* selectSprName =
+        m_isActive ? "GJ_checkOn_001.png" : "GJ_checkOff_001.png";
+    CCSprite* selectSpr = CCSprite::createWithSpriteFrameName(selectSprName);
+    selectSpr->setScale(0.7f);
+    m_selectButton->setSprite(selectSpr);
+
+    if (m_isActive) {
+        m_songNameLabel->setColor({188, 254, 206});
+    } else {
+        m_songNameLabel->setColor({255, 255, 255});
+    }
 }
 
 void NongCell::onFixDefault(CCObject* target) {
@@ -258,30 +323,31 @@ void NongCell::onFixDefault(CCObject* target) {
         "this <cr>ONLY</c> if it gets renamed by accident!",
         "No", "Yes", [this](FLAlertLayer* alert, bool btn2) {
             if (btn2) {
-                NongManager::get().refetchDefault(m_songID);
+                NongManager::get().refetchDefault(m_songID, [](bool success) {
+                    if (success) {
+                        return;
+                    }
+                    FLAlertLayer::create(
+                        "Error",
+                        "Couldn't refetch song info. The servers didn't "
+                        "respond, try again later.",
+                        "Ok")
+                        ->show();
+                });
             }
         });
 }
 
-ListenerResult NongCell::onDownloadProgress(event::SongDownloadProgress* e) {
-    if (e->uniqueID() != m_uniqueID || e->gdSongID() != m_songID) {
-        return ListenerResult::Propagate;
-    }
-
+void NongCell::onDownloadProgress(event::SongDownloadProgress* e) {
     if (!m_downloadProgressContainer->isVisible()) {
         m_downloadProgressContainer->setVisible(true);
         m_downloadButton->setColor(ccc3(105, 105, 105));
     }
 
     m_downloadProgress->setPercentage(e->progress());
-    return ListenerResult::Propagate;
 }
 
-ListenerResult NongCell::onDownloadFailed(event::SongDownloadFailed* e) {
-    if (e->gdSongId() != m_songID || e->uniqueId() != m_uniqueID) {
-        return ListenerResult::Propagate;
-    }
-
+void NongCell::onDownloadFailed(event::SongDownloadFailed* e) {
     m_downloadProgressContainer->setVisible(false);
     m_downloadProgress->setPercentage(0.0f);
     CCSprite* downloadSpr =
@@ -289,60 +355,27 @@ ListenerResult NongCell::onDownloadFailed(event::SongDownloadFailed* e) {
     downloadSpr->setScale(0.7f);
     m_downloadButton->setSprite(downloadSpr);
     m_downloadButton->setColor({255, 255, 255});
-
-    return ListenerResult::Propagate;
 }
 
-ListenerResult NongCell::onStateChange(event::SongStateChanged* e) {
+void NongCell::onStateChange(event::SongStateChanged* e) {
     bool sameIDAsActive =
         e->nongs()->active()->metadata()->uniqueID == m_uniqueID;
     bool switchedToActive = !m_isActive && sameIDAsActive;
     bool switchedToInactive = m_isActive && !sameIDAsActive;
 
-    if (e->nongs()->songID() != m_songID || (!m_isDownloaded && !m_isDefault)) {
-        return ListenerResult::Propagate;
+    if (!m_isDownloaded && !m_isDefault) {
+        return;
     }
 
     if (!switchedToActive && !switchedToInactive) {
-        return ListenerResult::Propagate;
-    }
-
-    bool selected = e->nongs()->active()->metadata()->uniqueID == m_uniqueID;
-    m_isActive = selected;
-
-    if (m_isDefault && m_fixButton) {
-        CCSprite* sprite =
-            CCSprite::createWithSpriteFrameName("GJ_downloadsIcon_001.png");
-        sprite->setScale(0.8f);
-        if (!selected) {
-            sprite->setColor({0x80, 0x80, 0x80});
-        }
-
-        m_fixButton->setSprite(sprite);
-    }
-
-    const char* selectSprName =
-        selected ? "GJ_checkOn_001.png" : "GJ_checkOff_001.png";
-
-    CCSprite* selectSpr = CCSprite::createWithSpriteFrameName(selectSprName);
-    selectSpr->setScale(0.7f);
-
-    if (selected) {
-        m_songNameLabel->setColor({188, 254, 206});
-    } else {
-        m_songNameLabel->setColor({255, 255, 255});
+        return;
     }
 
-    m_selectButton->setSprite(selectSpr);
-
-    return ListenerResult::Propagate;
+    m_isActive = sameIDAsActive;
+    this->updateSelected();
 }
 
-ListenerResult NongCell::onGetSongInfo(event::GetSongInfo* e) {
-    if (e->gdSongID() != m_songID) {
-        return ListenerResult::Propagate;
-    }
-
+void NongCell::onGetSongInfo(event::GetSongInfo* e) {
     const CCSize maxSize = {this->getContentSize().width - 2 * PADDING_X,
                             this->getContentSize().height - 2 * PADDING_Y};
     const float songInfoWidth = maxSize.width * (2.0f / 3.0f);
@@ -353,8 +386,6 @@ ListenerResult NongCell::onGetSongInfo(event::GetSongInfo* e) {
     m_authorNameLabel->limitLabelWidth(songInfoWidth, 0.5f, 0.1f);
 
     m_songInfoNode->updateLayout();
-
-    return ListenerResult::Propagate;
 }
 
 void NongCell::onSet(CCObject* target) { m_onSelect(); }
@@ -374,6 +405,7 @@ NongCell* NongCell::create(int songID, Song* song, bool isDefault,
     auto ret = new NongCell();
     if (ret && ret->init(songID, song, isDefault, selected, size, onSelect,
                          onDelete, onDownload, onEdit)) {
+        ret->autorelease();
         return ret;
     }
     CC_SAFE_DELETE(ret);
@@ -5,8 +5,8 @@
 #include "Geode/cocos/base_nodes/CCNode.h"
 #include "Geode/cocos/cocoa/CCObject.h"
 
-#include "Geode/loader/Event.hpp"
 #include "events/get_song_info.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_failed.hpp"
 #include "events/song_download_progress.hpp"
 #include "events/song_state_changed.hpp"
@@ -38,30 +38,33 @@ protected:
     bool m_isDownloaded;
     bool m_isDownloadable;
 
+    CCMenu* m_buttonsMenu = nullptr;
     CCMenuItemSpriteExtra* m_fixButton = nullptr;
     CCMenuItemSpriteExtra* m_downloadButton = nullptr;
     CCMenuItemSpriteExtra* m_selectButton = nullptr;
+    CCMenuItemSpriteExtra* m_editButton = nullptr;
+    CCMenuItemSpriteExtra* m_deleteButton = nullptr;
     CCMenu* m_downloadProgressContainer = nullptr;
     CCProgressTimer* m_downloadProgress = nullptr;
 
-    EventListener<EventFilter<event::SongDownloadProgress>> m_progressListener{
-        this, &NongCell::onDownloadProgress};
-    EventListener<EventFilter<event::GetSongInfo>> m_songInfoListener{
-        this, &NongCell::onGetSongInfo};
-    EventListener<EventFilter<event::SongDownloadFailed>>
-        m_downloadFailedListener{this, &NongCell::onDownloadFailed};
-    EventListener<EventFilter<event::SongStateChanged>> m_stateListener{
-        this, &NongCell::onStateChange};
+    event::SongSubscription m_progressListener;
+    event::SongSubscription m_songInfoListener;
+    event::SongSubscription m_downloadFailedListener;
+    event::SongSubscription m_stateListener;
 
     bool init(int songID, Song*, bool isDefault, bool selected,
               CCSize const& size, std::function<void()> onSelect,
               std::function<void()> onDelete, std::function<void()> onDownload,
               std::function<void()> onEdit);
 
-    ListenerResult onDownloadProgress(event::SongDownloadProgress* e);
-    ListenerResult onGetSongInfo(event::GetSongInfo* e);
-    ListenerResult onDownloadFailed(event::SongDownloadFailed* e);
-    ListenerResult onStateChange(event::SongStateChanged* e);
+    /**
+     * Shows whether the song is active on the buttons and the name
+     */
+    void updateSelected();
+    void onDownloadProgress(event::SongDownloadProgress* e);
+    void onGetSongInfo(event::GetSongInfo* e);
+    void onDownloadFailed(event::SongDownloadFailed* e);
+    void onStateChange(event::SongStateChanged* e);
 
 public:
     Song* m_songInfo = nullptr;
@@ -72,6 +75,19 @@ public:
                             std::function<void()> onDownload,
                             std::function<void()> onEdit);
 
+    /**
+     * Shows another song in this cell, so a list can reuse cells that
+     * scrolled out instead of building new ones. The size stays the same.
+     */
+    void rebind(int songID, Song* song, bool isDefault, bool selected,
+                std::function<void()> onSelect, std::function<void()> onDelete,
+                std::function<void()> onDownload, std::function<void()> onEdit);
+    /**
+     * Lets go of the song and its events while the cell waits in a pool.
+     * rebind() has to be called before it's shown again.
+     */
+    void unbind();
+
     void onSet(CCObject*);
     void onDelete(CCObject*);
     void onFixDefault(CCObject*);
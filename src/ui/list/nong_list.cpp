@@ -1,12 +1,15 @@
 #include "ui/list/nong_list.hpp"
 #include <fmt/core.h>
 
-#include <filesystem>
+#include <algorithm>
 #include <memory>
 #include <optional>
-#include <unordered_set>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "GUI/CCControlExtension/CCScale9Sprite.h"
+#include "Geode/binding/FLAlertLayer.hpp"
 #include "Geode/cocos/base_nodes/CCNode.h"
 #include "Geode/cocos/cocoa/CCObject.h"
 #include "Geode/cocos/label_nodes/CCLabelBMFont.h"
@@ -21,10 +24,13 @@
 #include "events/nong_deleted.hpp"
 #include "events/song_download_finished.hpp"
 #include "index.hpp"
+#include "managers/latency_recorder.hpp"
+#include "managers/link_prober.hpp"
 #include "managers/nong_manager.hpp"
 #include "nong.hpp"
 #include "ui/list/index_song_cell.hpp"
 #include "ui/list/nong_cell.hpp"
+#include "ui/list/nong_list_model.hpp"
 #include "ui/list/song_cell.hpp"
 
 using namespace geode::prelude;
@@ -76,202 +82,439 @@ bool NongList::init(
     menu->setZOrder(1);
     this->addChildAtPosition(menu, Anchor::Left, CCPoint{-10.0f, 0.0f});
 
+    // No layout, cells are positioned from the model as they scroll in
     m_list =
         ScrollLayer::create({size.width - s_padding, size.height - s_padding});
-    m_list->m_contentLayer->setLayout(ColumnLayout::create()
-                                          ->setAxisReverse(true)
-                                          ->setAxisAlignment(AxisAlignment::End)
-                                          ->setAutoGrowAxis(size.height)
-                                          ->setGap(s_padding / 2));
 
     this->addChildAtPosition(m_list, Anchor::Center,
                              -m_list->getScaledContentSize() / 2);
 
     m_onListTypeChange(m_currentSong);
 
+    for (int id : m_songIds) {
+        m_songListeners.push_back(
+            event::SongDispatcher<event::SongDownloadFinished>::get().subscribe(
+                id, [this](auto* e) { this->onDownloadFinish(e); }));
+        m_songListeners.push_back(
+            event::SongDispatcher<event::NongDeleted>::get().subscribe(
+                id, [this](auto* e) { this->onNongDeleted(e); }));
+        m_songListeners.push_back(
+            event::SongDispatcher<event::SongStateChanged>::get().subscribe(
+                id, [this](auto* e) { this->onStateChange(e); }));
+    }
+
     this->build();
+    this->scheduleUpdate();
     return true;
 }
 
 void NongList::setDownloadProgress(std::string uniqueID, float progress) {}
 
-void NongList::build() {
-    if (m_list->m_contentLayer->getChildrenCount() > 0) {
-        m_list->m_contentLayer->removeAllChildrenWithCleanup(true);
-    }
+void NongList::build() { this->refresh(false); }
 
-    if (m_songIds.size() == 0) {
-        return;
-    }
-
-    CCSize itemSize = {m_list->getScaledContentSize().width, s_itemSize};
+void NongList::refresh(bool keepScroll) {
+    LatencyRecorder::Scope latency("list.rebuild");
+    this->clearCells();
+    m_model.clear();
 
     if (m_onListTypeChange) {
         m_onListTypeChange(m_currentSong);
     }
 
     if (!m_currentSong) {
-        for (int id : m_songIds) {
-            std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+        m_model.buildSongs(m_songIds);
+    } else if (std::optional<Nongs*> nongs =
+                   NongManager::get().getNongs(m_currentSong.value())) {
+        m_model.buildNongs(nongs.value());
+    }
 
-            if (!nongs) {
-                continue;
-            }
+    this->resizeContent(keepScroll);
+    this->updateVisibleCells(true);
+}
+
+void NongList::resizeContent(bool keepScroll) {
+    // Distance from the top, so the same rows stay in view
+    const float fromTop = m_list->m_contentLayer->getContentHeight() +
+                          m_list->m_contentLayer->getPositionY() -
+                          m_list->getContentHeight();
+
+    const float viewHeight = m_list->getContentHeight();
+    const float height = std::max(m_model.height(), viewHeight);
+    m_list->m_contentLayer->setContentSize({m_list->getContentWidth(), height});
 
-            Song* active = nongs.value()->active();
+    if (keepScroll) {
+        m_list->m_contentLayer->setPositionY(
+            -height + viewHeight +
+            std::clamp(fromTop, 0.f, height - viewHeight));
+    } else {
+        this->scrollToTop();
+    }
+}
 
-            m_list->m_contentLayer->addChild(
-                SongCell::create(id, active->metadata(), itemSize,
-                                 [this, id]() { this->onSelectSong(id); }));
+void NongList::applyUpdate(const std::vector<std::string>& forceUpdate) {
+    LatencyRecorder::Scope latency("list.update");
+    std::vector<NongListModel::Change> changes;
+    if (!m_currentSong) {
+        changes = m_model.updateSongs(m_songIds);
+    } else if (std::optional<Nongs*> nongs =
+                   NongManager::get().getNongs(m_currentSong.value())) {
+        changes = m_model.updateNongs(nongs.value(), forceUpdate);
+    } else {
+        this->refresh(true);
+        return;
+    }
+
+    if (changes.empty()) {
+        return;
+    }
+
+    bool resized = false;
+    for (const NongListModel::Change& change : changes) {
+        switch (change.type) {
+            case NongListModel::Change::Type::Remove:
+                this->dropCell(change.key);
+                resized = true;
+                break;
+            case NongListModel::Change::Type::Update:
+                this->dropCell(change.key);
+                break;
+            case NongListModel::Change::Type::Insert:
+                resized = true;
+                break;
+            // Position comes from the model, nothing to do here
+            case NongListModel::Change::Type::Move:
+                break;
         }
+    }
+
+    if (resized) {
+        this->resizeContent(true);
+    }
+
+    this->updateVisibleCells(true);
+}
+
+void NongList::dropCell(const std::string& key) {
+    auto it = m_cells.find(key);
+    if (it == m_cells.end()) {
+        return;
+    }
+    if (m_placeholders.erase(key) > 0) {
+        m_buildQueue.cancel(key);
+        it->second->removeFromParentAndCleanup(true);
     } else {
-        // Single item
-        int id = m_currentSong.value();
+        this->recycle(it->second);
+    }
+    m_cells.erase(it);
+}
 
-        std::optional<Nongs*> optNongs = NongManager::get().getNongs(id);
-        if (!optNongs) {
-            return;
+void NongList::clearCells() {
+    // The pools outlive a rebuild, the next song's cells come from there
+    for (auto& [key, cell] : m_cells) {
+        if (m_placeholders.contains(key)) {
+            cell->removeFromParentAndCleanup(true);
+        } else {
+            this->recycle(cell);
         }
+    }
+    m_cells.clear();
+    m_buildQueue.clear();
+    m_placeholders.clear();
+    m_visible = {0, 0};
+}
+
+void NongList::update(float dt) {
+    if (m_list->m_contentLayer->getPositionY() != m_lastScrollY) {
+        this->updateVisibleCells();
+    }
+
+    if (!m_buildQueue.empty()) {
+        m_buildQueue.run(s_frameBudget);
+    }
 
-        Nongs* nongs = optNongs.value();
-        LocalSong* defaultSong = nongs->defaultSong();
-        std::string defaultID = defaultSong->metadata()->uniqueID;
-        Song* active = nongs->active();
-
-        m_list->m_contentLayer->addChild(NongCell::create(
-            id, defaultSong, true,
-            defaultSong->metadata()->uniqueID == active->metadata()->uniqueID,
-            itemSize, [this, id, defaultID]() { m_onSetActive(id, defaultID); },
-            [this, id, defaultID]() { m_onDelete(id, defaultID, true, true); },
-            [this, id, defaultID]() { m_onDownload(id, defaultID); },
-            [this, id, defaultID]() { m_onEdit(id, defaultID); }));
-
-        CCLabelBMFont* localSongs =
-            CCLabelBMFont::create("Stored nongs", "goldFont.fnt");
-        localSongs->setID("local-section");
-        localSongs->setLayoutOptions(
-            AxisLayoutOptions::create()->setScaleLimits(0.2f, 0.6f));
-        m_list->m_contentLayer->addChild(localSongs);
-
-        std::unordered_set<std::string> localYt;
-        std::unordered_set<std::string> localHosted;
-
-        if (nongs->locals().size() == 0 && nongs->youtube().size() == 0 &&
-            nongs->hosted().size() == 0) {
-            this->addNoLocalSongsNotice();
+    if (m_needsTouchPriority) {
+        this->updateTouchPriority();
+    }
+}
+
+void NongList::onEnter() {
+    CCNode::onEnter();
+    // Requeue whatever was cancelled in onExit
+    if (m_model.size() > 0) {
+        this->updateVisibleCells(true);
+    }
+}
+
+void NongList::onExit() {
+    CCNode::onExit();
+    // Nothing gets built for a closed popup
+    m_buildQueue.clear();
+    for (const std::string& key : m_placeholders) {
+        if (auto it = m_cells.find(key); it != m_cells.end()) {
+            it->second->removeFromParentAndCleanup(true);
+            m_cells.erase(it);
         }
+    }
+    m_placeholders.clear();
+}
 
-        for (std::unique_ptr<LocalSong>& nong : nongs->locals()) {
-            this->addSongToList(nong.get(), nongs);
+void NongList::updateVisibleCells(bool force) {
+    const float scrollY = m_list->m_contentLayer->getPositionY();
+    m_lastScrollY = scrollY;
+
+    const float height = m_list->m_contentLayer->getContentHeight();
+    const float viewHeight = m_list->getContentHeight();
+    // Keep half a screen of cells around the viewport so scrolling doesn't
+    // create them right at the edge
+    const float margin = viewHeight / 2;
+    const float top = height + scrollY - viewHeight;
+    const float bottom = height + scrollY;
+
+    std::pair<size_t, size_t> visible =
+        m_model.range(top - margin, bottom + margin);
+    if (!force && visible == m_visible) {
+        return;
+    }
+    m_visible = visible;
+
+    // Index songs in view get their links checked ahead of the background
+    // probes, the rest once they scroll in
+    std::vector<index::IndexSongMetadata*> indexSongs;
+    for (size_t i = visible.first; i < visible.second; i++) {
+        if (index::IndexSongMetadata* song = m_model.at(i).indexSong) {
+            indexSongs.push_back(song);
         }
+    }
+    if (!indexSongs.empty()) {
+        LinkProber::get().probe(indexSongs, true);
+    }
 
-        for (std::unique_ptr<YTSong>& nong : nongs->youtube()) {
-            this->addSongToList(nong.get(), nongs);
-            if (nong->indexID().has_value()) {
-                localYt.insert(fmt::format("{}|{}", nong->indexID().value(),
-                                           nong->metadata()->uniqueID));
-            }
+    // Items actually on screen get built first, then the margin outwards
+    const std::pair<size_t, size_t> onScreen = m_model.range(top, bottom);
+    auto priority = [&onScreen, this](size_t i) -> int {
+        if (i >= onScreen.first && i < onScreen.second) {
+            return static_cast<int>(i - onScreen.first);
+        }
+        const size_t distance = i < onScreen.first
+                                    ? onScreen.first - i
+                                    : i - onScreen.second + 1;
+        return static_cast<int>(m_model.size() + distance);
+    };
+
+    std::unordered_map<std::string, Ref<CCNode>> cells;
+
+    for (size_t i = visible.first; i < visible.second; i++) {
+        const NongListModel::Item& item = m_model.at(i);
+
+        Ref<CCNode> cell = nullptr;
+        if (auto it = m_cells.find(item.key); it != m_cells.end()) {
+            cell = it->second;
+            m_cells.erase(it);
+        } else if (this->hasPooledCell(item)) {
+            // Rebinding is cheap enough to skip the build queue
+            cell = this->createCell(item);
+            cell->setID(item.key);
+            m_list->m_contentLayer->addChild(cell);
+        } else {
+            cell = this->createPlaceholder(item);
+            cell->setID(item.key);
+            m_list->m_contentLayer->addChild(cell);
+            m_placeholders.insert(item.key);
         }
 
-        for (std::unique_ptr<HostedSong>& nong : nongs->hosted()) {
-            this->addSongToList(nong.get(), nongs);
-            if (nong->indexID().has_value()) {
-                localHosted.insert(fmt::format("{}|{}", nong->indexID().value(),
-                                               nong->metadata()->uniqueID));
-            }
+        cell->setPosition(
+            {m_list->getContentWidth() / 2,
+             height - m_model.offset(i) - item.height / 2});
+        cells.emplace(item.key, cell);
+
+        if (!m_placeholders.contains(item.key)) {
+            continue;
+        }
+        if (m_buildQueue.contains(item.key)) {
+            m_buildQueue.reprioritize(item.key, priority(i));
+        } else {
+            const std::string key = item.key;
+            m_buildQueue.push(key, priority(i),
+                              [this, key]() { this->buildCell(key); });
         }
+    }
 
-        if (nongs->indexSongs().size() > 0) {
-            CCLabelBMFont* indexLabel =
-                CCLabelBMFont::create("Download nongs", "goldFont.fnt");
-            indexLabel->setID("index-section");
-            indexLabel->setLayoutOptions(
-                AxisLayoutOptions::create()->setScaleLimits(0.2f, 0.6f));
-            m_list->m_contentLayer->addChild(indexLabel);
+    // Whatever is left scrolled out of view
+    for (auto& [key, cell] : m_cells) {
+        if (m_placeholders.erase(key) > 0) {
+            m_buildQueue.cancel(key);
+            cell->removeFromParentAndCleanup(true);
+            continue;
         }
+        this->recycle(cell);
+    }
+    m_cells = std::move(cells);
+}
 
-        for (index::IndexSongMetadata* index : nongs->indexSongs()) {
-            const std::string id =
-                fmt::format("{}|{}", index->parentID->m_id, index->uniqueID);
+void NongList::buildCell(const std::string& key) {
+    auto it = m_cells.find(key);
+    std::optional<size_t> index = m_model.find(key);
+    if (it == m_cells.end() || !index.has_value()) {
+        return;
+    }
 
-            if (index->ytId.has_value() && localYt.contains(id)) {
-                continue;
-            }
+    Ref<CCNode> cell = this->createCell(m_model.at(index.value()));
+    if (!cell) {
+        // Leave the placeholder, the next update will retry
+        return;
+    }
 
-            if (index->url.has_value() && localHosted.contains(id)) {
-                continue;
-            }
+    cell->setID(key);
+    cell->setPosition(it->second->getPosition());
+    it->second->removeFromParentAndCleanup(true);
+    it->second = cell;
+    m_placeholders.erase(key);
+    m_list->m_contentLayer->addChild(cell);
+    m_needsTouchPriority = true;
+}
 
-            this->addIndexSongToList(index, nongs);
-        }
+void NongList::dropPlaceholder(const std::string& key) {
+    if (m_placeholders.erase(key) > 0) {
+        m_buildQueue.cancel(key);
     }
-    m_list->m_contentLayer->updateLayout();
-    this->scrollToTop();
 }
 
-void NongList::addSongToList(Song* nong, Nongs* parent, bool liveInsert) {
-    int id = m_currentSong.value();
-    Song* defaultSong = parent->defaultSong();
-    Song* active = parent->active();
-
-    CCSize itemSize = {m_list->getScaledContentSize().width, s_itemSize};
-
-    std::string uniqueID = nong->metadata()->uniqueID;
-    std::optional<std::filesystem::path> path = nong->path();
-    bool isFromIndex = nong->indexID().has_value();
-    bool isDownloaded =
-        path.has_value() && std::filesystem::exists(path.value());
-    NongCell* cell = NongCell::create(
-        id, nong, uniqueID == defaultSong->metadata()->uniqueID,
-        uniqueID == active->metadata()->uniqueID, itemSize,
-        [this, id, uniqueID]() { m_onSetActive(id, uniqueID); },
-        [this, id, uniqueID]() { m_onDelete(id, uniqueID, false, true); },
-        [this, id, uniqueID]() { m_onDownload(id, uniqueID); },
-        [this, id, uniqueID]() { m_onEdit(id, uniqueID); });
-    cell->setID(uniqueID);
-
-    if (!liveInsert) {
-        m_list->m_contentLayer->addChild(cell);
-        return;
+void NongList::updateTouchPriority() {
+    // New menus need the popup's touch priority
+    for (CCNode* node = this->getParent(); node; node = node->getParent()) {
+        if (typeinfo_cast<FLAlertLayer*>(node)) {
+            handleTouchPriority(node);
+            m_needsTouchPriority = false;
+            return;
+        }
     }
+}
 
-    CCNode* indexSection =
-        m_list->m_contentLayer->getChildByID("index-section");
+void NongList::recycle(CCNode* cell) {
+    // Still referenced by the caller, removing it doesn't free it
+    cell->removeFromParentAndCleanup(false);
+    // Unbound even when the pool is full, the caller may still hold it
+    if (auto nongCell = typeinfo_cast<NongCell*>(cell)) {
+        nongCell->unbind();
+        if (m_nongCellPool.size() < s_maxPooled) {
+            m_nongCellPool.push_back(nongCell);
+        }
+    } else if (auto indexCell = typeinfo_cast<IndexSongCell*>(cell)) {
+        indexCell->unbind();
+        if (m_indexCellPool.size() < s_maxPooled) {
+            m_indexCellPool.push_back(indexCell);
+        }
+    }
+}
 
-    if (indexSection) {
-        m_list->m_contentLayer->insertBefore(cell, indexSection);
-    } else {
-        m_list->m_contentLayer->addChild(cell);
+bool NongList::hasPooledCell(const NongListModel::Item& item) const {
+    // Cells are laid out for their size once, only reused at that size
+    const CCSize itemSize = {m_list->getContentWidth(), item.height};
+    switch (item.type) {
+        case NongListModel::ItemType::Song:
+            return !m_nongCellPool.empty() &&
+                   m_nongCellPool.back()->getContentSize().equals(itemSize);
+        case NongListModel::ItemType::IndexSong:
+            return !m_indexCellPool.empty() &&
+                   m_indexCellPool.back()->getContentSize().equals(itemSize);
+        default:
+            return false;
     }
 }
 
-void NongList::addIndexSongToList(index::IndexSongMetadata* song,
-                                  Nongs* parent) {
-    const CCSize itemSize = {m_list->getScaledContentSize().width, s_itemSize};
-    IndexSongCell* cell =
-        IndexSongCell::create(song, m_currentSong.value(), itemSize);
-    cell->setID(fmt::format("{}-{}", song->parentID->m_id, song->uniqueID));
-    m_list->m_contentLayer->addChild(cell);
+CCNode* NongList::createPlaceholder(const NongListModel::Item& item) {
+    CCNode* node = CCNode::create();
+    node->setContentSize({m_list->getContentWidth(), item.height});
+    node->setAnchorPoint({0.5f, 0.5f});
+
+    switch (item.type) {
+        case NongListModel::ItemType::SongSummary:
+        case NongListModel::ItemType::Song:
+        case NongListModel::ItemType::IndexSong: {
+            // Same background as the cells, so only the contents pop in
+            CCScale9Sprite* bg = CCScale9Sprite::create("square02b_001.png");
+            bg->setColor({0, 0, 0});
+            bg->setOpacity(75);
+            bg->setScale(0.3f);
+            bg->setContentSize(node->getContentSize() / bg->getScale());
+            node->addChildAtPosition(bg, Anchor::Center);
+            break;
+        }
+        case NongListModel::ItemType::Section:
+        case NongListModel::ItemType::NoLocalSongs:
+            break;
+    }
+
+    return node;
 }
 
-void NongList::addNoLocalSongsNotice(bool liveInsert) {
-    CCLabelBMFont* label =
-        CCLabelBMFont::create("You have no stored nongs :(", "bigFont.fnt");
-    label->setID("no-local-songs");
-    label->setLayoutOptions(AxisLayoutOptions::create()->setAutoScale(false));
-    label->limitLabelWidth(150.0f, 0.7f, 0.1f);
+Ref<CCNode> NongList::createCell(const NongListModel::Item& item) {
+    const CCSize itemSize = {m_list->getContentWidth(), item.height};
+    const int id = item.songID;
 
-    if (!liveInsert) {
-        m_list->m_contentLayer->addChild(label);
-    } else {
-        CCNode* section = m_list->m_contentLayer->getChildByID("local-section");
-        if (!section) {
-            log::error(
-                "Couldn't insert no local songs notice. Section not found");
-        } else {
-            m_list->m_contentLayer->insertAfter(label, section);
+    switch (item.type) {
+        case NongListModel::ItemType::SongSummary: {
+            std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+            if (!nongs) {
+                return nullptr;
+            }
+            return SongCell::create(
+                id, nongs.value()->active()->metadata(), itemSize,
+                [this, id]() { this->onSelectSong(id); });
+        }
+        case NongListModel::ItemType::Section: {
+            CCLabelBMFont* label =
+                CCLabelBMFont::create(item.title.c_str(), "goldFont.fnt");
+            label->limitLabelWidth(itemSize.width, 0.6f, 0.2f);
+            return label;
+        }
+        case NongListModel::ItemType::NoLocalSongs: {
+            CCLabelBMFont* label = CCLabelBMFont::create(
+                "You have no stored nongs :(", "bigFont.fnt");
+            label->limitLabelWidth(150.0f, 0.7f, 0.1f);
+            return label;
+        }
+        case NongListModel::ItemType::Song: {
+            const std::string uniqueID = item.key;
+            const bool onlyAudio = item.isDefault;
+            auto onSelect = [this, id, uniqueID]() {
+                m_onSetActive(id, uniqueID);
+            };
+            auto onDelete = [this, id, uniqueID, onlyAudio]() {
+                m_onDelete(id, uniqueID, onlyAudio, true);
+            };
+            auto onDownload = [this, id, uniqueID]() {
+                m_onDownload(id, uniqueID);
+            };
+            auto onEdit = [this, id, uniqueID]() { m_onEdit(id, uniqueID); };
+
+            if (this->hasPooledCell(item)) {
+                Ref<NongCell> cell = m_nongCellPool.back();
+                m_nongCellPool.pop_back();
+                cell->rebind(id, item.song, item.isDefault, item.isActive,
+                             onSelect, onDelete, onDownload, onEdit);
+                return cell.data();
+            }
+            NongCell* cell = NongCell::create(
+                id, item.song, item.isDefault, item.isActive, itemSize,
+                onSelect, onDelete, onDownload, onEdit);
+            cell->setAnchorPoint({0.5f, 0.5f});
+            return cell;
+        }
+        case NongListModel::ItemType::IndexSong: {
+            if (this->hasPooledCell(item)) {
+                Ref<IndexSongCell> cell = m_indexCellPool.back();
+                m_indexCellPool.pop_back();
+                cell->rebind(item.indexSong, id);
+                return cell.data();
+            }
+            IndexSongCell* cell =
+                IndexSongCell::create(item.indexSong, id, itemSize);
+            cell->setAnchorPoint({0.5f, 0.5f});
+            return cell;
         }
     }
+    return nullptr;
 }
 
 void NongList::scrollToTop() {
@@ -311,83 +554,46 @@ void NongList::onSelectSong(int songId) {
     m_backBtn->setVisible(true);
 }
 
-ListenerResult NongList::onDownloadFinish(event::SongDownloadFinished* e) {
+void NongList::onDownloadFinish(event::SongDownloadFinished* e) {
     if (!m_list || !m_currentSong.has_value() ||
-        !e->indexSource().has_value()) {
-        return ListenerResult::Propagate;
+        !e->indexSource().has_value() ||
+        m_currentSong.value() != e->songKey().songID) {
+        return;
     }
 
-    std::optional<Nongs*> optNongs =
-        NongManager::get().getNongs(m_currentSong.value());
+    // The song may have been stored before, but its file is new
+    this->applyUpdate({e->songKey().uniqueID});
+}
 
-    if (!optNongs.has_value()) {
+ListenerResult NongList::onBatchCommitted(event::BatchCommitted* e) {
+    if (!m_list) {
         return ListenerResult::Propagate;
     }
 
-    Nongs* nongs = optNongs.value();
-
-    if (!nongs->findSong(e->destination()->metadata()->uniqueID)) {
+    if (m_currentSong.has_value()) {
+        if (e->contains(m_currentSong.value())) {
+            this->applyUpdate();
+        }
         return ListenerResult::Propagate;
     }
 
-    index::IndexSongMetadata* meta = e->indexSource().value();
-    if (CCNode* i = m_list->m_contentLayer->getChildByID(
-            fmt::format("{}-{}", meta->parentID->m_id, meta->uniqueID))) {
-        i->removeFromParentAndCleanup(true);
-    }
-
-    this->addSongToList(e->destination(), nongs, true);
-
-    // Remove "you have no local songs label"
-    if (auto node = m_list->m_contentLayer->getChildByID("no-local-songs")) {
-        node->removeFromParentAndCleanup(true);
+    for (int id : m_songIds) {
+        if (e->contains(id)) {
+            this->applyUpdate();
+            break;
+        }
     }
 
-    m_list->m_contentLayer->updateLayout();
-
     return ListenerResult::Propagate;
 }
 
-ListenerResult NongList::onNongDeleted(event::NongDeleted* e) {
+void NongList::onNongDeleted(event::NongDeleted* e) {
     if (!m_list || !m_currentSong.has_value() ||
         m_currentSong.value() != e->gdId()) {
-        return ListenerResult::Propagate;
-    }
-
-    CCNode* found = m_list->m_contentLayer->getChildByID(e->uniqueId());
-    if (found) {
-        found->removeFromParentAndCleanup(true);
-        m_list->m_contentLayer->updateLayout();
-    }
-
-    std::optional<Nongs*> optNongs =
-        NongManager::get().getNongs(m_currentSong.value());
-
-    if (!optNongs.has_value()) {
-        return ListenerResult::Propagate;
-    }
-
-    Nongs* nongs = optNongs.value();
-
-    for (index::IndexSongMetadata* i : nongs->indexSongs()) {
-        if (i->uniqueID != e->uniqueId()) {
-            continue;
-        }
-
-        if (!m_list->m_contentLayer->getChildByID("index-section")) {
-            CCLabelBMFont* indexLabel =
-                CCLabelBMFont::create("Download nongs", "goldFont.fnt");
-            indexLabel->setID("index-section");
-            indexLabel->setLayoutOptions(
-                AxisLayoutOptions::create()->setScaleLimits(0.2f, 0.6f));
-            m_list->m_contentLayer->addChild(indexLabel);
-        }
-
-        this->addIndexSongToList(i, nongs);
-        m_list->m_contentLayer->updateLayout();
+        return;
     }
 
-    return ListenerResult::Propagate;
+    this->applyUpdate();
 }
 
 ListenerResult NongList::onSongAdded(event::ManualSongAdded* e) {
@@ -396,15 +602,20 @@ ListenerResult NongList::onSongAdded(event::ManualSongAdded* e) {
         return ListenerResult::Propagate;
     }
 
-    this->addSongToList(e->song(), e->nongs(), true);
+    this->applyUpdate();
+    return ListenerResult::Propagate;
+}
 
-    // Remove "you have no local songs label"
-    if (auto node = m_list->m_contentLayer->getChildByID("no-local-songs")) {
-        node->removeFromParentAndCleanup(true);
+void NongList::onStateChange(event::SongStateChanged* e) {
+    if (!m_list) {
+        return;
     }
 
-    m_list->m_contentLayer->updateLayout();
-    return ListenerResult::Propagate;
+    // In the multi view any listed ID matters, the subscriptions cover that
+    if (!m_currentSong.has_value() ||
+        m_currentSong.value() == e->nongs()->songID()) {
+        this->applyUpdate();
+    }
 }
 
 NongList* NongList::create(
@@ -1,6 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <GUI/CCControlExtension/CCScale9Sprite.h>
 #include "Geode/binding/CCMenuItemSpriteExtra.hpp"
@@ -10,12 +16,17 @@
 #include "Geode/loader/Event.hpp"
 #include "Geode/ui/ScrollLayer.hpp"
 
+#include "batch_committed.hpp"
 #include "events/manual_song_added.hpp"
 #include "events/nong_deleted.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_finished.hpp"
+#include "events/song_state_changed.hpp"
 #include "nong.hpp"
+#include "ui/list/build_queue.hpp"
 #include "ui/list/index_song_cell.hpp"
 #include "ui/list/nong_cell.hpp"
+#include "ui/list/nong_list_model.hpp"
 
 namespace jukebox {
 
@@ -38,24 +49,72 @@ protected:
     std::function<void(int, const std::string&)> m_onEdit;
     std::function<void(std::optional<int>)> m_onListTypeChange;
 
-    std::vector<NongCell*> listedNongCells;
+    NongListModel m_model{NongListModel::Metrics{s_itemSize, s_labelSize,
+                                                 s_padding / 2}};
+    // Cells currently in the content layer, by item key
+    std::unordered_map<std::string, geode::Ref<cocos2d::CCNode>> m_cells;
+    // Cells that scrolled out, rebound to the next item of their type
+    std::vector<geode::Ref<NongCell>> m_nongCellPool;
+    std::vector<geode::Ref<IndexSongCell>> m_indexCellPool;
+    std::pair<size_t, size_t> m_visible = {0, 0};
+    float m_lastScrollY = 0.f;
+
+    // Cells are built a few per frame, placeholders stand in until then
+    BuildQueue m_buildQueue;
+    std::unordered_set<std::string> m_placeholders;
+    bool m_needsTouchPriority = false;
 
-    geode::EventListener<EventFilter<event::SongDownloadFinished>>
-        m_downloadFinishedListener = {this, &NongList::onDownloadFinish};
-    geode::EventListener<EventFilter<event::NongDeleted>>
-        m_nongDeletedListener = {this, &NongList::onNongDeleted};
     geode::EventListener<EventFilter<event::ManualSongAdded>>
         m_nongAddedListener = {this, &NongList::onSongAdded};
+    geode::EventListener<EventFilter<event::BatchCommitted>>
+        m_batchCommittedListener = {this, &NongList::onBatchCommitted};
+    // Downloads, deletions and state changes of the listed song IDs
+    std::vector<event::SongSubscription> m_songListeners;
 
     static constexpr float s_padding = 10.0f;
     static constexpr float s_itemSize = 60.f;
-
-    void addNoLocalSongsNotice(bool liveInsert = false);
-    void addSongToList(Song* nong, Nongs* parent, bool liveInsert = false);
-    void addIndexSongToList(index::IndexSongMetadata* song, Nongs* parent);
-    geode::ListenerResult onDownloadFinish(event::SongDownloadFinished* e);
-    geode::ListenerResult onNongDeleted(event::NongDeleted* e);
+    static constexpr float s_labelSize = 20.f;
+    // Per cell type, about two screens of cells
+    static constexpr size_t s_maxPooled = 16;
+    // Time spent building cells per frame, a quarter of a frame at 60fps
+    static constexpr std::chrono::microseconds s_frameBudget{4000};
+
+    void update(float dt) override;
+    void onEnter() override;
+    void onExit() override;
+    /**
+     * Rebuilds the model, keeping the scroll position unless told otherwise
+     */
+    void refresh(bool keepScroll);
+    /**
+     * Rebuilds the model and only touches the cells of items that changed
+     */
+    void applyUpdate(const std::vector<std::string>& forceUpdate = {});
+    void dropCell(const std::string& key);
+    void resizeContent(bool keepScroll);
+    void clearCells();
+    void updateVisibleCells(bool force = false);
+    /**
+     * Builds the cell of an item, or rebinds a pooled one
+     */
+    geode::Ref<cocos2d::CCNode> createCell(const NongListModel::Item& item);
+    bool hasPooledCell(const NongListModel::Item& item) const;
+    cocos2d::CCNode* createPlaceholder(const NongListModel::Item& item);
+    /**
+     * Swaps the placeholder of an item for its real cell
+     */
+    void buildCell(const std::string& key);
+    void dropPlaceholder(const std::string& key);
+    void updateTouchPriority();
+    /**
+     * Takes a built cell out of the list, into the pool if it has room
+     */
+    void recycle(cocos2d::CCNode* cell);
+    void onDownloadFinish(event::SongDownloadFinished* e);
+    void onNongDeleted(event::NongDeleted* e);
     geode::ListenerResult onSongAdded(event::ManualSongAdded* e);
+    geode::ListenerResult onBatchCommitted(event::BatchCommitted* e);
+    void onStateChange(event::SongStateChanged* e);
 
 public:
     void scrollToTop();
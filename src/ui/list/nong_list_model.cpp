@@ -0,0 +1,297 @@
+#include "ui/list/nong_list_model.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/core.h>
+
+#include "index.hpp"
+#include "managers/nong_manager.hpp"
+#include "nong.hpp"
+
+namespace jukebox {
+
+void NongListModel::push(Item&& item) { m_items.push_back(std::move(item)); }
+
+void NongListModel::layout() {
+    m_offsets.clear();
+    m_offsets.reserve(m_items.size());
+
+    float y = 0.f;
+    for (const Item& item : m_items) {
+        m_offsets.push_back(y);
+        y += item.height + m_metrics.gap;
+    }
+    m_height = m_items.empty() ? 0.f : y - m_metrics.gap;
+}
+
+void NongListModel::clear() {
+    m_items.clear();
+    m_offsets.clear();
+    m_height = 0.f;
+}
+
+void NongListModel::buildSongs(const std::vector<int>& songIDs) {
+    this->clear();
+
+    for (int id : songIDs) {
+        std::optional<Nongs*> nongs = NongManager::get().getNongs(id);
+        if (!nongs.has_value()) {
+            continue;
+        }
+
+        Song* active = nongs.value()->active();
+        this->push(Item{.type = ItemType::SongSummary,
+                        .key = fmt::format("song-{}", id),
+                        .height = m_metrics.itemHeight,
+                        .songID = id,
+                        .song = active,
+                        .label = fmt::format("{}|{}", active->metadata()->name,
+                                             active->metadata()->artist)});
+    }
+
+    this->layout();
+}
+
+void NongListModel::buildNongs(Nongs* nongs) {
+    this->clear();
+
+    const int id = nongs->songID();
+    const std::string activeID = nongs->active()->metadata()->uniqueID;
+
+    auto pushSong = [this, id, &activeID](Song* song, bool isDefault) {
+        this->push(Item{.type = ItemType::Song,
+                        .key = song->metadata()->uniqueID,
+                        .height = m_metrics.itemHeight,
+                        .songID = id,
+                        .song = song,
+                        .isDefault = isDefault,
+                        .isActive = song->metadata()->uniqueID == activeID,
+                        .label = fmt::format("{}|{}", song->metadata()->name,
+                                             song->metadata()->artist)});
+    };
+
+    pushSong(nongs->defaultSong(), true);
+
+    this->push(Item{.type = ItemType::Section,
+                    .key = "local-section",
+                    .height = m_metrics.labelHeight,
+                    .songID = id,
+                    .title = "Stored nongs"});
+
+    if (nongs->locals().empty() && nongs->youtube().empty() &&
+        nongs->hosted().empty()) {
+        this->push(Item{.type = ItemType::NoLocalSongs,
+                        .key = "no-local-songs",
+                        .height = m_metrics.labelHeight,
+                        .songID = id});
+    }
+
+    std::unordered_set<std::string> localYt;
+    std::unordered_set<std::string> localHosted;
+
+    for (std::unique_ptr<LocalSong>& nong : nongs->locals()) {
+        pushSong(nong.get(), false);
+    }
+
+    for (std::unique_ptr<YTSong>& nong : nongs->youtube()) {
+        pushSong(nong.get(), false);
+        if (nong->indexID().has_value()) {
+            localYt.insert(fmt::format("{}|{}", nong->indexID().value(),
+                                       nong->metadata()->uniqueID));
+        }
+    }
+
+    for (std::unique_ptr<HostedSong>& nong : nongs->hosted()) {
+        pushSong(nong.get(), false);
+        if (nong->indexID().has_value()) {
+            localHosted.insert(fmt::format("{}|{}", nong->indexID().value(),
+                                           nong->metadata()->uniqueID));
+        }
+    }
+
+    bool hasIndexSection = false;
+    for (index::IndexSongMetadata* index : nongs->indexSongs()) {
+        const std::string key =
+            fmt::format("{}|{}", index->parentID->m_id, index->uniqueID);
+
+        if (index->ytId.has_value() && localYt.contains(key)) {
+            continue;
+        }
+
+        if (index->url.has_value() && localHosted.contains(key)) {
+            continue;
+        }
+
+        if (!hasIndexSection) {
+            this->push(Item{.type = ItemType::Section,
+                            .key = "index-section",
+                            .height = m_metrics.labelHeight,
+                            .songID = id,
+                            .title = "Download nongs"});
+            hasIndexSection = true;
+        }
+
+        this->push(Item{
+            .type = ItemType::IndexSong,
+            .key = fmt::format("{}-{}", index->parentID->m_id, index->uniqueID),
+            .height = m_metrics.itemHeight,
+            .songID = id,
+            .indexSong = index});
+    }
+
+    this->layout();
+}
+
+bool NongListModel::Item::sameContent(const Item& other) const {
+    return type == other.type && height == other.height &&
+           songID == other.songID && song == other.song &&
+           isDefault == other.isDefault && isActive == other.isActive &&
+           indexSong == other.indexSong && title == other.title &&
+           label == other.label;
+}
+
+std::vector<NongListModel::Change> NongListModel::updateSongs(
+    const std::vector<int>& songIDs) {
+    std::vector<Item> before = std::move(m_items);
+    this->buildSongs(songIDs);
+    return diff(before, m_items);
+}
+
+std::vector<NongListModel::Change> NongListModel::updateNongs(
+    Nongs* nongs, const std::vector<std::string>& forceUpdate) {
+    std::vector<Item> before = std::move(m_items);
+    this->buildNongs(nongs);
+    std::vector<Change> changes = diff(before, m_items);
+
+    for (const std::string& key : forceUpdate) {
+        std::optional<size_t> i = this->find(key);
+        if (!i.has_value()) {
+            continue;
+        }
+        bool reported = std::any_of(
+            changes.begin(), changes.end(), [&key](const Change& change) {
+                return change.key == key &&
+                       (change.type == Change::Type::Update ||
+                        change.type == Change::Type::Insert);
+            });
+        if (!reported) {
+            changes.push_back(Change{Change::Type::Update, key, i.value(),
+                                     i.value()});
+        }
+    }
+
+    return changes;
+}
+
+std::vector<NongListModel::Change> NongListModel::diff(
+    const std::vector<Item>& before, const std::vector<Item>& after) {
+    std::vector<Change> changes;
+
+    std::unordered_map<std::string_view, size_t> beforeIndex;
+    beforeIndex.reserve(before.size());
+    for (size_t i = 0; i < before.size(); i++) {
+        beforeIndex.emplace(before[i].key, i);
+    }
+    std::unordered_map<std::string_view, size_t> afterIndex;
+    afterIndex.reserve(after.size());
+    for (size_t i = 0; i < after.size(); i++) {
+        afterIndex.emplace(after[i].key, i);
+    }
+
+    for (size_t i = 0; i < before.size(); i++) {
+        if (!afterIndex.contains(before[i].key)) {
+            changes.push_back(
+                Change{Change::Type::Remove, before[i].key, i, 0});
+        }
+    }
+
+    // Previous positions of the items that were kept, in their new order
+    std::vector<size_t> kept;
+    std::vector<size_t> keptAfter;
+    for (size_t i = 0; i < after.size(); i++) {
+        auto it = beforeIndex.find(after[i].key);
+        if (it == beforeIndex.end()) {
+            changes.push_back(Change{Change::Type::Insert, after[i].key, 0, i});
+            continue;
+        }
+        kept.push_back(it->second);
+        keptAfter.push_back(i);
+
+        if (!before[it->second].sameContent(after[i])) {
+            changes.push_back(
+                Change{Change::Type::Update, after[i].key, it->second, i});
+        }
+    }
+
+    // Items on the longest increasing run of previous positions keep their
+    // relative order, everything else has to move
+    std::vector<size_t> tails;
+    std::vector<size_t> tailIndex;
+    std::vector<std::optional<size_t>> parent(kept.size());
+    for (size_t i = 0; i < kept.size(); i++) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), kept[i]);
+        size_t pos = it - tails.begin();
+        if (pos > 0) {
+            parent[i] = tailIndex[pos - 1];
+        }
+        if (it == tails.end()) {
+            tails.push_back(kept[i]);
+            tailIndex.push_back(i);
+        } else {
+            *it = kept[i];
+            tailIndex[pos] = i;
+        }
+    }
+
+    std::vector<bool> stays(kept.size(), false);
+    std::optional<size_t> cursor =
+        tailIndex.empty() ? std::nullopt : std::optional(tailIndex.back());
+    while (cursor.has_value()) {
+        stays[cursor.value()] = true;
+        cursor = parent[cursor.value()];
+    }
+
+    for (size_t i = 0; i < kept.size(); i++) {
+        if (!stays[i]) {
+            changes.push_back(Change{Change::Type::Move,
+                                     after[keptAfter[i]].key, kept[i],
+                                     keptAfter[i]});
+        }
+    }
+
+    return changes;
+}
+
+std::pair<size_t, size_t> NongListModel::range(float top, float bottom) const {
+    // First item whose bottom edge is below the top of the window
+    auto first = std::upper_bound(
+        m_offsets.begin(), m_offsets.end(), top,
+        [this](float y, const float& offset) {
+            size_t i = &offset - m_offsets.data();
+            return y < offset + m_items[i].height;
+        });
+    // First item that starts below the bottom of the window
+    auto last = std::upper_bound(m_offsets.begin(), m_offsets.end(), bottom);
+
+    size_t a = first - m_offsets.begin();
+    size_t b = last - m_offsets.begin();
+    return {a, std::max(a, b)};
+}
+
+std::optional<size_t> NongListModel::find(const std::string& key) const {
+    for (size_t i = 0; i < m_items.size(); i++) {
+        if (m_items[i].key == key) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+}  // namespace jukebox
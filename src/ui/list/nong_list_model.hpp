@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "index.hpp"
+#include "nong.hpp"
+
+namespace jukebox {
+
+/**
+ * Flattened rows of a NongList, built without creating any node. The list
+ * only turns the rows near the viewport into cells.
+ */
+class NongListModel {
+public:
+    enum class ItemType {
+        // One row per song ID in the multiple songs view
+        SongSummary,
+        Section,
+        NoLocalSongs,
+        Song,
+        IndexSong,
+    };
+
+    struct Item {
+        ItemType type;
+        // Unique within the model, also used as the cell ID
+        std::string key;
+        float height;
+        int songID;
+
+        // Set for ItemType::Song
+        Song* song = nullptr;
+        bool isDefault = false;
+        bool isActive = false;
+        // Set for ItemType::IndexSong
+        index::IndexSongMetadata* indexSong = nullptr;
+        // Section title
+        std::string title;
+        // Displayed song name and artist, so in place edits show up in diffs
+        std::string label;
+
+        // Whether the cell for this item has to be recreated
+        bool sameContent(const Item& other) const;
+    };
+
+    /**
+     * One step to get from the previous items to the current ones. Indexes
+     * refer to the previous and current item lists respectively.
+     */
+    struct Change {
+        enum class Type { Insert, Remove, Move, Update };
+
+        Type type;
+        std::string key;
+        size_t from = 0;
+        size_t to = 0;
+    };
+
+    struct Metrics {
+        float itemHeight;
+        float labelHeight;
+        float gap;
+    };
+
+protected:
+    Metrics m_metrics;
+    std::vector<Item> m_items;
+    // Top edge of every item, measured from the top of the list
+    std::vector<float> m_offsets;
+    float m_height = 0.f;
+
+    void push(Item&& item);
+    void layout();
+
+public:
+    NongListModel(Metrics metrics) : m_metrics(metrics) {}
+
+    /**
+     * Rows for the song ID picker of a multi song level
+     */
+    void buildSongs(const std::vector<int>& songIDs);
+
+    /**
+     * Rows for a single song ID: default song, stored nongs, then index
+     * songs that aren't stored yet
+     */
+    void buildNongs(Nongs* nongs);
+
+    void clear();
+
+    /**
+     * Rebuilds the rows and returns the minimal changes from the previous
+     * ones. Keys passed in forceUpdate are reported as updated even if
+     * nothing about them changed, e.g. when their file was downloaded.
+     */
+    std::vector<Change> updateSongs(const std::vector<int>& songIDs);
+    std::vector<Change> updateNongs(
+        Nongs* nongs, const std::vector<std::string>& forceUpdate = {});
+
+    static std::vector<Change> diff(const std::vector<Item>& before,
+                                    const std::vector<Item>& after);
+
+    const std::vector<Item>& items() const { return m_items; }
+    size_t size() const { return m_items.size(); }
+    const Item& at(size_t i) const { return m_items[i]; }
+    float offset(size_t i) const { return m_offsets[i]; }
+
+    // Total height including gaps
+    float height() const { return m_height; }
+
+    /**
+     * Range of items [first, last) that overlap [top, bottom], both measured
+     * from the top of the list
+     */
+    std::pair<size_t, size_t> range(float top, float bottom) const;
+
+    std::optional<size_t> find(const std::string& key) const;
+};
+
+}  // namespace jukebox
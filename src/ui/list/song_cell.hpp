@@ -31,6 +31,7 @@ public:
                             std::function<void()> selectCallback) {
         auto ret = new SongCell();
         if (ret && ret->init(id, songInfo, size, selectCallback)) {
+            ret->autorelease();
             return ret;
         }
         CC_SAFE_DELETE(ret);
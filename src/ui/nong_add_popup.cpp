@@ -36,6 +36,7 @@
 #include "fmod.hpp"
 #include "fmod_common.h"
 
+#include "managers/deletion_queue.hpp"
 #include "managers/index_manager.hpp"
 #include "nong.hpp"
 #include "ui/index_choose_popup.hpp"
@@ -678,6 +679,7 @@ geode::Result<> NongAddPopup::addLocalSong(
         }
     }
     destination /= unique;
+    DeletionQueue::get().cancel(destination);
 
     if (std::filesystem::exists(destination, error_code)) {
         std::filesystem::remove(destination, error_code);
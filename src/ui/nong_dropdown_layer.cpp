@@ -19,13 +19,18 @@
 #include "Geode/ui/GeodeUI.hpp"
 #include "Geode/ui/Layout.hpp"
 #include "Geode/ui/Popup.hpp"
+#include "Geode/utils/file.hpp"
 #include "Geode/utils/web.hpp"
 #include "ccTypes.h"
 
 #include "events/get_song_info.hpp"
+#include "events/song_dispatcher.hpp"
+#include "events/song_download_failed.hpp"
 #include "managers/index_manager.hpp"
+#include "managers/latency_recorder.hpp"
 #include "managers/nong_manager.hpp"
 #include "nong.hpp"
+#include "storage/bundle.hpp"
 #include "ui/list/nong_list.hpp"
 #include "ui/nong_add_popup.hpp"
 
@@ -33,6 +38,7 @@ namespace jukebox {
 
 bool NongDropdownLayer::setup(std::vector<int> ids, CustomSongWidget* parent,
                               int defaultSongID) {
+    LatencyRecorder::Scope latency("dropdown.open");
     m_songIDS = ids;
     m_parentWidget = parent;
     m_defaultSongID = defaultSongID;
@@ -110,8 +116,27 @@ bool NongDropdownLayer::setup(std::vector<int> ids, CustomSongWidget* parent,
         sprite, this, menu_selector(NongDropdownLayer::onSettings));
     settingsButton->setID("settings-button");
     menu->addChild(settingsButton);
+
+    sprite = CCSprite::createWithSpriteFrameName("GJ_shareBtn_001.png");
+    sprite->setScale(0.5f);
+    CCMenuItemSpriteExtra* exportButton = CCMenuItemSpriteExtra::create(
+        sprite, this, menu_selector(NongDropdownLayer::onExportBundle));
+    exportButton->setID("export-button");
+    menu->addChild(exportButton);
+
+    sprite = CCSprite::createWithSpriteFrameName("GJ_downloadBtn_001.png");
+    sprite->setScale(0.5f);
+    CCMenuItemSpriteExtra* importButton = CCMenuItemSpriteExtra::create(
+        sprite, this, menu_selector(NongDropdownLayer::onImportBundle));
+    importButton->setID("import-button");
+    menu->addChild(importButton);
+
     menu->setAnchorPoint({0.5f, 1.0f});
-    menu->setContentSize(settingsButton->getScaledContentSize());
+    menu->setContentSize({settingsButton->getScaledContentSize().width,
+                          settingsButton->getScaledContentSize().height +
+                              exportButton->getScaledContentSize().height +
+                              importButton->getScaledContentSize().height +
+                              10.f});
     ColumnLayout* settingsLayout = ColumnLayout::create();
     settingsLayout->setAxisAlignment(AxisAlignment::End);
     settingsLayout->setAxisReverse(true);
@@ -161,40 +186,131 @@ bool NongDropdownLayer::setup(std::vector<int> ids, CustomSongWidget* parent,
         return ListenerResult::Propagate;
     });
 
-    m_songInfoListener.bind([this](event::GetSongInfo* event) {
-        if (!m_list || m_currentSongID != event->gdSongID()) {
-            return ListenerResult::Propagate;
-        }
+    for (int id : m_songIDS) {
+        m_songListeners.push_back(
+            event::SongDispatcher<event::GetSongInfo>::get().subscribe(
+                id, [this](auto* e) { this->onGetSongInfo(e); }));
+        m_songListeners.push_back(
+            event::SongDispatcher<event::SongDownloadFailed>::get().subscribe(
+                id, [this](auto* e) { this->onDownloadFailed(e); }));
+    }
 
-        FLAlertLayer* popup = FLAlertLayer::create(
-            "Download failed", "Successfully refetched default song data",
-            "Ok");
-        popup->setZOrder(this->getZOrder() + 1);
-        popup->show();
+    return true;
+}
 
-        return ListenerResult::Propagate;
-    });
+void NongDropdownLayer::onSettings(CCObject* sender) {
+    geode::openSettingsPopup(Mod::get());
+}
 
-    m_downloadFailedListener.bind([this](event::SongDownloadFailed* event) {
-        if (!m_list || m_currentSongID != event->gdSongId()) {
-            return ListenerResult::Propagate;
+void NongDropdownLayer::onExportBundle(CCObject*) {
+    file::FilePickOptions::Filter filter = {
+        .description = "NONG bundles", .files = {"*.nongbundle"}};
+    file::FilePickOptions options = {std::nullopt, {filter}};
+
+    m_bundleListener.bind(
+        [this](Task<Result<std::filesystem::path>>::Event* event) {
+            Result<std::filesystem::path>* result = event->getValue();
+            if (!result) {
+                return;
+            }
+            if (result->isErr()) {
+                this->showBundleResult("Export failed",
+                                       Err(result->unwrapErr()));
+                return;
+            }
+
+            std::filesystem::path path = result->unwrap();
+            if (path.extension() != ".nongbundle") {
+                path += ".nongbundle";
+            }
+            Ref<NongDropdownLayer> self = this;
+            storage::bundle::exportTo(
+                m_songIDS, path,
+                [self](Result<storage::BundleSummary> res) {
+                    self->showBundleResult("Export", std::move(res));
+                });
+        });
+    m_bundleListener.setFilter(file::pick(file::PickMode::SaveFile, options));
+}
+
+void NongDropdownLayer::onImportBundle(CCObject*) {
+    file::FilePickOptions::Filter filter = {
+        .description = "NONG bundles", .files = {"*.nongbundle"}};
+    file::FilePickOptions options = {std::nullopt, {filter}};
+
+    m_bundleListener.bind(
+        [this](Task<Result<std::filesystem::path>>::Event* event) {
+            Result<std::filesystem::path>* result = event->getValue();
+            if (!result) {
+                return;
+            }
+            if (result->isErr()) {
+                this->showBundleResult("Import failed",
+                                       Err(result->unwrapErr()));
+                return;
+            }
+
+            Ref<NongDropdownLayer> self = this;
+            storage::bundle::importFrom(
+                result->unwrap(), [self](Result<storage::BundleSummary> res) {
+                    self->showBundleResult("Import", std::move(res));
+                });
+        });
+    m_bundleListener.setFilter(file::pick(file::PickMode::OpenFile, options));
+}
+
+void NongDropdownLayer::showBundleResult(
+    const std::string& title, Result<storage::BundleSummary> result) {
+    std::string body;
+    if (result.isErr()) {
+        body = result.unwrapErr();
+    } else {
+        const storage::BundleSummary& summary = result.unwrap();
+        body = fmt::format(
+            "{} songs for {} song IDs, {} audio files ({} already stored), "
+            "{:.2f}MB copied.",
+            summary.songs, summary.songIDs, summary.blobs,
+            summary.blobsSkipped, summary.bytes / 1024.0 / 1024.0);
+        if (!summary.missingIDs.empty()) {
+            body += fmt::format(
+                "\n<cy>{}</c> song IDs weren't set up yet and were skipped.",
+                summary.missingIDs.size());
         }
+    }
 
-        FLAlertLayer* popup = FLAlertLayer::create(
-            "Download failed",
-            fmt::format("Song download failed. Reason: {}", event->error()),
-            "Ok");
-        popup->setZOrder(this->getZOrder() + 1);
-        popup->show();
+    FLAlertLayer* popup = FLAlertLayer::create(title.c_str(), body, "Ok");
+    popup->setZOrder(this->getZOrder() + 1);
+    popup->show();
+}
 
-        return ListenerResult::Propagate;
-    });
+void NongDropdownLayer::onGetSongInfo(event::GetSongInfo* event) {
+    if (!m_list || m_currentSongID != event->gdSongID()) {
+        return;
+    }
 
-    return true;
+    FLAlertLayer* popup = FLAlertLayer::create(
+        "Download failed", "Successfully refetched default song data", "Ok");
+    popup->setZOrder(this->getZOrder() + 1);
+    popup->show();
 }
 
-void NongDropdownLayer::onSettings(CCObject* sender) {
-    geode::openSettingsPopup(Mod::get());
+void NongDropdownLayer::onDownloadFailed(event::SongDownloadFailed* event) {
+    if (!m_list || m_currentSongID != event->gdSongId()) {
+        return;
+    }
+
+    FLAlertLayer* popup = FLAlertLayer::create(
+        "Download failed",
+        fmt::format("Song download failed. Reason: {}", event->error()), "Ok");
+    popup->setZOrder(this->getZOrder() + 1);
+    popup->show();
+}
+
+void NongDropdownLayer::onClose(CCObject* sender) {
+    if (LatencyRecorder::get().enabled()) {
+        LatencyRecorder::get().log();
+    }
+    Popup::onClose(sender);
 }
 
 void NongDropdownLayer::onSelectSong(int songID) { m_currentSongID = songID; }
@@ -259,6 +375,7 @@ CCSize NongDropdownLayer::getCellSize() const { return {320.f, 60.f}; }
 
 void NongDropdownLayer::setActiveSong(int gdSongID,
                                       const std::string& uniqueID) {
+    LatencyRecorder::Scope latency("set_active");
     if (auto err = NongManager::get().setActiveSong(gdSongID, uniqueID);
         err.isErr()) {
         FLAlertLayer::create(
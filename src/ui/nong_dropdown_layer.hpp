@@ -1,5 +1,6 @@
 #pragma once
 
+#include <filesystem>
 #include <vector>
 #include "Geode/binding/CCMenuItemSpriteExtra.hpp"
 #include "Geode/binding/CustomSongWidget.hpp"
@@ -7,12 +8,15 @@
 #include "Geode/cocos/platform/CCPlatformMacros.h"
 #include "Geode/loader/Event.hpp"
 #include "Geode/ui/Popup.hpp"
+#include "Geode/utils/Task.hpp"
 #include "Geode/utils/cocos.hpp"
 
 #include "events/get_song_info.hpp"
+#include "events/song_dispatcher.hpp"
 #include "events/song_download_failed.hpp"
 #include "events/song_error.hpp"
 #include "nong.hpp"
+#include "storage/bundle.hpp"
 #include "ui/list/nong_cell.hpp"
 #include "ui/list/nong_list.hpp"
 #include "ui/list/song_cell.hpp"
@@ -37,9 +41,9 @@ protected:
     CCMenuItemSpriteExtra* m_deleteBtn = nullptr;
 
     EventListener<EventFilter<event::SongError>> m_songErrorListener;
-    EventListener<EventFilter<event::GetSongInfo>> m_songInfoListener;
-    EventListener<EventFilter<event::SongDownloadFailed>>
-        m_downloadFailedListener;
+    // Song info and download failures for every song ID of the popup
+    std::vector<event::SongSubscription> m_songListeners;
+    EventListener<Task<Result<std::filesystem::path>>> m_bundleListener;
 
     bool m_fetching = false;
 
@@ -50,7 +54,14 @@ protected:
     void deleteAllNongs(CCObject*);
     void fetchSongFileHub(CCObject*);
     void onSettings(CCObject*);
+    void onExportBundle(CCObject*);
+    void onImportBundle(CCObject*);
+    void showBundleResult(const std::string& title,
+                          Result<storage::BundleSummary> result);
+    void onGetSongInfo(event::GetSongInfo* event);
+    void onDownloadFailed(event::SongDownloadFailed* event);
     void openAddPopup(CCObject*);
+    void onClose(CCObject*) override;
 
 public:
     void onSelectSong(int songID);
@@ -0,0 +1,271 @@
+#include "utils/io_benchmark.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fmt/core.h>
+#include <matjson.hpp>
+#include "Geode/Result.hpp"
+#include "Geode/loader/Log.hpp"
+#include "Geode/loader/Mod.hpp"
+
+#include "io/io_backend.hpp"
+#include "io/pack_archive.hpp"
+#include "managers/executor.hpp"
+#include "storage/json_storage.hpp"
+#include "storage/sqlite_storage.hpp"
+#include "storage/storage_backend.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace {
+
+constexpr size_t s_smallFiles = 2000;
+constexpr size_t s_smallSize = 2 * 1024;
+constexpr size_t s_largeFiles = 4;
+constexpr size_t s_largeSize = 16 * 1024 * 1024;
+constexpr size_t s_records = 2000;
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+void runCase(io::IoBackend& backend, const std::filesystem::path& directory,
+             size_t files, const std::vector<uint8_t>& data) {
+    std::vector<std::filesystem::path> paths;
+    std::vector<io::FileWrite> writes;
+    paths.reserve(files);
+    writes.reserve(files);
+    for (size_t i = 0; i < files; i++) {
+        paths.push_back(directory / fmt::format("{}-{}.bin", files, i));
+        writes.push_back(io::FileWrite{paths.back(), std::span(data)});
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (Result<> res = backend.write(writes); res.isErr()) {
+        log::error("[{}] write failed: {}", backend.name(), res.unwrapErr());
+        return;
+    }
+    const double writeMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::optional<uintmax_t>> sizes = backend.sizes(paths);
+    const double statMs = elapsedMs(start);
+
+    size_t missing = 0;
+    for (const std::optional<uintmax_t>& size : sizes) {
+        if (size != data.size()) {
+            missing++;
+        }
+    }
+
+    const double megabytes = files * data.size() / 1024.0 / 1024.0;
+    log::info(
+        "[{}] {} files of {}KB: write {:.1f}ms ({:.1f}MB/s), stat {:.1f}ms{}",
+        backend.name(), files, data.size() / 1024, writeMs,
+        megabytes / (writeMs / 1000.0), statMs,
+        missing > 0 ? fmt::format(", {} wrong sizes", missing) : "");
+}
+
+// Opening and reading every small file, loose and packed
+void runPackCase(const std::filesystem::path& directory,
+                 const std::vector<uint8_t>& data) {
+    std::vector<std::filesystem::path> paths;
+    std::vector<io::FileWrite> writes;
+    std::vector<io::PackEntry> entries;
+    for (size_t i = 0; i < s_smallFiles; i++) {
+        paths.push_back(directory / fmt::format("loose-{}.bin", i));
+        writes.push_back(io::FileWrite{paths.back(), std::span(data)});
+        entries.push_back(
+            io::PackEntry{fmt::format("{}.bin", i), std::span(data)});
+    }
+    if (Result<> res = io::backend().write(writes); res.isErr()) {
+        log::error("[pack] write failed: {}", res.unwrapErr());
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Result<std::unique_ptr<io::PackArchive>> pack =
+        io::PackArchive::open(directory / "benchmark.jbpk");
+    if (pack.isErr()) {
+        log::error("[pack] open failed: {}", pack.unwrapErr());
+        return;
+    }
+    std::unique_ptr<io::PackArchive> archive = std::move(pack).unwrap();
+    if (Result<> res = archive->add(entries); res.isErr()) {
+        log::error("[pack] add failed: {}", res.unwrapErr());
+        return;
+    }
+    const double packMs = elapsedMs(start);
+
+    std::vector<char> buffer(data.size());
+    start = std::chrono::steady_clock::now();
+    for (const std::filesystem::path& path : paths) {
+        std::ifstream input(path, std::ios_base::binary);
+        input.read(buffer.data(), buffer.size());
+    }
+    const double looseMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (const io::PackEntry& entry : entries) {
+        if (std::optional<io::PackView> view = archive->find(entry.key)) {
+            std::memcpy(buffer.data(), view->data.data(), view->data.size());
+        }
+    }
+    const double packedMs = elapsedMs(start);
+
+    log::info(
+        "[pack] {} files: packing {:.1f}ms, reading loose {:.1f}ms "
+        "({:.1f}us each), packed {:.1f}ms ({:.1f}us each)",
+        s_smallFiles, packMs, looseMs, looseMs * 1000.0 / s_smallFiles,
+        packedMs, packedMs * 1000.0 / s_smallFiles);
+}
+
+// Shaped like a manifest record with a few custom songs
+std::vector<storage::Write> makeRecords() {
+    std::vector<storage::Write> records;
+    records.reserve(s_records);
+    for (size_t i = 0; i < s_records; i++) {
+        const int songID = static_cast<int>(10000000 + i);
+        auto song = [songID](const char* kind, size_t n) {
+            return matjson::makeObject({
+                {"name", fmt::format("Benchmark {} {}", kind, n)},
+                {"unique_id", fmt::format("{}-{}-{}", songID, kind, n)},
+                {"artist", "Jukebox"},
+                {"offset", 0},
+                {"path", fmt::format("nongs/{}-{}-{}.mp3", songID, kind, n)},
+            });
+        };
+
+        matjson::Value locals = matjson::Value::array();
+        matjson::Value hosted = matjson::Value::array();
+        for (size_t n = 0; n < 3; n++) {
+            locals.push(song("local", n));
+            matjson::Value entry = song("hosted", n);
+            entry["url"] = fmt::format("https://example.com/{}.mp3", n);
+            hosted.push(std::move(entry));
+        }
+
+        matjson::Value record = matjson::makeObject({
+            {"default", song("default", 0)},
+            {"active", fmt::format("{}-local-0", songID)},
+            {"locals", std::move(locals)},
+            {"youtube", matjson::Value::array()},
+            {"hosted", std::move(hosted)},
+        });
+        records.push_back(storage::Write{songID, std::move(record)});
+    }
+    return records;
+}
+
+// Startup load, a full import and the single record commits that make up
+// most writes
+void runStorageCase(storage::StorageBackend& storage,
+                    const std::vector<storage::Write>& records) {
+    auto start = std::chrono::steady_clock::now();
+    if (Result<> res = storage.open(); res.isErr()) {
+        log::error("[{}] open failed: {}", storage.name(), res.unwrapErr());
+        return;
+    }
+    const double openMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    if (Result<> res = storage.apply(records); res.isErr()) {
+        log::error("[{}] apply failed: {}", storage.name(), res.unwrapErr());
+        return;
+    }
+    const double applyMs = elapsedMs(start);
+
+    constexpr size_t commits = 100;
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < commits; i++) {
+        (void)storage.apply({records[i % records.size()]});
+    }
+    const double commitMs = elapsedMs(start);
+
+    size_t loaded = 0;
+    start = std::chrono::steady_clock::now();
+    Result<> res = storage.forEach(
+        [&loaded](int, Result<matjson::Value> record) {
+            if (record.isOk()) {
+                loaded++;
+            }
+        });
+    const double loadMs = elapsedMs(start);
+    if (res.isErr()) {
+        log::error("[{}] load failed: {}", storage.name(), res.unwrapErr());
+        return;
+    }
+
+    log::info(
+        "[{}] {} records: open {:.1f}ms, apply {:.1f}ms, {} single commits "
+        "{:.1f}ms ({:.2f}ms each), load {:.1f}ms{}",
+        storage.name(), records.size(), openMs, applyMs, commits, commitMs,
+        commitMs / commits, loadMs,
+        loaded != records.size()
+            ? fmt::format(", {} of them loaded", loaded)
+            : "");
+}
+
+}  // namespace
+
+void runIoBenchmark() {
+    const std::filesystem::path directory =
+        Mod::get()->getSaveDir() / "io-benchmark";
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        log::error("Couldn't create {}: {}", directory.string(), ec.message());
+        return;
+    }
+
+    log::info("Running I/O benchmark with {} workers",
+              Executor::get().workerCount());
+
+    const std::vector<uint8_t> small(s_smallSize, 'j');
+    const std::vector<uint8_t> large(s_largeSize, 'j');
+
+    std::vector<std::unique_ptr<io::IoBackend>> backends;
+    backends.push_back(io::createBlockingBackend());
+    backends.push_back(io::createPooledBackend());
+
+    for (const std::unique_ptr<io::IoBackend>& backend : backends) {
+        runCase(*backend, directory, s_smallFiles, small);
+        runCase(*backend, directory, s_largeFiles, large);
+    }
+    runPackCase(directory, small);
+
+    const std::vector<storage::Write> records = makeRecords();
+    {
+        storage::JsonStorage json(directory / "manifest");
+        runStorageCase(json, records);
+    }
+#ifdef JUKEBOX_SQLITE_STORAGE
+    {
+        // Nothing to import, the legacy directory stays empty. Closed
+        // before the directory is removed.
+        storage::SqliteStorage sqlite(directory / "manifest.db",
+                                      directory / "legacy");
+        runStorageCase(sqlite, records);
+    }
+#endif
+
+    std::filesystem::remove_all(directory, ec);
+}
+
+}  // namespace jukebox
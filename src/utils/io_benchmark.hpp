@@ -0,0 +1,18 @@
+#pragma once
+
+namespace jukebox {
+
+/**
+ * Compares the blocking and pooled I/O backends on a batch of small files,
+ * like manifest records, and a few large ones, like songs, then reading
+ * small files loose against reading them from a pack. Then loads and
+ * applies manifest records with the JSON storage, and with SQLite when
+ * it's built in. Works in a scratch directory under the save directory
+ * and removes it afterwards.
+ *
+ * Runs on a worker at startup when the game is launched with the
+ * benchmark-io launch flag.
+ */
+void runIoBenchmark();
+
+}  // namespace jukebox
@@ -0,0 +1,140 @@
+#include "utils/rollback_check.hpp"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <fmt/core.h>
+#include "Geode/cocos/base_nodes/CCNode.h"
+#include "Geode/loader/Log.hpp"
+#include "Geode/utils/cocos.hpp"
+
+#include "managers/nong_manager.hpp"
+#include "manifest_snapshot.hpp"
+#include "nong.hpp"
+#include "transaction.hpp"
+#include "ui/list/nong_cell.hpp"
+#include "ui/list/nong_list.hpp"
+
+using namespace geode::prelude;
+
+namespace jukebox {
+
+namespace {
+
+// Frames given to the list to build its visible cells
+constexpr int s_frames = 30;
+
+void collectCells(CCNode* node, std::vector<NongCell*>& cells) {
+    if (NongCell* cell = typeinfo_cast<NongCell*>(node)) {
+        cells.push_back(cell);
+    }
+    for (CCNode* child : CCArrayExt<CCNode*>(node->getChildren())) {
+        collectCells(child, cells);
+    }
+}
+
+void runFrames(NongList* list) {
+    for (int i = 0; i < s_frames; i++) {
+        static_cast<CCNode*>(list)->update(0.f);
+    }
+}
+
+// Only compares addresses, a dangling pointer must not be read
+Result<> checkCells(NongList* list, Nongs* nongs) {
+    std::unordered_set<Song*> live = {nongs->defaultSong()};
+    for (const std::unique_ptr<LocalSong>& i : nongs->locals()) {
+        live.insert(i.get());
+    }
+    for (const std::unique_ptr<YTSong>& i : nongs->youtube()) {
+        live.insert(i.get());
+    }
+    for (const std::unique_ptr<HostedSong>& i : nongs->hosted()) {
+        live.insert(i.get());
+    }
+
+    std::vector<NongCell*> cells;
+    collectCells(list, cells);
+    if (cells.empty()) {
+        return Err("The list didn't build any cell");
+    }
+    for (NongCell* cell : cells) {
+        if (cell->m_songInfo && !live.contains(cell->m_songInfo)) {
+            return Err("A cell points at a song that no longer exists");
+        }
+    }
+    return Ok();
+}
+
+}  // namespace
+
+Result<> runRollbackCheck() {
+    NongManager& manager = NongManager::get();
+
+    std::optional<int> songID;
+    for (const auto& [id, entry] : manager.snapshot()->nongs()) {
+        if (!entry->songs.empty()) {
+            songID = id;
+            break;
+        }
+    }
+    if (!songID.has_value()) {
+        return Err("No song ID with custom songs to check against");
+    }
+
+    Nongs* nongs = manager.getNongs(songID.value()).value();
+    Song* defaultSong = nongs->defaultSong();
+    Song* active = nongs->active();
+    std::string activeID = active->metadata()->uniqueID;
+
+    // Prefer a song that isn't active, so the active one must survive
+    std::string removed;
+    for (const auto& song : manager.snapshot()->find(songID.value())->songs) {
+        removed = song.metadata.uniqueID;
+        if (removed != activeID) {
+            break;
+        }
+    }
+
+    std::vector<int> ids = {songID.value()};
+    Ref<NongList> list = NongList::create(
+        ids, {400.f, 200.f}, [](int, const std::string&) {},
+        [](int, const std::string&, bool, bool) {},
+        [](int, const std::string&) {}, [](int, const std::string&) {},
+        [](std::optional<int>) {});
+    if (!list) {
+        return Err("Couldn't create the list");
+    }
+    runFrames(list);
+    GEODE_UNWRAP(checkCells(list, nongs));
+
+    Result<> res = Transaction()
+                       .deleteSong(songID.value(), removed, false)
+                       .setActive(songID.value(), "rollback-check-missing")
+                       .commit();
+    if (res.isOk()) {
+        return Err("The failing commit went through");
+    }
+
+    if (nongs->defaultSong() != defaultSong) {
+        return Err("The default song was replaced by the rollback");
+    }
+    if (removed != activeID && nongs->active() != active) {
+        return Err("The active song was replaced by the rollback");
+    }
+    if (!nongs->findSong(removed).has_value()) {
+        return Err("The removed song wasn't restored");
+    }
+
+    // The cells were rebound or rebuilt by the event posted after restoring
+    GEODE_UNWRAP(checkCells(list, nongs));
+    runFrames(list);
+    GEODE_UNWRAP(checkCells(list, nongs));
+
+    log::info("Rollback check passed on song ID {}", songID.value());
+    return Ok();
+}
+
+}  // namespace jukebox
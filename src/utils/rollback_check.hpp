@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Geode/Result.hpp"
+
+namespace jukebox {
+
+/**
+ * Opens a NongList on a song ID of the manifest, commits a Transaction that
+ * fails halfway and checks that every cell still points at a live song once
+ * the rollback went through. Nothing gets written, the song ID ends up as it
+ * was.
+ *
+ * Runs at startup when the game is launched with the check-rollback launch
+ * flag.
+ */
+geode::Result<> runRollbackCheck();
+
+}  // namespace jukebox
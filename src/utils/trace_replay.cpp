@@ -0,0 +1,204 @@
+#include "utils/trace_replay.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/core.h>
+#include "Geode/loader/Log.hpp"
+#include "Geode/Result.hpp"
+
+#include "index.hpp"
+#include "managers/hook_trace.hpp"
+#include "managers/latency_recorder.hpp"
+#include "managers/song_pack.hpp"
+#include "manifest_snapshot.hpp"
+#include "nong.hpp"
+#include "song_path.hpp"
+
+namespace jukebox {
+
+namespace {
+
+// Far away from anything GD or the manifest would use
+constexpr int s_baseSongID = 2000000000;
+
+const char* opName(TraceOp op) {
+    switch (op) {
+        case TraceOp::PathForSong:
+            return "path_for_song";
+        case TraceOp::GetAudioFileName:
+            return "get_audio_file_name";
+        case TraceOp::GetSongInfoObject:
+            return "get_song_info_object";
+        case TraceOp::GetAudioTitle:
+            return "get_audio_title";
+        case TraceOp::LevelCellName:
+            return "level_cell_name";
+        case TraceOp::Publish:
+            return "publish";
+    }
+    return "unknown";
+}
+
+struct Fixture {
+    // Index songs point at it, so it must not move with the fixture
+    std::unique_ptr<index::IndexMetadata> index =
+        std::make_unique<index::IndexMetadata>();
+    std::vector<std::unique_ptr<index::IndexSongMetadata>> indexSongs;
+    // slot -> nongs, only for slots that were in the manifest
+    std::unordered_map<uint32_t, std::unique_ptr<Nongs>> nongs;
+};
+
+std::unique_ptr<Nongs> makeNongs(int songID, const TraceShape& shape,
+                                 Fixture& fixture) {
+    auto nongs = std::make_unique<Nongs>(
+        songID,
+        LocalSong(SongMetadata(songID, "default", "Default song", "RobTop"),
+                  SongPath(PathRoot::Songs, fmt::format("{}.mp3", songID))));
+
+    auto metadata = [songID](const char* kind, uint32_t i) {
+        return SongMetadata(songID, fmt::format("{}-{}", kind, i),
+                            fmt::format("Song {}", i),
+                            fmt::format("Artist {}", i));
+    };
+    auto path = [](const char* kind, uint32_t i) {
+        return SongPath(PathRoot::Nongs, fmt::format("{}-{}.mp3", kind, i));
+    };
+
+    for (uint32_t i = 0; i < shape.locals; i++) {
+        (void)nongs->add(LocalSong(metadata("local", i), path("local", i)));
+    }
+    for (uint32_t i = 0; i < shape.youtube; i++) {
+        (void)nongs->add(YTSong(metadata("youtube", i), "dQw4w9WgXcQ",
+                                std::nullopt, path("youtube", i)));
+    }
+    for (uint32_t i = 0; i < shape.hosted; i++) {
+        (void)nongs->add(HostedSong(metadata("hosted", i),
+                                    "https://example.com/song.mp3",
+                                    std::nullopt, path("hosted", i)));
+    }
+
+    for (uint32_t i = 0; i < shape.indexSongs; i++) {
+        auto song = std::make_unique<index::IndexSongMetadata>();
+        song->uniqueID = fmt::format("index-{}", i);
+        song->name = fmt::format("Index song {}", i);
+        song->artist = fmt::format("Index artist {}", i);
+        song->url = "https://example.com/index.mp3";
+        song->songIDs = {songID};
+        song->parentID = fixture.index.get();
+        (void)nongs->registerIndexSong(song.get());
+        fixture.indexSongs.push_back(std::move(song));
+    }
+
+    return nongs;
+}
+
+// Same work as the hooks, minus calling into GD
+size_t replay(const TraceEvent& event, Nongs* nongs, uint64_t version) {
+    if (!nongs) {
+        return 0;
+    }
+
+    Song* active = nongs->active();
+    switch (event.op) {
+        case TraceOp::PathForSong:
+        case TraceOp::GetAudioFileName: {
+            (void)SongPack::get().exists(active->path().value());
+            return active->songPath()->utf8().size();
+        }
+        case TraceOp::GetSongInfoObject: {
+            std::string name = active->metadata()->name;
+            std::string artist = active->metadata()->artist;
+            return name.size() + artist.size();
+        }
+        case TraceOp::GetAudioTitle:
+        case TraceOp::LevelCellName: {
+            std::string name = active->metadata()->name;
+            return name.size();
+        }
+        case TraceOp::Publish:
+            return NongsSnapshot::from(*nongs, version)->songs.size();
+    }
+    return 0;
+}
+
+}  // namespace
+
+std::optional<std::filesystem::path> latestTrace() {
+    std::error_code ec;
+    std::filesystem::directory_iterator it(HookTrace::tracesPath(), ec);
+    if (ec) {
+        return std::nullopt;
+    }
+
+    std::optional<std::filesystem::path> latest;
+    std::filesystem::file_time_type latestTime;
+    for (const std::filesystem::directory_entry& entry : it) {
+        if (entry.path().extension() != ".bin") {
+            continue;
+        }
+        std::filesystem::file_time_type time = entry.last_write_time(ec);
+        if (ec) {
+            continue;
+        }
+        if (!latest.has_value() || time > latestTime) {
+            latest = entry.path();
+            latestTime = time;
+        }
+    }
+    return latest;
+}
+
+geode::Result<> replayTrace(const std::filesystem::path& path) {
+    GEODE_UNWRAP_INTO(Trace trace, HookTrace::read(path));
+    geode::log::info("Replaying {} calls over {} song IDs from {}",
+                     trace.events.size(), trace.shapes.size(), path.string());
+
+    Fixture fixture;
+    fixture.index->m_id = "replay";
+    fixture.index->m_name = "Replay";
+    for (uint32_t slot = 0; slot < trace.shapes.size(); slot++) {
+        if (trace.shapes[slot].present) {
+            fixture.nongs.emplace(
+                slot, makeNongs(s_baseSongID + static_cast<int>(slot),
+                                trace.shapes[slot], fixture));
+        }
+    }
+
+    LatencyRecorder& recorder = LatencyRecorder::get();
+    recorder.setForced(true);
+    recorder.clear();
+
+    // Keeps the replayed work from being optimized out
+    size_t checksum = 0;
+    for (size_t i = 0; i < trace.events.size(); i++) {
+        const TraceEvent& event = trace.events[i];
+
+        const auto start = std::chrono::steady_clock::now();
+        // The lookup is part of every hook
+        auto it = fixture.nongs.find(event.slot);
+        Nongs* nongs = it == fixture.nongs.end() ? nullptr : it->second.get();
+        checksum += replay(event, nongs, i);
+        const auto end = std::chrono::steady_clock::now();
+
+        recorder.record(fmt::format("replay.{}", opName(event.op)),
+                        end - start);
+        recorder.record(fmt::format("trace.{}", opName(event.op)),
+                        event.duration);
+    }
+
+    recorder.log();
+    recorder.setForced(false);
+    geode::log::debug("Replay checksum {}", checksum);
+    return geode::Ok();
+}
+
+}  // namespace jukebox
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include "Geode/Result.hpp"
+
+namespace jukebox {
+
+/**
+ * Most recently started trace in the traces folder, if any
+ */
+std::optional<std::filesystem::path> latestTrace();
+
+/**
+ * Runs the calls of a HookTrace recording back to back against synthetic
+ * Nongs shaped like the recorded manifest, without touching the real one.
+ * Replayed timings are logged through LatencyRecorder as replay.<call>,
+ * next to the recorded ones as trace.<call>.
+ *
+ * Runs at startup when the game is launched with the replay-trace launch
+ * flag.
+ */
+geode::Result<> replayTrace(const std::filesystem::path& path);
+
+}  // namespace jukebox
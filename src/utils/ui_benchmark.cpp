@@ -0,0 +1,135 @@
+#include "utils/ui_benchmark.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/core.h>
+#include "Geode/loader/Log.hpp"
+
+#include "index.hpp"
+#include "manifest_snapshot.hpp"
+#include "managers/latency_recorder.hpp"
+#include "nong.hpp"
+#include "song_path.hpp"
+#include "ui/list/nong_list_model.hpp"
+
+namespace jukebox {
+
+namespace {
+
+// Far away from anything GD or the manifest would use
+constexpr int s_songID = 2000000000;
+constexpr size_t s_iterations = 200;
+
+struct Fixture {
+    // Index songs point at it, so it must not move with the fixture
+    std::unique_ptr<index::IndexMetadata> index =
+        std::make_unique<index::IndexMetadata>();
+    std::vector<std::unique_ptr<index::IndexSongMetadata>> indexSongs;
+    std::unique_ptr<Nongs> nongs;
+    // Same as nongs, with one more stored song
+    std::unique_ptr<Nongs> grown;
+};
+
+std::unique_ptr<Nongs> makeNongs(size_t stored, Fixture& fixture) {
+    auto nongs = std::make_unique<Nongs>(
+        s_songID, LocalSong(SongMetadata(s_songID, "default", "Default song",
+                                         "RobTop"),
+                            SongPath(PathRoot::Songs, "default.mp3")));
+
+    for (size_t i = 0; i < stored; i++) {
+        (void)nongs->add(HostedSong(
+            SongMetadata(s_songID, fmt::format("stored-{}", i),
+                         fmt::format("Song {}", i), fmt::format("Artist {}", i)),
+            "https://example.com/song.mp3", std::nullopt,
+            SongPath(PathRoot::Nongs, fmt::format("stored-{}.mp3", i))));
+    }
+
+    for (auto& song : fixture.indexSongs) {
+        (void)nongs->registerIndexSong(song.get());
+    }
+
+    return nongs;
+}
+
+Fixture makeFixture(size_t stored, size_t indexSongs) {
+    Fixture fixture;
+    fixture.index->m_id = "benchmark";
+    fixture.index->m_name = "Benchmark";
+
+    for (size_t i = 0; i < indexSongs; i++) {
+        auto song = std::make_unique<index::IndexSongMetadata>();
+        song->uniqueID = fmt::format("index-{}", i);
+        song->name = fmt::format("Index song {}", i);
+        song->artist = fmt::format("Index artist {}", i);
+        song->url = "https://example.com/index.mp3";
+        song->songIDs = {s_songID};
+        song->parentID = fixture.index.get();
+        fixture.indexSongs.push_back(std::move(song));
+    }
+
+    fixture.nongs = makeNongs(stored, fixture);
+    fixture.grown = makeNongs(stored + 1, fixture);
+    return fixture;
+}
+
+template <class F>
+void measure(const std::string& flow, F&& work) {
+    for (size_t i = 0; i < s_iterations; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        work(i);
+        LatencyRecorder::get().record(
+            flow, std::chrono::steady_clock::now() - start);
+    }
+}
+
+}  // namespace
+
+void runUiBenchmark() {
+    geode::log::info("Running UI benchmark, {} iterations per flow",
+                     s_iterations);
+
+    LatencyRecorder& recorder = LatencyRecorder::get();
+    recorder.setForced(true);
+    recorder.clear();
+
+    // Same metrics as the popup's list
+    const NongListModel::Metrics metrics{60.f, 20.f, 5.f};
+
+    for (auto [stored, indexSongs] :
+         std::vector<std::pair<size_t, size_t>>{
+             {10, 10}, {100, 50}, {1000, 200}}) {
+        Fixture fixture = makeFixture(stored, indexSongs);
+        const std::string suffix =
+            fmt::format("[nongs={} index={}]", stored, indexSongs);
+
+        // What opening the popup does before any cell exists
+        measure("dropdown.open " + suffix, [&](size_t) {
+            NongListModel model(metrics);
+            model.buildNongs(fixture.nongs.get());
+        });
+
+        // A song getting added or removed while the popup is open
+        NongListModel model(metrics);
+        model.buildNongs(fixture.nongs.get());
+        measure("list.update " + suffix, [&](size_t i) {
+            Nongs* next =
+                i % 2 == 0 ? fixture.grown.get() : fixture.nongs.get();
+            (void)model.updateNongs(next);
+        });
+
+        // Publishing a song ID, done after every set-active
+        measure("set_active.snapshot " + suffix, [&](size_t i) {
+            (void)NongsSnapshot::from(*fixture.nongs, i);
+        });
+    }
+
+    recorder.log();
+    recorder.setForced(false);
+}
+
+}  // namespace jukebox
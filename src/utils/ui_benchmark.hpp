@@ -0,0 +1,14 @@
+#pragma once
+
+namespace jukebox {
+
+/**
+ * Times the work behind opening the nong popup, rebuilding its list and
+ * setting a song active, on synthetic song IDs that never touch the
+ * manifest. Results go to the log through LatencyRecorder.
+ *
+ * Runs at startup when the game is launched with the benchmark launch flag.
+ */
+void runUiBenchmark();
+
+}  // namespace jukebox
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Builds resources/index-snapshot.zip, the compiled copy of the default
+indexes that ships with the mod. Jukebox loads it for indexes it never
+fetched, so a fresh install has index songs before the first fetch ends.
+
+The archive isn't checked in. CI runs this before building, run it
+yourself before packaging a local build, it needs network access. Without
+the archive Jukebox skips the snapshot:
+
+    python3 tools/build_index_snapshot.py
+
+Pass JSON files instead of fetching with --from url=path.
+"""
+
+import argparse
+import json
+import os
+import sys
+import time
+import urllib.request
+import zipfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from index_to_binary import encode  # noqa: E402
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def default_urls():
+    with open(os.path.join(ROOT, "mod.json"), "r", encoding="utf-8") as f:
+        mod = json.load(f)
+    indexes = mod["settings"]["indexes"]["default"]
+    return [index["url"] for index in indexes if index.get("enabled", True)]
+
+
+def fetch(url):
+    request = urllib.request.Request(
+        url, headers={"User-Agent": "jukebox-snapshot"})
+    with urllib.request.urlopen(request, timeout=60) as response:
+        return json.load(response)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--from", dest="sources", action="append",
+                        default=[], metavar="URL=PATH",
+                        help="read an index from a file instead of its url")
+    parser.add_argument("--output",
+                        default=os.path.join(ROOT, "resources",
+                                             "index-snapshot.zip"))
+    args = parser.parse_args()
+
+    local = dict(source.split("=", 1) for source in args.sources)
+    entries = []
+
+    with zipfile.ZipFile(args.output, "w", zipfile.ZIP_DEFLATED,
+                         compresslevel=9) as archive:
+        for i, url in enumerate(default_urls()):
+            try:
+                if url in local:
+                    with open(local[url], "r", encoding="utf-8") as f:
+                        index = json.load(f)
+                else:
+                    index = fetch(url)
+                data, count = encode(index)
+            except Exception as e:
+                print(f"Skipping {url}: {e}", file=sys.stderr)
+                continue
+
+            name = f"{i}.jbix"
+            archive.writestr(name, data)
+            entries.append({"url": url, "file": name})
+            print(f"{url}: {count} songs, {len(data)} bytes")
+
+        archive.writestr("snapshot.json", json.dumps({
+            "created": int(time.time()),
+            "indexes": entries,
+        }, separators=(",", ":")))
+
+    # An empty snapshot would only make Jukebox look for indexes in vain
+    if not entries:
+        os.remove(args.output)
+        print("No index could be read, nothing written", file=sys.stderr)
+        return 1
+
+    print(f"Wrote {args.output} ({os.path.getsize(args.output)} bytes)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
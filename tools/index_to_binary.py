@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Converts a Jukebox index from JSON (manifest v1) to the binary index
+format (manifest v2), see src/index/binary_index.hpp for the layout.
+
+Serve the output with the "application/vnd.jukebox.index" content type, or
+under a url ending in ".jbix", and Jukebox will pick the binary decoder.
+
+    python3 tools/index_to_binary.py index.json index.jbix
+"""
+
+import argparse
+import json
+import os
+import sys
+from collections import Counter
+
+MAGIC = b"JBIX"
+MANIFEST = 2
+
+
+def varint(value):
+    if value < 0:
+        raise ValueError(f"varint can't be negative: {value}")
+    out = bytearray()
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80)
+        value >>= 7
+    out.append(value)
+    return bytes(out)
+
+
+def signed_varint(value):
+    return varint((value << 1) ^ (value >> 63))
+
+
+def encode(index):
+    if index.get("manifest") != 1:
+        raise ValueError("Only manifest v1 indexes can be converted")
+
+    metadata = {key: value for key, value in index.items() if key != "nongs"}
+    metadata.pop("manifest", None)
+    # The url is whatever the index gets fetched from
+    metadata.pop("url", None)
+
+    songs = []
+    hosted = index.get("nongs", {}).get("hosted", {})
+    for unique_id, song in hosted.items():
+        if "name" not in song or "artist" not in song:
+            print(f"Skipping {unique_id}: missing name or artist",
+                  file=sys.stderr)
+            continue
+        ids = sorted({i for i in song.get("songs", []) if isinstance(i, int)})
+        songs.append({
+            "id": unique_id,
+            "name": song["name"],
+            "artist": song["artist"],
+            "url": song.get("url"),
+            "offset": int(song.get("startOffset", 0)),
+            "ids": ids,
+        })
+
+    # Most used strings get the smallest indexes
+    counts = Counter()
+    for song in songs:
+        counts.update([song["id"], song["name"], song["artist"]])
+        if song["url"] is not None:
+            counts[song["url"]] += 1
+    strings = [string for string, _ in counts.most_common()]
+    lookup = {string: i for i, string in enumerate(strings)}
+
+    out = bytearray(MAGIC)
+    out.append(MANIFEST)
+
+    meta = json.dumps(metadata, separators=(",", ":")).encode()
+    out += varint(len(meta)) + meta
+
+    out += varint(len(strings))
+    for string in strings:
+        data = string.encode()
+        out += varint(len(data)) + data
+
+    out += varint(len(songs))
+    for key in ("id", "name", "artist"):
+        for song in songs:
+            out += varint(lookup[song[key]])
+    for song in songs:
+        out += varint(0 if song["url"] is None else lookup[song["url"]] + 1)
+    for song in songs:
+        out += signed_varint(song["offset"])
+    for song in songs:
+        out += varint(len(song["ids"]))
+    for song in songs:
+        previous = None
+        for i in song["ids"]:
+            if previous is None:
+                out += signed_varint(i)
+            else:
+                out += varint(i - previous)
+            previous = i
+
+    return bytes(out), len(songs)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="JSON index")
+    parser.add_argument("output", help="binary index to write")
+    args = parser.parse_args()
+
+    with open(args.input, "r", encoding="utf-8") as f:
+        index = json.load(f)
+
+    try:
+        data, count = encode(index)
+    except ValueError as e:
+        print(f"Couldn't convert {args.input}: {e}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(data)
+
+    before = os.path.getsize(args.input)
+    print(f"Wrote {count} songs, {before} -> {len(data)} bytes "
+          f"({before / max(len(data), 1):.1f}x smaller)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Local HTTP server for testing the index song link prober. Serves an
+index whose songs point at links that are alive, dead, slow, or hosted on
+servers that don't take HEAD requests.
+
+    python3 tools/link_probe_server.py --song-id 1234
+
+Add http://127.0.0.1:8000/index.json as an index, restart the game and open
+the song list of the given ID. Every request is logged, so the concurrency
+limit, the validators sent back and the range fallback can be checked
+here. The probe-index-links setting has to be on, it is by default.
+
+Once a HEAD request is turned down, Jukebox probes the rest of the host
+with range requests. Run with --head-only to leave out the songs that turn
+HEAD down and check the plain HEAD path.
+"""
+
+import argparse
+import json
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+SIZE = 3 * 1024 * 1024
+ETAG = '"jukebox-probe-1"'
+LAST_MODIFIED = "Sat, 01 Jan 2022 00:00:00 GMT"
+
+# Path -> what the song is expected to show up as
+SONGS = {
+    "alive": "size, 3.00MB",
+    "dead": "dead link (404)",
+    "gone": "dead link (410)",
+    "forbidden": "dead link (403)",
+    "no-head": "size through a range request",
+    "ignores-range": "size, the download is cancelled early",
+    "error": "host not responding (503)",
+    "rate-limited": "host not responding (429)",
+    "slow": "host not responding, times out",
+}
+
+
+def make_index(host, song_ids, head_only):
+    hosted = {}
+    for name, expected in SONGS.items():
+        if head_only and name in ("no-head", "ignores-range"):
+            continue
+        hosted[f"probe-{name}"] = {
+            "name": f"Probe {name}",
+            "artist": expected,
+            "url": f"{host}/{name}.mp3",
+            "songs": song_ids,
+        }
+    return {
+        "manifest": 1,
+        "id": "link-probe-test",
+        "name": "Link probe test",
+        "description": "Songs for testing the link prober",
+        "nongs": {"hosted": hosted},
+    }
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    index = b""
+
+    def log_message(self, fmt, *args):
+        extra = []
+        for header in ("Range", "If-None-Match", "If-Modified-Since"):
+            if self.headers.get(header):
+                extra.append(f"{header}: {self.headers[header]}")
+        print(f"{self.command} {self.path} {' '.join(extra)} -> "
+              f"{args[1] if len(args) > 1 else ''}", flush=True)
+
+    def send_empty(self, code, headers=None):
+        self.send_response(code)
+        for key, value in (headers or {}).items():
+            self.send_header(key, value)
+        self.send_header("Content-Length", "0")
+        self.end_headers()
+
+    def send_song(self, body, partial=False):
+        self.send_response(206 if partial else 200)
+        self.send_header("Content-Type", "audio/mpeg")
+        self.send_header("ETag", ETAG)
+        self.send_header("Last-Modified", LAST_MODIFIED)
+        if partial:
+            self.send_header("Content-Range", f"bytes 0-0/{SIZE}")
+            self.send_header("Content-Length", "1")
+        else:
+            self.send_header("Content-Length", str(SIZE))
+        self.end_headers()
+        if self.command == "GET":
+            self.wfile.write(body)
+
+    def handle_song(self, name):
+        if name == "alive":
+            if self.headers.get("If-None-Match") == ETAG:
+                return self.send_empty(304, {"ETag": ETAG})
+            if self.command == "HEAD":
+                return self.send_song(b"")
+            if self.headers.get("Range"):
+                return self.send_song(b"\0", partial=True)
+            return self.send_song(bytes(SIZE))
+        if name == "dead":
+            return self.send_empty(404)
+        if name == "gone":
+            return self.send_empty(410)
+        if name == "forbidden":
+            return self.send_empty(403)
+        if name == "error":
+            return self.send_empty(503)
+        if name == "rate-limited":
+            return self.send_empty(429, {"Retry-After": "60"})
+        if name == "slow":
+            time.sleep(20)
+            return self.send_empty(200)
+        if name in ("no-head", "ignores-range"):
+            if self.command == "HEAD":
+                return self.send_empty(405, {"Allow": "GET"})
+            if name == "no-head" and self.headers.get("Range"):
+                return self.send_song(b"\0", partial=True)
+            return self.send_song(bytes(SIZE))
+        return self.send_empty(404)
+
+    def route(self):
+        path = self.path.split("?")[0]
+        if path == "/index.json":
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(self.index)))
+            self.end_headers()
+            if self.command == "GET":
+                self.wfile.write(self.index)
+            return
+        if path.startswith("/") and path.endswith(".mp3"):
+            return self.handle_song(path[1:-len(".mp3")])
+        self.send_empty(404)
+
+    def do_HEAD(self):
+        self.route()
+
+    def do_GET(self):
+        try:
+            self.route()
+        except (BrokenPipeError, ConnectionResetError):
+            # The prober hangs up on hosts that ignore the range
+            print(f"{self.command} {self.path} cancelled by the client",
+                  flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--song-id", type=int, action="append",
+                        help="song ID the test songs are for, repeatable")
+    parser.add_argument("--head-only", action="store_true",
+                        help="only serve songs that answer HEAD requests")
+    args = parser.parse_args()
+
+    host = f"http://127.0.0.1:{args.port}"
+    song_ids = args.song_id or [1]
+    index = make_index(host, song_ids, args.head_only)
+    Handler.index = json.dumps(index).encode()
+
+    print(f"Index at {host}/index.json for song IDs {song_ids}", flush=True)
+    ThreadingHTTPServer(("127.0.0.1", args.port), Handler).serve_forever()
+
+
+if __name__ == "__main__":
+    main()